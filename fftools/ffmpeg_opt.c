@@ -494,6 +494,27 @@ static int opt_sdp_file(void *optctx, const char *opt, const char *arg)
     return sch_sdp_filename(sch, arg);
 }
 
+static int opt_sched_mutex_queues(void *optctx, const char *opt, const char *arg)
+{
+    Scheduler *sch = optctx;
+    sch_use_mutex_queues(sch);
+    return 0;
+}
+
+static int opt_sched_pool(void *optctx, const char *opt, const char *arg)
+{
+    Scheduler *sch = optctx;
+    double num;
+    int ret;
+
+    ret = parse_number(opt, arg, OPT_TYPE_INT, 0, INT_MAX, &num);
+    if (ret < 0)
+        return ret;
+
+    sch_pool_size(sch, num);
+    return 0;
+}
+
 #if CONFIG_VAAPI
 static int opt_vaapi_device(void *optctx, const char *opt, const char *arg)
 {
@@ -1579,6 +1600,12 @@ const OptionDef options[] = {
     { "stats",               OPT_TYPE_BOOL, 0,
         { &print_stats },
         "print progress report during encoding", },
+    { "sched_mutex_queues",  OPT_TYPE_FUNC, OPT_EXPERT,
+        { .func_arg = opt_sched_mutex_queues },
+        "use mutex-protected queues between threads instead of lock-free ones" },
+    { "sched_pool",          OPT_TYPE_FUNC, OPT_FUNC_ARG | OPT_EXPERT,
+        { .func_arg = opt_sched_pool },
+        "limit the number of decoding, filtering and encoding threads running at the same time", "count" },
     { "stats_period",        OPT_TYPE_FUNC, OPT_FUNC_ARG | OPT_EXPERT,
         { .func_arg = opt_stats_period },
         "set the period at which ffmpeg updates stats and -progress output", "time" },
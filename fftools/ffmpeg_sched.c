@@ -298,6 +298,16 @@ struct Scheduler {
     char               *sdp_filename;
     int                 sdp_auto;
 
+    enum ThreadQueueType queue_type;
+
+    // maximum number of decoding, filtering and encoding tasks that may run
+    // at the same time, 0 for no limit
+    unsigned            pool_size;
+    // number of such tasks currently running, protected by pool_lock
+    unsigned            pool_running;
+    pthread_mutex_t     pool_lock;
+    pthread_cond_t      pool_cond;
+
     enum SchedulerState state;
     atomic_int          terminate;
     atomic_int          task_failed;
@@ -332,6 +342,53 @@ static int waiter_wait(Scheduler *sch, SchWaiter *w)
     return terminate;
 }
 
+/**
+ * Wait until a slot in the task pool is available and take it.
+ */
+static void pool_enter(Scheduler *sch)
+{
+    if (!sch->pool_size)
+        return;
+
+    pthread_mutex_lock(&sch->pool_lock);
+
+    while (sch->pool_running >= sch->pool_size)
+        pthread_cond_wait(&sch->pool_cond, &sch->pool_lock);
+    sch->pool_running++;
+
+    pthread_mutex_unlock(&sch->pool_lock);
+}
+
+/**
+ * Give up the task pool slot held by the caller, must be done before anything
+ * that may block waiting for another task.
+ */
+static void pool_leave(Scheduler *sch)
+{
+    if (!sch->pool_size)
+        return;
+
+    pthread_mutex_lock(&sch->pool_lock);
+
+    av_assert0(sch->pool_running > 0);
+    sch->pool_running--;
+    pthread_cond_signal(&sch->pool_cond);
+
+    pthread_mutex_unlock(&sch->pool_lock);
+}
+
+/**
+ * Demuxers and muxers spend most of their time in I/O and are what
+ * eventually unblocks all the other tasks, so they are not limited by the
+ * task pool.
+ */
+static int pool_node(SchedulerNode node)
+{
+    return node.type == SCH_NODE_TYPE_DEC ||
+           node.type == SCH_NODE_TYPE_ENC ||
+           node.type == SCH_NODE_TYPE_FILTER_IN;
+}
+
 static void waiter_set(SchWaiter *w, int choked)
 {
     pthread_mutex_lock(&w->lock);
@@ -365,8 +422,8 @@ static void waiter_uninit(SchWaiter *w)
     pthread_cond_destroy(&w->cond);
 }
 
-static int queue_alloc(ThreadQueue **ptq, unsigned nb_streams, unsigned queue_size,
-                       enum QueueType type)
+static int queue_alloc(Scheduler *sch, ThreadQueue **ptq, unsigned nb_streams,
+                       unsigned queue_size, enum QueueType type)
 {
     ThreadQueue *tq;
     ObjPool *op;
@@ -393,7 +450,8 @@ static int queue_alloc(ThreadQueue **ptq, unsigned nb_streams, unsigned queue_si
         return AVERROR(ENOMEM);
 
     tq = tq_alloc(nb_streams, queue_size, op,
-                  (type == QUEUE_PACKETS) ? pkt_move : frame_move);
+                  (type == QUEUE_PACKETS) ? pkt_move : frame_move,
+                  sch->queue_type);
     if (!tq) {
         objpool_free(&op);
         return AVERROR(ENOMEM);
@@ -562,6 +620,9 @@ void sch_free(Scheduler **psch)
     pthread_mutex_destroy(&sch->mux_done_lock);
     pthread_cond_destroy(&sch->mux_done_cond);
 
+    pthread_mutex_destroy(&sch->pool_lock);
+    pthread_cond_destroy(&sch->pool_cond);
+
     av_freep(psch);
 }
 
@@ -579,8 +640,9 @@ Scheduler *sch_alloc(void)
     if (!sch)
         return NULL;
 
-    sch->class    = &scheduler_class;
-    sch->sdp_auto = 1;
+    sch->class      = &scheduler_class;
+    sch->sdp_auto   = 1;
+    sch->queue_type = THREAD_QUEUE_RING;
 
     ret = pthread_mutex_init(&sch->schedule_lock, NULL);
     if (ret)
@@ -598,6 +660,14 @@ Scheduler *sch_alloc(void)
     if (ret)
         goto fail;
 
+    ret = pthread_mutex_init(&sch->pool_lock, NULL);
+    if (ret)
+        goto fail;
+
+    ret = pthread_cond_init(&sch->pool_cond, NULL);
+    if (ret)
+        goto fail;
+
     return sch;
 fail:
     sch_free(&sch);
@@ -611,6 +681,19 @@ int sch_sdp_filename(Scheduler *sch, const char *sdp_filename)
     return sch->sdp_filename ? 0 : AVERROR(ENOMEM);
 }
 
+void sch_use_mutex_queues(Scheduler *sch)
+{
+    av_assert0(sch->state == SCH_STATE_UNINIT && !sch->nb_dec &&
+               !sch->nb_enc && !sch->nb_filters);
+    sch->queue_type = THREAD_QUEUE_MUTEX;
+}
+
+void sch_pool_size(Scheduler *sch, unsigned pool_size)
+{
+    av_assert0(sch->state == SCH_STATE_UNINIT);
+    sch->pool_size = pool_size;
+}
+
 static const AVClass sch_mux_class = {
     .class_name                = "SchMux",
     .version                   = LIBAVUTIL_VERSION_INT,
@@ -739,7 +822,7 @@ int sch_add_dec(Scheduler *sch, SchThreadFunc func, void *ctx,
     if (!dec->send_frame)
         return AVERROR(ENOMEM);
 
-    ret = queue_alloc(&dec->queue, 1, 0, QUEUE_PACKETS);
+    ret = queue_alloc(sch, &dec->queue, 1, 0, QUEUE_PACKETS);
     if (ret < 0)
         return ret;
 
@@ -783,7 +866,7 @@ int sch_add_enc(Scheduler *sch, SchThreadFunc func, void *ctx,
     if (!enc->send_pkt)
         return AVERROR(ENOMEM);
 
-    ret = queue_alloc(&enc->queue, 1, 0, QUEUE_FRAMES);
+    ret = queue_alloc(sch, &enc->queue, 1, 0, QUEUE_FRAMES);
     if (ret < 0)
         return ret;
 
@@ -831,7 +914,7 @@ int sch_add_filtergraph(Scheduler *sch, unsigned nb_inputs, unsigned nb_outputs,
     if (ret < 0)
         return ret;
 
-    ret = queue_alloc(&fg->queue, fg->nb_inputs + 1, 0, QUEUE_FRAMES);
+    ret = queue_alloc(sch, &fg->queue, fg->nb_inputs + 1, 0, QUEUE_FRAMES);
     if (ret < 0)
         return ret;
 
@@ -1466,7 +1549,7 @@ static int start_prepare(Scheduler *sch)
             }
         }
 
-        ret = queue_alloc(&mux->queue, mux->nb_streams, mux->queue_size,
+        ret = queue_alloc(sch, &mux->queue, mux->nb_streams, mux->queue_size,
                           QUEUE_PACKETS);
         if (ret < 0)
             return ret;
@@ -2099,7 +2182,9 @@ int sch_dec_receive(Scheduler *sch, unsigned dec_idx, AVPacket *pkt)
         dec->expect_end_ts = 0;
     }
 
+    pool_leave(sch);
     ret = tq_receive(dec->queue, &dummy, pkt);
+    pool_enter(sch);
     av_assert0(dummy <= 0);
 
     // got a flush packet, on the next call to this function the decoder
@@ -2182,7 +2267,9 @@ int sch_dec_send(Scheduler *sch, unsigned dec_idx, AVFrame *frame)
                 return ret;
         }
 
+        pool_leave(sch);
         ret = dec_send_to_dst(sch, dec->dst[i], finished, to_send);
+        pool_enter(sch);
         if (ret < 0) {
             av_frame_unref(to_send);
             if (ret == AVERROR_EOF) {
@@ -2226,7 +2313,9 @@ int sch_enc_receive(Scheduler *sch, unsigned enc_idx, AVFrame *frame)
     av_assert0(enc_idx < sch->nb_enc);
     enc = &sch->enc[enc_idx];
 
+    pool_leave(sch);
     ret = tq_receive(enc->queue, &dummy, frame);
+    pool_enter(sch);
     av_assert0(dummy <= 0);
 
     return ret;
@@ -2283,7 +2372,9 @@ int sch_enc_send(Scheduler *sch, unsigned enc_idx, AVPacket *pkt)
                 return ret;
         }
 
+        pool_leave(sch);
         ret = enc_send_to_dst(sch, enc->dst[i], finished, to_send);
+        pool_enter(sch);
         if (ret < 0) {
             av_packet_unref(to_send);
             if (ret == AVERROR_EOF) {
@@ -2337,14 +2428,21 @@ int sch_filter_receive(Scheduler *sch, unsigned fg_idx,
     }
 
     if (*in_idx == fg->nb_inputs) {
-        int terminate = waiter_wait(sch, &fg->waiter);
+        int terminate;
+
+        pool_leave(sch);
+        terminate = waiter_wait(sch, &fg->waiter);
+        pool_enter(sch);
+
         return terminate ? AVERROR_EOF : AVERROR(EAGAIN);
     }
 
     while (1) {
         int ret, idx;
 
+        pool_leave(sch);
         ret = tq_receive(fg->queue, &idx, frame);
+        pool_enter(sch);
         if (idx < 0)
             return AVERROR_EOF;
         else if (ret >= 0) {
@@ -2381,12 +2479,18 @@ void sch_filter_receive_finish(Scheduler *sch, unsigned fg_idx, unsigned in_idx)
 int sch_filter_send(Scheduler *sch, unsigned fg_idx, unsigned out_idx, AVFrame *frame)
 {
     SchFilterGraph *fg;
+    int ret;
 
     av_assert0(fg_idx < sch->nb_filters);
     fg = &sch->filters[fg_idx];
 
     av_assert0(out_idx < fg->nb_outputs);
-    return send_to_enc(sch, &sch->enc[fg->outputs[out_idx].dst.idx], frame);
+
+    pool_leave(sch);
+    ret = send_to_enc(sch, &sch->enc[fg->outputs[out_idx].dst.idx], frame);
+    pool_enter(sch);
+
+    return ret;
 }
 
 static int filter_done(Scheduler *sch, unsigned fg_idx)
@@ -2444,7 +2548,14 @@ static void *task_wrapper(void *arg)
     int ret;
     int err = 0;
 
+    if (pool_node(task->node))
+        pool_enter(sch);
+
     ret = task->func(task->func_arg);
+
+    if (pool_node(task->node))
+        pool_leave(sch);
+
     if (ret < 0)
         av_log(task->func_arg, AV_LOG_ERROR,
                "Task finished with error code: %d (%s)\n", ret, av_err2str(ret));
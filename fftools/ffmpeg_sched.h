@@ -284,6 +284,25 @@ int sch_mux_stream_ready(Scheduler *sch, unsigned mux_idx, unsigned stream_idx);
  */
 int sch_sdp_filename(Scheduler *sch, const char *sdp_filename);
 
+/**
+ * Use mutex-protected FIFOs for all the inter-thread queues, instead of the
+ * default lock-free ring buffers.
+ *
+ * Must be called before any decoders, encoders or filtergraphs are added.
+ */
+void sch_use_mutex_queues(Scheduler *sch);
+
+/**
+ * Limit the number of decoder, filtergraph and encoder tasks that may be
+ * running at the same time. Tasks that are blocked waiting for input or for
+ * space in their destination queues do not count towards the limit.
+ *
+ * Must be called before sch_start().
+ *
+ * @param pool_size maximum number of running tasks, 0 for no limit (default)
+ */
+void sch_pool_size(Scheduler *sch, unsigned pool_size);
+
 /**
  * Add an encoder to the scheduler.
  *
@@ -16,6 +16,7 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <stdatomic.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -23,12 +24,19 @@
 #include "libavutil/error.h"
 #include "libavutil/fifo.h"
 #include "libavutil/intreadwrite.h"
+#include "libavutil/macros.h"
 #include "libavutil/mem.h"
 #include "libavutil/thread.h"
 
 #include "objpool.h"
 #include "thread_queue.h"
 
+/**
+ * Number of slots the receiver frees before waking up senders sleeping on a
+ * full ring, unless the ring is drained before that.
+ */
+#define RING_WAKE_BATCH 4
+
 enum {
     FINISHED_SEND = (1 << 0),
     FINISHED_RECV = (1 << 1),
@@ -39,17 +47,49 @@ typedef struct FifoElem {
     unsigned int stream_idx;
 } FifoElem;
 
+/**
+ * A slot in the lock-free ring.
+ *
+ * seq is the position at which the slot may next be written (seq == pos),
+ * or read (seq == pos + 1); the payload object is allocated once and lives
+ * in the slot for the whole lifetime of the queue.
+ */
+typedef struct RingSlot {
+    atomic_size_t seq;
+    void         *obj;
+    unsigned int  stream_idx;
+} RingSlot;
+
 struct ThreadQueue {
-    int              *finished;
+    atomic_int       *finished;
     unsigned int    nb_streams;
 
+    enum ThreadQueueType type;
+
+    // THREAD_QUEUE_MUTEX only
     AVFifo  *fifo;
 
+    // THREAD_QUEUE_RING only
+    RingSlot    *slots;
+    size_t    nb_slots;
+    // position of the next write, shared by all the sending threads
+    atomic_size_t tail;
+    // position of the next read, only accessed by the receiving thread
+    size_t        head;
+    // slots freed since senders were last woken up, and the number of slots
+    // after which they are woken up; only accessed by the receiving thread
+    size_t        freed;
+    size_t        wake_batch;
+    // number of threads sleeping on cond_send/cond
+    atomic_int    send_waiting;
+    atomic_int    recv_waiting;
+
     ObjPool *obj_pool;
     void   (*obj_move)(void *dst, void *src);
 
     pthread_mutex_t lock;
     pthread_cond_t  cond;
+    pthread_cond_t  cond_send;
 };
 
 void tq_free(ThreadQueue **ptq)
@@ -66,18 +106,48 @@ void tq_free(ThreadQueue **ptq)
     }
     av_fifo_freep2(&tq->fifo);
 
+    if (tq->slots) {
+        for (size_t i = 0; i < tq->nb_slots; i++)
+            objpool_release(tq->obj_pool, &tq->slots[i].obj);
+    }
+    av_freep(&tq->slots);
+
     objpool_free(&tq->obj_pool);
 
     av_freep(&tq->finished);
 
+    pthread_cond_destroy(&tq->cond_send);
     pthread_cond_destroy(&tq->cond);
     pthread_mutex_destroy(&tq->lock);
 
     av_freep(ptq);
 }
 
+static int ring_alloc(ThreadQueue *tq, size_t queue_size)
+{
+    tq->slots = av_calloc(queue_size, sizeof(*tq->slots));
+    if (!tq->slots)
+        return AVERROR(ENOMEM);
+    tq->nb_slots   = queue_size;
+    tq->wake_batch = FFMIN(RING_WAKE_BATCH, FFMAX(queue_size / 2, 1));
+
+    for (size_t i = 0; i < queue_size; i++) {
+        int ret = objpool_get(tq->obj_pool, &tq->slots[i].obj);
+        if (ret < 0)
+            return ret;
+        atomic_init(&tq->slots[i].seq, i);
+    }
+
+    atomic_init(&tq->tail,         0);
+    atomic_init(&tq->send_waiting, 0);
+    atomic_init(&tq->recv_waiting, 0);
+
+    return 0;
+}
+
 ThreadQueue *tq_alloc(unsigned int nb_streams, size_t queue_size,
-                      ObjPool *obj_pool, void (*obj_move)(void *dst, void *src))
+                      ObjPool *obj_pool, void (*obj_move)(void *dst, void *src),
+                      enum ThreadQueueType type)
 {
     ThreadQueue *tq;
     int ret;
@@ -92,8 +162,16 @@ ThreadQueue *tq_alloc(unsigned int nb_streams, size_t queue_size,
         return NULL;
     }
 
+    ret = pthread_cond_init(&tq->cond_send, NULL);
+    if (ret) {
+        pthread_cond_destroy(&tq->cond);
+        av_freep(&tq);
+        return NULL;
+    }
+
     ret = pthread_mutex_init(&tq->lock, NULL);
     if (ret) {
+        pthread_cond_destroy(&tq->cond_send);
         pthread_cond_destroy(&tq->cond);
         av_freep(&tq);
         return NULL;
@@ -103,41 +181,54 @@ ThreadQueue *tq_alloc(unsigned int nb_streams, size_t queue_size,
     if (!tq->finished)
         goto fail;
     tq->nb_streams = nb_streams;
-
-    tq->fifo = av_fifo_alloc2(queue_size, sizeof(FifoElem), 0);
-    if (!tq->fifo)
-        goto fail;
+    for (unsigned int i = 0; i < nb_streams; i++)
+        atomic_init(&tq->finished[i], 0);
 
     tq->obj_pool = obj_pool;
     tq->obj_move = obj_move;
+    tq->type     = type;
+
+    if (type == THREAD_QUEUE_RING) {
+        ret = ring_alloc(tq, queue_size);
+        if (ret < 0)
+            goto fail;
+    } else {
+        tq->fifo = av_fifo_alloc2(queue_size, sizeof(FifoElem), 0);
+        if (!tq->fifo)
+            goto fail;
+    }
 
     return tq;
 fail:
+    // the caller retains ownership of the pool on failure
+    if (tq->slots) {
+        for (size_t i = 0; i < tq->nb_slots; i++)
+            objpool_release(obj_pool, &tq->slots[i].obj);
+        av_freep(&tq->slots);
+    }
+    tq->obj_pool = NULL;
     tq_free(&tq);
     return NULL;
 }
 
-int tq_send(ThreadQueue *tq, unsigned int stream_idx, void *data)
+static int mutex_send(ThreadQueue *tq, unsigned int stream_idx, void *data)
 {
-    int *finished;
+    atomic_int *finished = &tq->finished[stream_idx];
     int ret;
 
-    av_assert0(stream_idx < tq->nb_streams);
-    finished = &tq->finished[stream_idx];
-
     pthread_mutex_lock(&tq->lock);
 
-    if (*finished & FINISHED_SEND) {
+    if (atomic_load(finished) & FINISHED_SEND) {
         ret = AVERROR(EINVAL);
         goto finish;
     }
 
-    while (!(*finished & FINISHED_RECV) && !av_fifo_can_write(tq->fifo))
+    while (!(atomic_load(finished) & FINISHED_RECV) && !av_fifo_can_write(tq->fifo))
         pthread_cond_wait(&tq->cond, &tq->lock);
 
-    if (*finished & FINISHED_RECV) {
+    if (atomic_load(finished) & FINISHED_RECV) {
         ret = AVERROR_EOF;
-        *finished |= FINISHED_SEND;
+        atomic_fetch_or(finished, FINISHED_SEND);
     } else {
         FifoElem elem = { .stream_idx = stream_idx };
 
@@ -158,32 +249,144 @@ finish:
     return ret;
 }
 
-static int receive_locked(ThreadQueue *tq, int *stream_idx,
-                          void *data)
+static int ring_full(ThreadQueue *tq)
 {
-    FifoElem elem;
-    unsigned int nb_finished = 0;
+    size_t    pos = atomic_load(&tq->tail);
+    RingSlot *slot = &tq->slots[pos % tq->nb_slots];
 
-    while (av_fifo_read(tq->fifo, &elem, 1) >= 0) {
-        if (tq->finished[elem.stream_idx] & FINISHED_RECV) {
-            objpool_release(tq->obj_pool, &elem.obj);
+    return atomic_load(&slot->seq) != pos;
+}
+
+static int ring_empty(ThreadQueue *tq)
+{
+    RingSlot *slot = &tq->slots[tq->head % tq->nb_slots];
+
+    return atomic_load(&slot->seq) != tq->head + 1;
+}
+
+/**
+ * @return 1 if every claimed slot has been consumed, which unlike
+ *         !ring_empty() also covers slots claimed but not yet published
+ */
+static int ring_drained(ThreadQueue *tq)
+{
+    return atomic_load(&tq->tail) == tq->head;
+}
+
+/**
+ * Claim the next free slot for writing.
+ *
+ * @return the claimed slot, or NULL if the ring is full
+ */
+static RingSlot *ring_claim(ThreadQueue *tq, size_t *ppos)
+{
+    size_t pos = atomic_load_explicit(&tq->tail, memory_order_relaxed);
+
+    while (1) {
+        RingSlot *slot = &tq->slots[pos % tq->nb_slots];
+        size_t    seq  = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        intptr_t  diff = (intptr_t)(seq - pos);
+
+        if (diff < 0)
+            return NULL;
+
+        if (diff > 0) {
+            // another sender claimed this slot, retry with the updated tail
+            pos = atomic_load_explicit(&tq->tail, memory_order_relaxed);
             continue;
         }
 
-        tq->obj_move(data, elem.obj);
-        objpool_release(tq->obj_pool, &elem.obj);
-        *stream_idx = elem.stream_idx;
-        return 0;
+        if (atomic_compare_exchange_weak_explicit(&tq->tail, &pos, pos + 1,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+            *ppos = pos;
+            return slot;
+        }
+    }
+}
+
+static int ring_send(ThreadQueue *tq, unsigned int stream_idx, void *data)
+{
+    atomic_int *finished = &tq->finished[stream_idx];
+    RingSlot *slot;
+    size_t    pos;
+
+    if (atomic_load(finished) & FINISHED_SEND)
+        return AVERROR(EINVAL);
+
+    while (1) {
+        if (atomic_load(finished) & FINISHED_RECV) {
+            atomic_fetch_or(finished, FINISHED_SEND);
+            return AVERROR_EOF;
+        }
+
+        slot = ring_claim(tq, &pos);
+        if (slot)
+            break;
+
+        /* The ring is full, sleep until the receiver frees a slot.
+         * send_waiting must be raised before re-checking the ring state, so
+         * that the receiver is guaranteed to either see it or leave a slot
+         * free for us to find. */
+        pthread_mutex_lock(&tq->lock);
+        atomic_fetch_add(&tq->send_waiting, 1);
+        while (ring_full(tq) && !(atomic_load(finished) & FINISHED_RECV))
+            pthread_cond_wait(&tq->cond_send, &tq->lock);
+        atomic_fetch_sub(&tq->send_waiting, 1);
+        pthread_mutex_unlock(&tq->lock);
+    }
+
+    tq->obj_move(slot->obj, data);
+    slot->stream_idx = stream_idx;
+    atomic_store(&slot->seq, pos + 1);
+
+    // only wake the receiver on the empty->non-empty transition, i.e. when
+    // it has actually gone to sleep, and only from the first sender to
+    // publish an item after that
+    if (atomic_exchange(&tq->recv_waiting, 0)) {
+        pthread_mutex_lock(&tq->lock);
+        pthread_cond_signal(&tq->cond);
+        pthread_mutex_unlock(&tq->lock);
     }
 
+    return 0;
+}
+
+int tq_send(ThreadQueue *tq, unsigned int stream_idx, void *data)
+{
+    av_assert0(stream_idx < tq->nb_streams);
+
+    return tq->type == THREAD_QUEUE_RING ? ring_send (tq, stream_idx, data) :
+                                           mutex_send(tq, stream_idx, data);
+}
+
+/**
+ * Check the finished flags of all streams, must be called when no data
+ * items are available.
+ *
+ * @return AVERROR_EOF with the same semantics as tq_receive(),
+ *         AVERROR(EAGAIN) if the caller should wait for more data
+ */
+static int receive_finished(ThreadQueue *tq, int *stream_idx)
+{
+    unsigned int nb_finished = 0;
+
     for (unsigned int i = 0; i < tq->nb_streams; i++) {
-        if (!tq->finished[i])
+        int finished = atomic_load(&tq->finished[i]);
+
+        if (!finished)
             continue;
 
         /* return EOF to the consumer at most once for each stream */
-        if (!(tq->finished[i] & FINISHED_RECV)) {
-            tq->finished[i] |= FINISHED_RECV;
-            *stream_idx   = i;
+        if (!(finished & FINISHED_RECV)) {
+            /* the sender claimed all its slots before marking the stream
+             * finished, but another sender may still be filling a slot
+             * before them, so wait until the ring is fully consumed */
+            if (tq->type == THREAD_QUEUE_RING && !ring_drained(tq))
+                return AVERROR(EAGAIN);
+
+            atomic_fetch_or(&tq->finished[i], FINISHED_RECV);
+            *stream_idx = i;
             return AVERROR_EOF;
         }
 
@@ -193,11 +396,29 @@ static int receive_locked(ThreadQueue *tq, int *stream_idx,
     return nb_finished == tq->nb_streams ? AVERROR_EOF : AVERROR(EAGAIN);
 }
 
-int tq_receive(ThreadQueue *tq, int *stream_idx, void *data)
+static int receive_locked(ThreadQueue *tq, int *stream_idx,
+                          void *data)
 {
-    int ret;
+    FifoElem elem;
 
-    *stream_idx = -1;
+    while (av_fifo_read(tq->fifo, &elem, 1) >= 0) {
+        if (atomic_load(&tq->finished[elem.stream_idx]) & FINISHED_RECV) {
+            objpool_release(tq->obj_pool, &elem.obj);
+            continue;
+        }
+
+        tq->obj_move(data, elem.obj);
+        objpool_release(tq->obj_pool, &elem.obj);
+        *stream_idx = elem.stream_idx;
+        return 0;
+    }
+
+    return receive_finished(tq, stream_idx);
+}
+
+static int mutex_receive(ThreadQueue *tq, int *stream_idx, void *data)
+{
+    int ret;
 
     pthread_mutex_lock(&tq->lock);
 
@@ -223,6 +444,88 @@ int tq_receive(ThreadQueue *tq, int *stream_idx, void *data)
     return ret;
 }
 
+static int ring_read(ThreadQueue *tq, int *stream_idx, void *data)
+{
+    while (!ring_empty(tq)) {
+        RingSlot *slot = &tq->slots[tq->head % tq->nb_slots];
+        int discard    = atomic_load(&tq->finished[slot->stream_idx]) & FINISHED_RECV;
+
+        if (discard) {
+            // the object stays in the slot, so this cannot fail
+            objpool_release(tq->obj_pool, &slot->obj);
+            objpool_get(tq->obj_pool, &slot->obj);
+        } else {
+            tq->obj_move(data, slot->obj);
+            *stream_idx = slot->stream_idx;
+        }
+
+        atomic_store(&slot->seq, tq->head + tq->nb_slots);
+        tq->head++;
+
+        /* Senders sleeping on a full ring are woken up in batches, once a
+         * few slots are free. They must be woken up at the latest when the
+         * ring is drained, as we might go to sleep waiting for them then. */
+        if (!atomic_load(&tq->send_waiting)) {
+            tq->freed = 0;
+        } else if (++tq->freed >= tq->wake_batch || ring_empty(tq)) {
+            tq->freed = 0;
+            pthread_mutex_lock(&tq->lock);
+            pthread_cond_broadcast(&tq->cond_send);
+            pthread_mutex_unlock(&tq->lock);
+        }
+
+        if (!discard)
+            return 0;
+    }
+
+    return AVERROR(EAGAIN);
+}
+
+static int finished_pending(ThreadQueue *tq)
+{
+    for (unsigned int i = 0; i < tq->nb_streams; i++)
+        if (atomic_load(&tq->finished[i]) == FINISHED_SEND)
+            return 1;
+    return 0;
+}
+
+static int ring_receive(ThreadQueue *tq, int *stream_idx, void *data)
+{
+    int ret;
+
+    while (1) {
+        ret = ring_read(tq, stream_idx, data);
+        if (ret != AVERROR(EAGAIN))
+            return ret;
+
+        ret = receive_finished(tq, stream_idx);
+        if (ret != AVERROR(EAGAIN))
+            return ret;
+
+        /* Nothing to return, sleep until a sender publishes an item or
+         * finishes a stream. recv_waiting must be raised before re-checking
+         * the ring state, see ring_send(), and again after every wakeup, as
+         * the sender that woke us up cleared it. */
+        pthread_mutex_lock(&tq->lock);
+        while (1) {
+            atomic_store(&tq->recv_waiting, 1);
+            if (!ring_empty(tq) || (finished_pending(tq) && ring_drained(tq)))
+                break;
+            pthread_cond_wait(&tq->cond, &tq->lock);
+        }
+        atomic_store(&tq->recv_waiting, 0);
+        pthread_mutex_unlock(&tq->lock);
+    }
+}
+
+int tq_receive(ThreadQueue *tq, int *stream_idx, void *data)
+{
+    *stream_idx = -1;
+
+    return tq->type == THREAD_QUEUE_RING ? ring_receive (tq, stream_idx, data) :
+                                           mutex_receive(tq, stream_idx, data);
+}
+
 void tq_send_finish(ThreadQueue *tq, unsigned int stream_idx)
 {
     av_assert0(stream_idx < tq->nb_streams);
@@ -232,7 +535,7 @@ void tq_send_finish(ThreadQueue *tq, unsigned int stream_idx)
     /* mark the stream as send-finished;
      * next time the consumer thread tries to read this stream it will get
      * an EOF and recv-finished flag will be set */
-    tq->finished[stream_idx] |= FINISHED_SEND;
+    atomic_fetch_or(&tq->finished[stream_idx], FINISHED_SEND);
     pthread_cond_broadcast(&tq->cond);
 
     pthread_mutex_unlock(&tq->lock);
@@ -247,8 +550,9 @@ void tq_receive_finish(ThreadQueue *tq, unsigned int stream_idx)
     /* mark the stream as recv-finished;
      * next time the producer thread tries to send for this stream, it will
      * get an EOF and send-finished flag will be set */
-    tq->finished[stream_idx] |= FINISHED_RECV;
+    atomic_fetch_or(&tq->finished[stream_idx], FINISHED_RECV);
     pthread_cond_broadcast(&tq->cond);
+    pthread_cond_broadcast(&tq->cond_send);
 
     pthread_mutex_unlock(&tq->lock);
 }
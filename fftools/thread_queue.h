@@ -25,6 +25,19 @@
 
 typedef struct ThreadQueue ThreadQueue;
 
+enum ThreadQueueType {
+    /**
+     * Lock-free ring buffer with preallocated items. Any number of threads may
+     * send, but only a single thread may receive. The mutex is only taken
+     * when one side has to sleep waiting for the other, or to wake it up.
+     */
+    THREAD_QUEUE_RING,
+    /**
+     * FIFO protected by a mutex, taken for every send and receive.
+     */
+    THREAD_QUEUE_MUTEX,
+};
+
 /**
  * Allocate a queue for sending data between threads.
  *
@@ -35,9 +48,11 @@ typedef struct ThreadQueue ThreadQueue;
  * @param obj_pool object pool that will be used to allocate items stored in the
  *                 queue; the pool becomes owned by the queue
  * @param callback that moves the contents between two data pointers
+ * @param type queue implementation to use
  */
 ThreadQueue *tq_alloc(unsigned int nb_streams, size_t queue_size,
-                      ObjPool *obj_pool, void (*obj_move)(void *dst, void *src));
+                      ObjPool *obj_pool, void (*obj_move)(void *dst, void *src),
+                      enum ThreadQueueType type);
 void         tq_free(ThreadQueue **tq);
 
 /**
@@ -1160,6 +1160,7 @@ const AACCoefficientsEncoder ff_aac_coders[AAC_CODER_NB] = {
         search_for_ms,
         ff_aac_search_for_is,
         ff_aac_search_for_pred,
+        set_psy_cutoff_twoloop,
     },
     [AAC_CODER_FAST] = {
         search_for_quantizers_fast,
@@ -61,6 +61,48 @@ static inline int ff_pns_bits(SingleChannelElement *sce, int w, int g)
     return (!g || !sce->zeroes[w*16+g-1] || !sce->can_pns[w*16+g-1]) ? 9 : 5;
 }
 
+/**
+ * Bandwidth of the twoloop search. It only depends on lambda, not on the
+ * channel element being searched.
+ */
+static int twoloop_bandwidth(AVCodecContext *avctx, AACEncContext *s, const float lambda)
+{
+    int refbits = avctx->bit_rate * 1024.0 / avctx->sample_rate
+        / ((avctx->flags & AV_CODEC_FLAG_QSCALE) ? 2.0f : avctx->ch_layout.nb_channels)
+        * (lambda / 120.f);
+
+    /**
+     * Scale, psy gives us constant quality, this LP only scales
+     * bitrate by lambda, so we save bits on subjectively unimportant HF
+     * rather than increase quantization noise. Adjust nominal bitrate
+     * to effective bitrate according to encoding parameters,
+     * AAC_CUTOFF_FROM_BITRATE is calibrated for effective bitrate.
+     */
+    float rate_bandwidth_multiplier = 1.5f;
+    int frame_bit_rate = (avctx->flags & AV_CODEC_FLAG_QSCALE)
+        ? (refbits * rate_bandwidth_multiplier * avctx->sample_rate / 1024)
+        : (avctx->bit_rate / avctx->ch_layout.nb_channels);
+
+    /** Compensate for extensions that increase efficiency */
+    if (s->options.pns || s->options.intensity_stereo)
+        frame_bit_rate *= 1.15f;
+
+    if (avctx->cutoff > 0)
+        return avctx->cutoff;
+    return FFMAX(3000, AAC_CUTOFF_FROM_BITRATE(frame_bit_rate, 1, avctx->sample_rate));
+}
+
+/**
+ * Set the psy cutoff like search_for_quantizers_twoloop() does, without
+ * searching.
+ */
+static void set_psy_cutoff_twoloop(AVCodecContext *avctx, AACEncContext *s,
+                                   const float lambda)
+{
+    if (avctx->cutoff <= 0)
+        s->psy.cutoff = twoloop_bandwidth(avctx, s, lambda);
+}
+
 /**
  * two-loop quantizers search taken from ISO 13818-7 Appendix C
  */
@@ -73,7 +115,6 @@ static void search_for_quantizers_twoloop(AVCodecContext *avctx,
     int destbits = avctx->bit_rate * 1024.0 / avctx->sample_rate
         / ((avctx->flags & AV_CODEC_FLAG_QSCALE) ? 2.0f : avctx->ch_layout.nb_channels)
         * (lambda / 120.f);
-    int refbits = destbits;
     int toomanybits, toofewbits;
     char nzs[128];
     uint8_t nextband[128];
@@ -174,30 +215,10 @@ static void search_for_quantizers_twoloop(AVCodecContext *avctx,
     /** and zero out above cutoff frequency */
     {
         int wlen = 1024 / sce->ics.num_windows;
-        int bandwidth;
+        int bandwidth = twoloop_bandwidth(avctx, s, lambda);
 
-        /**
-         * Scale, psy gives us constant quality, this LP only scales
-         * bitrate by lambda, so we save bits on subjectively unimportant HF
-         * rather than increase quantization noise. Adjust nominal bitrate
-         * to effective bitrate according to encoding parameters,
-         * AAC_CUTOFF_FROM_BITRATE is calibrated for effective bitrate.
-         */
-        float rate_bandwidth_multiplier = 1.5f;
-        int frame_bit_rate = (avctx->flags & AV_CODEC_FLAG_QSCALE)
-            ? (refbits * rate_bandwidth_multiplier * avctx->sample_rate / 1024)
-            : (avctx->bit_rate / avctx->ch_layout.nb_channels);
-
-        /** Compensate for extensions that increase efficiency */
-        if (s->options.pns || s->options.intensity_stereo)
-            frame_bit_rate *= 1.15f;
-
-        if (avctx->cutoff > 0) {
-            bandwidth = avctx->cutoff;
-        } else {
-            bandwidth = FFMAX(3000, AAC_CUTOFF_FROM_BITRATE(frame_bit_rate, 1, avctx->sample_rate));
+        if (avctx->cutoff <= 0)
             s->psy.cutoff = bandwidth;
-        }
 
         cutoff = bandwidth * 2 * wlen / avctx->sample_rate;
         pns_start_pos = NOISE_LOW_LIMIT * 2 * wlen / avctx->sample_rate;
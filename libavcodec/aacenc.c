@@ -827,6 +827,42 @@ static void copy_input_samples(AACEncContext *s, const AVFrame *frame)
     }
 }
 
+typedef struct AACElementJob {
+    int start_ch;                                ///< first channel of the element
+    int bitres_alloc;                            ///< psy bit allocation for each channel
+} AACElementJob;
+
+static int search_for_quantizers_element(AVCodecContext *avctx, void *arg,
+                                         int el, int threadnr)
+{
+    AACEncContext *s  = avctx->priv_data;
+    AACEncContext *t  = s->thread_ctx ? &s->thread_ctx[threadnr] : s;
+    AACElementJob *job = (AACElementJob *)arg + el;
+    ChannelElement *cpe = &s->cpe[el];
+    int chans = s->chan_map[el + 1] == TYPE_CPE ? 2 : 1;
+    int ch;
+
+    /* The main context is only read while the jobs run. The thread contexts
+     * were copied from it at init and have their own scratch buffers and
+     * quantization cache, only the state which changes between frames and
+     * rate control iterations needs to be refreshed. */
+    if (t != s) {
+        t->psy    = s->psy;
+        t->lambda = s->lambda;
+    }
+
+    t->psy.bitres.alloc = job->bitres_alloc;
+    t->cur_type         = s->chan_map[el + 1];
+    for (ch = 0; ch < chans; ch++) {
+        t->cur_channel = job->start_ch + ch;
+        if (t->options.pns && t->coder->mark_pns)
+            t->coder->mark_pns(t, avctx, &cpe->ch[ch]);
+        t->coder->search_for_quantizers(avctx, t, &cpe->ch[ch], t->lambda);
+    }
+
+    return 0;
+}
+
 static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
                             const AVFrame *frame, int *got_packet_ptr)
 {
@@ -840,6 +876,7 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
     int ms_mode = 0, is_mode = 0, tns_mode = 0, pred_mode = 0;
     int chan_el_counter[4];
     FFPsyWindowInfo windows[AAC_MAX_CHANNELS];
+    AACElementJob jobs[AAC_MAX_CHANNELS];
 
     /* add current frame to queue */
     if (frame) {
@@ -972,8 +1009,6 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
             cpe->common_window = 0;
             memset(cpe->is_mask, 0, sizeof(cpe->is_mask));
             memset(cpe->ms_mask, 0, sizeof(cpe->ms_mask));
-            put_bits(&s->pb, 3, tag);
-            put_bits(&s->pb, 4, chan_el_counter[tag]++);
             for (ch = 0; ch < chans; ch++) {
                 sce = &cpe->ch[ch];
                 coeffs[ch] = sce->coeffs;
@@ -986,6 +1021,10 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
                     if (sce->band_type[w] > RESERVED_BT)
                         sce->band_type[w] = 0;
             }
+            /* The search of the previous element sets the cutoff used by
+             * the analysis of the next one, do it up front. */
+            if (i && s->coder->set_psy_cutoff)
+                s->coder->set_psy_cutoff(avctx, s, s->lambda);
             s->psy.bitres.alloc = -1;
             s->psy.bitres.bits = s->last_frame_pb_count / s->channels;
             s->psy.model->analyze(&s->psy, start_ch, coeffs, wi);
@@ -995,13 +1034,26 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
                     * (s->lambda / (avctx->global_quality ? avctx->global_quality : 120));
                 s->psy.bitres.alloc /= chans;
             }
+            jobs[i].start_ch     = start_ch;
+            jobs[i].bitres_alloc = s->psy.bitres.alloc;
+            start_ch += chans;
+        }
+
+        /* The quantizer search of each channel element only depends on
+         * the psy analysis above, so the elements can be searched in parallel. */
+        avctx->execute2(avctx, search_for_quantizers_element, jobs, NULL, s->chan_map[0]);
+        if (s->coder->set_psy_cutoff)
+            s->coder->set_psy_cutoff(avctx, s, s->lambda);
+
+        start_ch = 0;
+        for (i = 0; i < s->chan_map[0]; i++) {
+            FFPsyWindowInfo* wi = windows + start_ch;
+            tag      = s->chan_map[i+1];
+            chans    = tag == TYPE_CPE ? 2 : 1;
+            cpe      = &s->cpe[i];
             s->cur_type = tag;
-            for (ch = 0; ch < chans; ch++) {
-                s->cur_channel = start_ch + ch;
-                if (s->options.pns && s->coder->mark_pns)
-                    s->coder->mark_pns(s, avctx, &cpe->ch[ch]);
-                s->coder->search_for_quantizers(avctx, s, &cpe->ch[ch], s->lambda);
-            }
+            put_bits(&s->pb, 3, tag);
+            put_bits(&s->pb, 4, chan_el_counter[tag]++);
             if (chans > 1
                 && wi[0].window_type[0] == wi[1].window_type[0]
                 && wi[0].window_shape   == wi[1].window_shape) {
@@ -1196,6 +1248,7 @@ static av_cold int aac_encode_end(AVCodecContext *avctx)
         ff_psy_preprocess_end(s->psypp);
     av_freep(&s->buffer.samples);
     av_freep(&s->cpe);
+    av_freep(&s->thread_ctx);
     av_freep(&s->fdsp);
     ff_af_queue_close(&s->afq);
     return 0;
@@ -1230,6 +1283,14 @@ static av_cold int alloc_buffers(AVCodecContext *avctx, AACEncContext *s)
     for(ch = 0; ch < s->channels; ch++)
         s->planar_samples[ch] = s->buffer.samples + 3 * 1024 * ch;
 
+    if (avctx->active_thread_type & FF_THREAD_SLICE &&
+        avctx->thread_count > 1 && s->chan_map[0] > 1) {
+        s->nb_thread_ctx = FFMIN(avctx->thread_count, s->chan_map[0]);
+        s->thread_ctx    = av_calloc(s->nb_thread_ctx, sizeof(*s->thread_ctx));
+        if (!s->thread_ctx)
+            return AVERROR(ENOMEM);
+    }
+
     return 0;
 }
 
@@ -1385,6 +1446,9 @@ static av_cold int aac_encode_init(AVCodecContext *avctx)
 
     ff_af_queue_init(avctx, &s->afq);
 
+    for (i = 0; i < s->nb_thread_ctx; i++)
+        memcpy(&s->thread_ctx[i], s, offsetof(AACEncContext, quantize_band_cost_cache_generation));
+
     return 0;
 }
 
@@ -1423,7 +1487,8 @@ const FFCodec ff_aac_encoder = {
     .p.type         = AVMEDIA_TYPE_AUDIO,
     .p.id           = AV_CODEC_ID_AAC,
     .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY |
-                      AV_CODEC_CAP_SMALL_LAST_FRAME,
+                      AV_CODEC_CAP_SMALL_LAST_FRAME |
+                      AV_CODEC_CAP_SLICE_THREADS,
     .priv_data_size = sizeof(AACEncContext),
     .init           = aac_encode_init,
     FF_CODEC_ENCODE_CB(aac_encode_frame),
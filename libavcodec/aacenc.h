@@ -170,6 +170,7 @@ typedef struct AACCoefficientsEncoder {
     void (*search_for_ms)(struct AACEncContext *s, ChannelElement *cpe);
     void (*search_for_is)(struct AACEncContext *s, AVCodecContext *avctx, ChannelElement *cpe);
     void (*search_for_pred)(struct AACEncContext *s, SingleChannelElement *sce);
+    void (*set_psy_cutoff)(AVCodecContext *avctx, struct AACEncContext *s, const float lambda);
 } AACCoefficientsEncoder;
 
 extern const AACCoefficientsEncoder ff_aac_coders[];
@@ -231,14 +232,18 @@ typedef struct AACEncContext {
     DECLARE_ALIGNED(16, int,   qcoefs)[96];      ///< quantized coefficients
     DECLARE_ALIGNED(32, float, scoefs)[1024];    ///< scaled coefficients
 
-    uint16_t quantize_band_cost_cache_generation;
-    AACQuantizeBandCostCacheEntry quantize_band_cost_cache[256][128]; ///< memoization area for quantize_band_cost
-
     AACEncDSPContext aacdsp;
 
     struct {
         float *samples;
     } buffer;
+
+    struct AACEncContext *thread_ctx;            ///< per-thread contexts for the quantizer search
+    int nb_thread_ctx;
+
+    /* Per-thread state, must stay last: not copied into the thread contexts. */
+    uint16_t quantize_band_cost_cache_generation;
+    AACQuantizeBandCostCacheEntry quantize_band_cost_cache[256][128]; ///< memoization area for quantize_band_cost
 } AACEncContext;
 
 void ff_quantize_band_cost_cache_init(struct AACEncContext *s);
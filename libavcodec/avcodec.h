@@ -2075,6 +2075,19 @@ typedef struct AVCodecContext {
      */
     AVFrameSideData  **decoded_side_data;
     int             nb_decoded_side_data;
+
+    /**
+     * A reference to a thread pool created with av_thread_pool_alloc(), which
+     * slice threading will run its jobs on instead of creating its own
+     * threads. thread_count then limits the number of the pool's threads
+     * working for this context at the same time.
+     *
+     * Frame threading is not affected.
+     *
+     * - encoding and decoding: may be set by the user before calling
+     *   avcodec_open2(). Owned and freed by libavcodec afterwards.
+     */
+    AVBufferRef *thread_pool;
 } AVCodecContext;
 
 /**
@@ -206,6 +206,7 @@ av_cold int ff_frame_thread_encoder_init(AVCodecContext *avctx)
         thread_avctx->priv_data = tmpv;
         thread_avctx->internal = NULL;
         thread_avctx->hw_frames_ctx = NULL;
+        thread_avctx->thread_pool = NULL;
         ret = av_opt_copy(thread_avctx, avctx);
         if (ret < 0)
             goto fail;
@@ -51,6 +51,7 @@
 #include "mjpegdec.h"
 #include "jpeglsdec.h"
 #include "profiles.h"
+#include "thread.h"
 #include "put_bits.h"
 #include "exif.h"
 #include "bytestream.h"
@@ -752,7 +753,7 @@ int ff_mjpeg_decode_sof(MJpegDecodeContext *s)
         }
 
         av_frame_unref(s->picture_ptr);
-        if (ff_get_buffer(s->avctx, s->picture_ptr, AV_GET_BUFFER_FLAG_REF) < 0)
+        if (ff_thread_get_buffer(s->avctx, s->picture_ptr, AV_GET_BUFFER_FLAG_REF) < 0)
             return -1;
         s->picture_ptr->pict_type = AV_PICTURE_TYPE_I;
         s->picture_ptr->flags |= AV_FRAME_FLAG_KEY;
@@ -2367,6 +2368,31 @@ static void reset_icc_profile(MJpegDecodeContext *s)
     s->iccnum  = 0;
 }
 
+/**
+ * Check whether a marker which may change the state copied to the next frame
+ * thread, like DHT, DQT or LSE, follows in the rest of the packet.
+ * In entropy-coded data 0xFF is only followed by stuffing, restart markers
+ * or, with JPEG-LS, a byte below 0x80, so the segments need not be parsed.
+ * Data in other segments may give false positives, which only delay the
+ * next thread.
+ */
+static int state_markers_follow(const uint8_t *buf, const uint8_t *buf_end)
+{
+    while (buf_end - buf >= 2) {
+        const uint8_t *ff = memchr(buf, 0xff, buf_end - buf - 1);
+        int x;
+
+        if (!ff)
+            break;
+        x = ff[1];
+        if (x >= 0x80 && x != 0xff && x != SOS && x != EOI &&
+            (x < RST0 || x > RST7))
+            return 1;
+        buf = ff + 1;
+    }
+    return 0;
+}
+
 int ff_mjpeg_decode_frame_from_buf(AVCodecContext *avctx, AVFrame *frame,
                                    int *got_frame, const AVPacket *avpkt,
                                    const uint8_t *buf, const int buf_size)
@@ -2383,6 +2409,7 @@ int ff_mjpeg_decode_frame_from_buf(AVCodecContext *avctx, AVFrame *frame,
     AVDictionaryEntry *e = NULL;
 
     s->force_pal8 = 0;
+    s->setup_finished = 0;
 
     s->buf_size = buf_size;
 
@@ -2574,6 +2601,21 @@ eoi_parser:
             s->raw_scan_buffer_size = buf_end - buf_ptr;
 
             s->cur_scan++;
+
+            /* Once no more tables follow, which for most pictures is at the
+             * first scan, the state needed by the following pictures is known.
+             * Progressive and other multi-scan pictures can redefine tables
+             * between scans. An interlaced picture is only complete within
+             * this packet if this is its second field, otherwise the next
+             * thread has to wait for the first field to be decoded. */
+            if (!s->setup_finished && s->got_picture &&
+                (avctx->active_thread_type & FF_THREAD_FRAME) &&
+                (!s->interlaced || s->bottom_field == !s->interlace_polarity) &&
+                !state_markers_follow(buf_ptr, buf_end)) {
+                s->setup_finished = 1;
+                ff_thread_finish_setup(avctx);
+            }
+
             if (avctx->skip_frame == AVDISCARD_ALL) {
                 skip_bits(&s->gb, get_bits_left(&s->gb));
                 break;
@@ -2972,6 +3014,127 @@ av_cold int ff_mjpeg_decode_end(AVCodecContext *avctx)
     return 0;
 }
 
+#if HAVE_THREADS
+int ff_mjpeg_update_thread_context(AVCodecContext *dst, const AVCodecContext *src)
+{
+    MJpegDecodeContext *d = dst->priv_data;
+    const MJpegDecodeContext *s = src->priv_data;
+    int ret;
+
+    if (dst == src)
+        return 0;
+
+    memcpy(d->quant_matrixes, s->quant_matrixes, sizeof(d->quant_matrixes));
+    memcpy(d->qscale,         s->qscale,         sizeof(d->qscale));
+
+    // only rebuild the VLCs that were redefined since the last update
+    for (int class = 0; class < 2; class++) {
+        for (int index = 0; index < 4; index++) {
+            uint8_t bits_table[17] = { 0 };
+            int n = 0;
+
+            for (int i = 0; i < 16; i++)
+                n += s->raw_huffman_lengths[class][index][i];
+            if (!n ||
+                (!memcmp(d->raw_huffman_lengths[class][index],
+                         s->raw_huffman_lengths[class][index], 16) &&
+                 !memcmp(d->raw_huffman_values[class][index],
+                         s->raw_huffman_values[class][index], n)))
+                continue;
+
+            memcpy(bits_table + 1, s->raw_huffman_lengths[class][index], 16);
+
+            ff_vlc_free(&d->vlcs[class][index]);
+            ret = ff_mjpeg_build_vlc(&d->vlcs[class][index], bits_table,
+                                     s->raw_huffman_values[class][index],
+                                     class > 0, dst);
+            if (ret < 0)
+                return ret;
+
+            if (class > 0) {
+                ff_vlc_free(&d->vlcs[2][index]);
+                ret = ff_mjpeg_build_vlc(&d->vlcs[2][index], bits_table,
+                                         s->raw_huffman_values[class][index],
+                                         0, dst);
+                if (ret < 0)
+                    return ret;
+            }
+
+            memcpy(d->raw_huffman_lengths[class][index],
+                   s->raw_huffman_lengths[class][index], 16);
+            memcpy(d->raw_huffman_values[class][index],
+                   s->raw_huffman_values[class][index], n);
+        }
+    }
+
+    // the frame header sets up the IDCT for the bit depth, which has been
+    // copied to dst by the generic code already
+    if (d->bits != s->bits)
+        init_idct(dst);
+
+    // state from the previous frame header, used to detect size changes
+    d->width         = s->width;
+    d->height        = s->height;
+    d->bits          = s->bits;
+    memcpy(d->h_count, s->h_count, sizeof(d->h_count));
+    memcpy(d->v_count, s->v_count, sizeof(d->v_count));
+    d->first_picture = s->first_picture;
+    d->interlaced    = s->interlaced;
+
+    d->hwaccel_sw_pix_fmt = s->hwaccel_sw_pix_fmt;
+    d->hwaccel_pix_fmt    = s->hwaccel_pix_fmt;
+
+    // persistent state from application-specific markers
+    d->buggy_avid         = s->buggy_avid;
+    d->interlace_polarity = s->interlace_polarity;
+    d->cs_itu601          = s->cs_itu601;
+    d->multiscope         = s->multiscope;
+    d->pegasus_rct        = s->pegasus_rct;
+    d->rct                = s->rct;
+    d->colr               = s->colr;
+    d->xfrm               = s->xfrm;
+    d->flipped            = s->flipped;
+
+    // JPEG-LS parameters; the palette entries themselves are stored in the
+    // frame, LSE continuation segments append at palette_index
+    d->maxval        = s->maxval;
+    d->t1            = s->t1;
+    d->t2            = s->t2;
+    d->t3            = s->t3;
+    d->reset         = s->reset;
+    d->palette_index = s->palette_index;
+
+    if (s->setup_finished) {
+        // the source thread will output its picture, start a new one
+        d->got_picture  = 0;
+        d->bottom_field = s->interlaced ? s->interlace_polarity : s->bottom_field;
+        return 0;
+    }
+
+    d->got_picture  = s->got_picture;
+    d->bottom_field = s->bottom_field;
+
+    // the source ended between the two fields of a picture, the second one
+    // will be decoded into the same frame
+    if (s->got_picture && s->interlaced &&
+        s->bottom_field == !s->interlace_polarity) {
+        av_frame_unref(d->picture_ptr);
+        ret = av_frame_ref(d->picture_ptr, s->picture_ptr);
+        if (ret < 0)
+            return ret;
+
+        d->nb_components = s->nb_components;
+        d->rgb           = s->rgb;
+        d->pix_desc      = s->pix_desc;
+        memcpy(d->upscale_h, s->upscale_h, sizeof(d->upscale_h));
+        memcpy(d->upscale_v, s->upscale_v, sizeof(d->upscale_v));
+        memcpy(d->linesize,  s->linesize,  sizeof(d->linesize));
+    }
+
+    return 0;
+}
+#endif
+
 static void decode_flush(AVCodecContext *avctx)
 {
     MJpegDecodeContext *s = avctx->priv_data;
@@ -3006,8 +3169,9 @@ const FFCodec ff_mjpeg_decoder = {
     .init           = ff_mjpeg_decode_init,
     .close          = ff_mjpeg_decode_end,
     FF_CODEC_DECODE_CB(ff_mjpeg_decode_frame),
+    UPDATE_THREAD_CONTEXT(ff_mjpeg_update_thread_context),
     .flush          = decode_flush,
-    .p.capabilities = AV_CODEC_CAP_DR1,
+    .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS,
     .p.max_lowres   = 3,
     .p.priv_class   = &mjpegdec_class,
     .p.profiles     = NULL_IF_CONFIG_SMALL(ff_mjpeg_profiles),
@@ -132,6 +132,7 @@ typedef struct MJpegDecodeContext {
     int mjpb_skiptosod;
 
     int cur_scan; /* current scan, used by JPEG-LS */
+    int setup_finished; /* ff_thread_finish_setup() was called for the current packet */
     int flipped; /* true if picture is flipped */
 
     uint16_t (*ljpeg_buffer)[4];
@@ -171,6 +172,7 @@ int ff_mjpeg_build_vlc(VLC *vlc, const uint8_t *bits_table,
                        const uint8_t *val_table, int is_ac, void *logctx);
 int ff_mjpeg_decode_init(AVCodecContext *avctx);
 int ff_mjpeg_decode_end(AVCodecContext *avctx);
+int ff_mjpeg_update_thread_context(AVCodecContext *dst, const AVCodecContext *src);
 int ff_mjpeg_decode_frame(AVCodecContext *avctx,
                           AVFrame *frame, int *got_frame,
                           AVPacket *avpkt);
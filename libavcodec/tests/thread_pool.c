@@ -0,0 +1,158 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Encode the same frames with a frame threaded encoder using a shared
+ * thread pool and without threads, and check that the packets match and
+ * that closing the encoder releases exactly its own pool reference.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavcodec/avcodec.h"
+#include "libavutil/crc.h"
+#include "libavutil/frame.h"
+#include "libavutil/threadpool.h"
+
+#define WIDTH     64
+#define HEIGHT    48
+#define NB_FRAMES 16
+
+static int encode(AVBufferRef *pool, int threads, uint32_t *crcs)
+{
+    const AVCodec *codec = avcodec_find_encoder(AV_CODEC_ID_HUFFYUV);
+    const AVCRC *crc_tab = av_crc_get_table(AV_CRC_32_IEEE_LE);
+    AVCodecContext *avctx = NULL;
+    AVFrame *frame = NULL;
+    AVPacket *pkt = NULL;
+    int nb_pkts = 0, ret;
+
+    if (!codec)
+        return AVERROR_ENCODER_NOT_FOUND;
+
+    avctx = avcodec_alloc_context3(codec);
+    frame = av_frame_alloc();
+    pkt   = av_packet_alloc();
+    if (!avctx || !frame || !pkt) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    avctx->width        = WIDTH;
+    avctx->height       = HEIGHT;
+    avctx->pix_fmt      = AV_PIX_FMT_YUV422P;
+    avctx->time_base    = (AVRational){ 1, 25 };
+    avctx->thread_count = threads;
+    avctx->thread_type  = FF_THREAD_FRAME;
+    if (pool) {
+        avctx->thread_pool = av_buffer_ref(pool);
+        if (!avctx->thread_pool) {
+            ret = AVERROR(ENOMEM);
+            goto end;
+        }
+    }
+
+    ret = avcodec_open2(avctx, codec, NULL);
+    if (ret < 0)
+        goto end;
+
+    frame->format = avctx->pix_fmt;
+    frame->width  = avctx->width;
+    frame->height = avctx->height;
+    ret = av_frame_get_buffer(frame, 0);
+    if (ret < 0)
+        goto end;
+
+    for (int i = 0; i <= NB_FRAMES; i++) {
+        if (i < NB_FRAMES) {
+            ret = av_frame_make_writable(frame);
+            if (ret < 0)
+                goto end;
+            for (int p = 0; p < 3; p++) {
+                int w = p ? WIDTH / 2 : WIDTH;
+                for (int y = 0; y < HEIGHT; y++)
+                    for (int x = 0; x < w; x++)
+                        frame->data[p][y * frame->linesize[p] + x] = x * (p + 1) + y * 3 + i * 7;
+            }
+            frame->pts = i;
+        }
+
+        ret = avcodec_send_frame(avctx, i < NB_FRAMES ? frame : NULL);
+        if (ret < 0)
+            goto end;
+
+        while ((ret = avcodec_receive_packet(avctx, pkt)) >= 0) {
+            if (nb_pkts < NB_FRAMES)
+                crcs[nb_pkts] = av_crc(crc_tab, 0, pkt->data, pkt->size);
+            nb_pkts++;
+            av_packet_unref(pkt);
+        }
+        if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF)
+            goto end;
+    }
+    ret = nb_pkts == NB_FRAMES ? 0 : AVERROR_BUG;
+
+end:
+    avcodec_free_context(&avctx);
+    av_frame_free(&frame);
+    av_packet_free(&pkt);
+    return ret;
+}
+
+int main(void)
+{
+    uint32_t ref[NB_FRAMES], out[NB_FRAMES];
+    AVBufferRef *pool;
+    int ret;
+
+    ret = encode(NULL, 1, ref);
+    if (ret < 0) {
+        fprintf(stderr, "Unthreaded encoding failed: %s\n", av_err2str(ret));
+        return 1;
+    }
+
+    pool = av_thread_pool_alloc(4);
+    if (!pool) {
+        /* Threading is not supported, nothing to test. */
+        return 0;
+    }
+
+    for (int threads = 2; threads <= 4; threads++) {
+        ret = encode(pool, threads, out);
+        if (ret < 0) {
+            fprintf(stderr, "Encoding with %d threads failed: %s\n",
+                    threads, av_err2str(ret));
+            break;
+        }
+        if (memcmp(ref, out, sizeof(ref))) {
+            fprintf(stderr, "Output with %d threads differs\n", threads);
+            ret = 1;
+            break;
+        }
+        if (av_buffer_get_ref_count(pool) != 1) {
+            fprintf(stderr, "Pool has %d references left after closing "
+                    "the encoder\n", av_buffer_get_ref_count(pool));
+            ret = 1;
+            break;
+        }
+    }
+
+    av_buffer_unref(&pool);
+    return !!ret;
+}
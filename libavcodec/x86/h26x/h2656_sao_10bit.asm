@@ -1,5 +1,5 @@
 ;******************************************************************************
-;* SIMD optimized SAO functions for HEVC 10/12bit decoding
+;* SIMD optimized SAO functions for HEVC/VVC 10/12bit decoding
 ;*
 ;* Copyright (c) 2013 Pierre-Edouard LEPERE
 ;* Copyright (c) 2014 James Almer
@@ -39,7 +39,7 @@ SECTION .text
 ;SAO Band Filter
 ;******************************************************************************
 
-%macro HEVC_SAO_BAND_FILTER_INIT 1
+%macro H2656_SAO_BAND_FILTER_INIT 1
     and            leftq, 31
     movd             xm0, leftd
     add            leftq, 1
@@ -92,22 +92,22 @@ DEFINE_ARGS dst, src, dststride, srcstride, offset, height
     mov          heightd, r7m
 %endmacro
 
-;void ff_hevc_sao_band_filter_<width>_<depth>_<opt>(uint8_t *_dst, const uint8_t *_src, ptrdiff_t _stride_dst, ptrdiff_t _stride_src,
-;                                                   int16_t *sao_offset_val, int sao_left_class, int width, int height);
-%macro HEVC_SAO_BAND_FILTER 3
-cglobal hevc_sao_band_filter_%2_%1, 6, 6, 15, 7*mmsize*ARCH_X86_32, dst, src, dststride, srcstride, offset, left
-    HEVC_SAO_BAND_FILTER_INIT %1
+;void ff_<codec>_sao_band_filter_<width>_<depth>_<opt>(uint8_t *_dst, const uint8_t *_src, ptrdiff_t _stride_dst, ptrdiff_t _stride_src,
+;                                                     int16_t *sao_offset_val, int sao_left_class, int width, int height);
+%macro H2656_SAO_BAND_FILTER 4
+cglobal %1_sao_band_filter_%3_%2, 6, 6, 15, 7*mmsize*ARCH_X86_32, dst, src, dststride, srcstride, offset, left
+    H2656_SAO_BAND_FILTER_INIT %2
 
 align 16
 .loop:
 
 %assign i 0
 %assign j 0
-%rep %3
+%rep %4
 %assign k 8+(j&1)
 %assign l 9-(j&1)
     mova          m %+ k, [srcq + i]
-    psraw         m %+ l, m %+ k, %1-5
+    psraw         m %+ l, m %+ k, %2-5
 %if ARCH_X86_64
     pcmpeqw          m10, m %+ l, m0
     pcmpeqw          m11, m %+ l, m1
@@ -149,17 +149,17 @@ align 16
 %endmacro
 
 %macro HEVC_SAO_BAND_FILTER_FUNCS 0
-HEVC_SAO_BAND_FILTER 10,  8, 1
-HEVC_SAO_BAND_FILTER 10, 16, 2
-HEVC_SAO_BAND_FILTER 10, 32, 4
-HEVC_SAO_BAND_FILTER 10, 48, 6
-HEVC_SAO_BAND_FILTER 10, 64, 8
-
-HEVC_SAO_BAND_FILTER 12,  8, 1
-HEVC_SAO_BAND_FILTER 12, 16, 2
-HEVC_SAO_BAND_FILTER 12, 32, 4
-HEVC_SAO_BAND_FILTER 12, 48, 6
-HEVC_SAO_BAND_FILTER 12, 64, 8
+H2656_SAO_BAND_FILTER hevc, 10,  8, 1
+H2656_SAO_BAND_FILTER hevc, 10, 16, 2
+H2656_SAO_BAND_FILTER hevc, 10, 32, 4
+H2656_SAO_BAND_FILTER hevc, 10, 48, 6
+H2656_SAO_BAND_FILTER hevc, 10, 64, 8
+
+H2656_SAO_BAND_FILTER hevc, 12,  8, 1
+H2656_SAO_BAND_FILTER hevc, 12, 16, 2
+H2656_SAO_BAND_FILTER hevc, 12, 32, 4
+H2656_SAO_BAND_FILTER hevc, 12, 48, 6
+H2656_SAO_BAND_FILTER hevc, 12, 64, 8
 %endmacro
 
 INIT_XMM sse2
@@ -169,29 +169,48 @@ HEVC_SAO_BAND_FILTER_FUNCS
 
 %if HAVE_AVX2_EXTERNAL
 INIT_XMM avx2
-HEVC_SAO_BAND_FILTER 10,  8, 1
+H2656_SAO_BAND_FILTER hevc, 10,  8, 1
 INIT_YMM avx2
-HEVC_SAO_BAND_FILTER 10, 16, 1
-HEVC_SAO_BAND_FILTER 10, 32, 2
-HEVC_SAO_BAND_FILTER 10, 48, 3
-HEVC_SAO_BAND_FILTER 10, 64, 4
+H2656_SAO_BAND_FILTER hevc, 10, 16, 1
+H2656_SAO_BAND_FILTER hevc, 10, 32, 2
+H2656_SAO_BAND_FILTER hevc, 10, 48, 3
+H2656_SAO_BAND_FILTER hevc, 10, 64, 4
 
 INIT_XMM avx2
-HEVC_SAO_BAND_FILTER 12,  8, 1
+H2656_SAO_BAND_FILTER hevc, 12,  8, 1
 INIT_YMM avx2
-HEVC_SAO_BAND_FILTER 12, 16, 1
-HEVC_SAO_BAND_FILTER 12, 32, 2
-HEVC_SAO_BAND_FILTER 12, 48, 3
-HEVC_SAO_BAND_FILTER 12, 64, 4
+H2656_SAO_BAND_FILTER hevc, 12, 16, 1
+H2656_SAO_BAND_FILTER hevc, 12, 32, 2
+H2656_SAO_BAND_FILTER hevc, 12, 48, 3
+H2656_SAO_BAND_FILTER hevc, 12, 64, 4
+%endif
+
+%macro VVC_SAO_BAND_FILTER_AVX2 1
+INIT_XMM avx2
+H2656_SAO_BAND_FILTER vvc, %1,   8, 1
+INIT_YMM avx2
+H2656_SAO_BAND_FILTER vvc, %1,  16, 1
+H2656_SAO_BAND_FILTER vvc, %1,  32, 2
+H2656_SAO_BAND_FILTER vvc, %1,  48, 3
+H2656_SAO_BAND_FILTER vvc, %1,  64, 4
+H2656_SAO_BAND_FILTER vvc, %1,  80, 5
+H2656_SAO_BAND_FILTER vvc, %1,  96, 6
+H2656_SAO_BAND_FILTER vvc, %1, 112, 7
+H2656_SAO_BAND_FILTER vvc, %1, 128, 8
+%endmacro
+
+%if ARCH_X86_64 && HAVE_AVX2_EXTERNAL
+VVC_SAO_BAND_FILTER_AVX2 10
+VVC_SAO_BAND_FILTER_AVX2 12
 %endif
 
 ;******************************************************************************
 ;SAO Edge Filter
 ;******************************************************************************
 
-%define MAX_PB_SIZE  64
-%define PADDING_SIZE 64 ; AV_INPUT_BUFFER_PADDING_SIZE
-%define EDGE_SRCSTRIDE 2 * MAX_PB_SIZE + PADDING_SIZE
+%define HEVC_MAX_PB_SIZE  64
+%define VVC_MAX_PB_SIZE  128
+%define PADDING_SIZE      64 ; AV_INPUT_BUFFER_PADDING_SIZE
 
 %macro PMINUW 4
 %if cpuflag(sse4)
@@ -202,7 +221,7 @@ HEVC_SAO_BAND_FILTER 12, 64, 4
 %endif
 %endmacro
 
-%macro HEVC_SAO_EDGE_FILTER_INIT 0
+%macro H2656_SAO_EDGE_FILTER_INIT 0
 %if WIN64
     movsxd           eoq, dword eom
 %elif ARCH_X86_64
@@ -221,19 +240,21 @@ HEVC_SAO_BAND_FILTER 12, 64, 4
     add        b_strideq, tmpq
 %endmacro
 
-;void ff_hevc_sao_edge_filter_<width>_<depth>_<opt>(uint8_t *_dst, uint8_t *_src, ptrdiff_t stride_dst, int16_t *sao_offset_val,
-;                                                   int eo, int width, int height);
-%macro HEVC_SAO_EDGE_FILTER 3
+;void ff_<codec>_sao_edge_filter_<width>_<depth>_<opt>(uint8_t *_dst, uint8_t *_src, ptrdiff_t stride_dst, int16_t *sao_offset_val,
+;                                                     int eo, int width, int height);
+; the source stride is implicit: 2 * <CODEC>_MAX_PB_SIZE + AV_INPUT_BUFFER_PADDING_SIZE
+%macro H2656_SAO_EDGE_FILTER 5
+%xdefine EDGE_SRCSTRIDE (2 * %2 + PADDING_SIZE)
 %if ARCH_X86_64
-cglobal hevc_sao_edge_filter_%2_%1, 4, 9, 16, dst, src, dststride, offset, eo, a_stride, b_stride, height, tmp
+cglobal %1_sao_edge_filter_%4_%3, 4, 9, 16, dst, src, dststride, offset, eo, a_stride, b_stride, height, tmp
 %define tmp2q heightq
-    HEVC_SAO_EDGE_FILTER_INIT
+    H2656_SAO_EDGE_FILTER_INIT
     mov          heightd, r6m
     add        a_strideq, a_strideq
     add        b_strideq, b_strideq
 
 %else ; ARCH_X86_32
-cglobal hevc_sao_edge_filter_%2_%1, 1, 6, 8, 5*mmsize, dst, src, dststride, a_stride, b_stride, height
+cglobal %1_sao_edge_filter_%4_%3, 1, 6, 8, 5*mmsize, dst, src, dststride, a_stride, b_stride, height
 %define eoq   srcq
 %define tmpq  heightq
 %define tmp2q dststrideq
@@ -243,7 +264,7 @@ cglobal hevc_sao_edge_filter_%2_%1, 1, 6, 8, 5*mmsize, dst, src, dststride, a_st
 %define m10 m3
 %define m11 m4
 %define m12 m5
-    HEVC_SAO_EDGE_FILTER_INIT
+    H2656_SAO_EDGE_FILTER_INIT
     mov             srcq, srcm
     mov          offsetq, r3m
     mov       dststrideq, dststridem
@@ -285,7 +306,7 @@ align 16
 .loop:
 
 %assign i 0
-%rep %3
+%rep %5
     mova              m1, [srcq + i]
     movu              m2, [srcq+a_strideq + i]
     movu              m3, [srcq+b_strideq + i]
@@ -326,7 +347,7 @@ align 16
     paddw             m2, m7
     paddw             m2, m1
     paddw             m2, m5
-    CLIPW             m2, m0, [pw_mask %+ %1]
+    CLIPW             m2, m0, [pw_mask %+ %3]
     mova      [dstq + i], m2
 %assign i i+mmsize
 %endrep
@@ -339,32 +360,51 @@ align 16
 %endmacro
 
 INIT_XMM sse2
-HEVC_SAO_EDGE_FILTER 10,  8, 1
-HEVC_SAO_EDGE_FILTER 10, 16, 2
-HEVC_SAO_EDGE_FILTER 10, 32, 4
-HEVC_SAO_EDGE_FILTER 10, 48, 6
-HEVC_SAO_EDGE_FILTER 10, 64, 8
-
-HEVC_SAO_EDGE_FILTER 12,  8, 1
-HEVC_SAO_EDGE_FILTER 12, 16, 2
-HEVC_SAO_EDGE_FILTER 12, 32, 4
-HEVC_SAO_EDGE_FILTER 12, 48, 6
-HEVC_SAO_EDGE_FILTER 12, 64, 8
+H2656_SAO_EDGE_FILTER hevc, HEVC_MAX_PB_SIZE, 10,  8, 1
+H2656_SAO_EDGE_FILTER hevc, HEVC_MAX_PB_SIZE, 10, 16, 2
+H2656_SAO_EDGE_FILTER hevc, HEVC_MAX_PB_SIZE, 10, 32, 4
+H2656_SAO_EDGE_FILTER hevc, HEVC_MAX_PB_SIZE, 10, 48, 6
+H2656_SAO_EDGE_FILTER hevc, HEVC_MAX_PB_SIZE, 10, 64, 8
+
+H2656_SAO_EDGE_FILTER hevc, HEVC_MAX_PB_SIZE, 12,  8, 1
+H2656_SAO_EDGE_FILTER hevc, HEVC_MAX_PB_SIZE, 12, 16, 2
+H2656_SAO_EDGE_FILTER hevc, HEVC_MAX_PB_SIZE, 12, 32, 4
+H2656_SAO_EDGE_FILTER hevc, HEVC_MAX_PB_SIZE, 12, 48, 6
+H2656_SAO_EDGE_FILTER hevc, HEVC_MAX_PB_SIZE, 12, 64, 8
 
 %if HAVE_AVX2_EXTERNAL
 INIT_XMM avx2
-HEVC_SAO_EDGE_FILTER 10,  8, 1
+H2656_SAO_EDGE_FILTER hevc, HEVC_MAX_PB_SIZE, 10,  8, 1
 INIT_YMM avx2
-HEVC_SAO_EDGE_FILTER 10, 16, 1
-HEVC_SAO_EDGE_FILTER 10, 32, 2
-HEVC_SAO_EDGE_FILTER 10, 48, 3
-HEVC_SAO_EDGE_FILTER 10, 64, 4
+H2656_SAO_EDGE_FILTER hevc, HEVC_MAX_PB_SIZE, 10, 16, 1
+H2656_SAO_EDGE_FILTER hevc, HEVC_MAX_PB_SIZE, 10, 32, 2
+H2656_SAO_EDGE_FILTER hevc, HEVC_MAX_PB_SIZE, 10, 48, 3
+H2656_SAO_EDGE_FILTER hevc, HEVC_MAX_PB_SIZE, 10, 64, 4
 
 INIT_XMM avx2
-HEVC_SAO_EDGE_FILTER 12,  8, 1
+H2656_SAO_EDGE_FILTER hevc, HEVC_MAX_PB_SIZE, 12,  8, 1
 INIT_YMM avx2
-HEVC_SAO_EDGE_FILTER 12, 16, 1
-HEVC_SAO_EDGE_FILTER 12, 32, 2
-HEVC_SAO_EDGE_FILTER 12, 48, 3
-HEVC_SAO_EDGE_FILTER 12, 64, 4
+H2656_SAO_EDGE_FILTER hevc, HEVC_MAX_PB_SIZE, 12, 16, 1
+H2656_SAO_EDGE_FILTER hevc, HEVC_MAX_PB_SIZE, 12, 32, 2
+H2656_SAO_EDGE_FILTER hevc, HEVC_MAX_PB_SIZE, 12, 48, 3
+H2656_SAO_EDGE_FILTER hevc, HEVC_MAX_PB_SIZE, 12, 64, 4
+%endif
+
+%macro VVC_SAO_EDGE_FILTER_AVX2 1
+INIT_XMM avx2
+H2656_SAO_EDGE_FILTER vvc, VVC_MAX_PB_SIZE, %1,   8, 1
+INIT_YMM avx2
+H2656_SAO_EDGE_FILTER vvc, VVC_MAX_PB_SIZE, %1,  16, 1
+H2656_SAO_EDGE_FILTER vvc, VVC_MAX_PB_SIZE, %1,  32, 2
+H2656_SAO_EDGE_FILTER vvc, VVC_MAX_PB_SIZE, %1,  48, 3
+H2656_SAO_EDGE_FILTER vvc, VVC_MAX_PB_SIZE, %1,  64, 4
+H2656_SAO_EDGE_FILTER vvc, VVC_MAX_PB_SIZE, %1,  80, 5
+H2656_SAO_EDGE_FILTER vvc, VVC_MAX_PB_SIZE, %1,  96, 6
+H2656_SAO_EDGE_FILTER vvc, VVC_MAX_PB_SIZE, %1, 112, 7
+H2656_SAO_EDGE_FILTER vvc, VVC_MAX_PB_SIZE, %1, 128, 8
+%endmacro
+
+%if ARCH_X86_64 && HAVE_AVX2_EXTERNAL
+VVC_SAO_EDGE_FILTER_AVX2 10
+VVC_SAO_EDGE_FILTER_AVX2 12
 %endif
@@ -0,0 +1,369 @@
+;******************************************************************************
+;* VVC Adaptive Loop Filter SIMD optimizations
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pd_1    dd 1
+
+SECTION .text
+
+%if ARCH_X86_64
+%if HAVE_AVX2_EXTERNAL
+
+%define ALF_BLOCK_SIZE  4
+
+; The filter works on 16 pixels of a row, i.e. on four 4x4 blocks which may
+; each use their own coefficients. Two coefficients are applied at a time with
+; pmaddwd, so the words of a pair are interleaved. After an in-lane
+; punpcklwd the low half holds blocks 0 and 2, after punpckhwd the high half
+; holds blocks 1 and 3; packssdw undoes this at the end.
+;
+; For every coefficient pair the stack holds the coefficients, the clipping
+; values and the negated clipping values, each for the low and the high half.
+%define PAIR_SIZE       (6 * mmsize)
+%define COEF_LO(p)      rsp + (p) * PAIR_SIZE + 0 * mmsize
+%define COEF_HI(p)      rsp + (p) * PAIR_SIZE + 1 * mmsize
+%define CLIP_LO(p)      rsp + (p) * PAIR_SIZE + 2 * mmsize
+%define CLIP_HI(p)      rsp + (p) * PAIR_SIZE + 3 * mmsize
+%define NCLIP_LO(p)     rsp + (p) * PAIR_SIZE + 4 * mmsize
+%define NCLIP_HI(p)     rsp + (p) * PAIR_SIZE + 5 * mmsize
+
+%macro LOAD_PIXELS 2 ; dst, src
+%if ps == 2
+    movu                 %1, %2
+%else
+    pmovzxbw             %1, %2
+%endif
+%endmacro
+
+; m4 holds the coefficient (or clipping value) words of blocks 0 and 2,
+; m5 those of blocks 1 and 3
+; %1: first pair, %2: number of pairs, %3: 0 for coefficients, 1 for clipping values
+%macro ALF_STORE_PAIRS 3
+%assign %%i 0
+%rep %2
+    pshufd               m6, m4, %%i * 0x55
+    pshufd               m7, m5, %%i * 0x55
+%if %3
+    mova  [CLIP_LO(%1 + %%i)], m6
+    mova  [CLIP_HI(%1 + %%i)], m7
+    psubw                m6, m10, m6
+    psubw                m7, m10, m7
+    mova [NCLIP_LO(%1 + %%i)], m6
+    mova [NCLIP_HI(%1 + %%i)], m7
+%else
+    mova  [COEF_LO(%1 + %%i)], m6
+    mova  [COEF_HI(%1 + %%i)], m7
+%endif
+%assign %%i %%i + 1
+%endrep
+%endmacro
+
+; Luma blocks use their own parameters; s1q, s3q and s5q hold the byte offsets
+; of blocks 1, 2 and 3, or 0 past the right edge.
+; %1: filter or clip, %2: 0 for coefficients, 1 for clipping values
+%macro ALF_LOAD_PARAMS_LUMA 2
+    movu                xm4, [%1q]
+    vinserti128          m4, m4, [%1q + s3q], 1
+    movu                xm5, [%1q + s1q]
+    vinserti128          m5, m5, [%1q + s5q], 1
+    ALF_STORE_PAIRS       0, 4, %2
+    movq                xm4, [%1q + 16]
+    movq                xm6, [%1q + s3q + 16]
+    vinserti128          m4, m4, xm6, 1
+    movq                xm5, [%1q + s1q + 16]
+    movq                xm6, [%1q + s5q + 16]
+    vinserti128          m5, m5, xm6, 1
+    ALF_STORE_PAIRS       4, 2, %2
+%endmacro
+
+; All chroma blocks of a CTB use the same parameters.
+%macro ALF_LOAD_PARAMS_CHROMA 2
+    movq                xm4, [%1q]
+    pinsrd              xm4, [%1q + 8], 2
+    vinserti128          m4, m4, xm4, 1
+    mova                 m5, m4
+    ALF_STORE_PAIRS       0, 3, %2
+%endmacro
+
+; Loads a tap row. Rows 1, 3 and 5 are below the current row, rows 2, 4 and 6
+; above it; the latter are addressed through tmpq.
+; %1: dst, %2: row, %3: column offset
+%macro LOAD_TAP 3
+%if %2 == 0
+    LOAD_PIXELS          %1, [srcq + (%3) * ps]
+%elif %2 == 1
+    LOAD_PIXELS          %1, [srcq + s1q + (%3) * ps]
+%elif %2 == 3
+    LOAD_PIXELS          %1, [srcq + s3q + (%3) * ps]
+%elif %2 == 5
+    LOAD_PIXELS          %1, [srcq + s5q + (%3) * ps]
+%else
+%if %2 != tmp_row
+    %assign tmp_row %2
+    mov                tmpq, srcq
+%if %2 == 2
+    sub                tmpq, s1q
+%elif %2 == 4
+    sub                tmpq, s3q
+%else
+    sub                tmpq, s5q
+%endif
+%endif
+    LOAD_PIXELS          %1, [tmpq + (%3) * ps]
+%endif
+%endmacro
+
+; sum += coeff[k]     * (clip(a_k     - curr) + clip(b_k     - curr))
+;      + coeff[k + 1] * (clip(a_k + 1 - curr) + clip(b_k + 1 - curr))
+; %1: pair, %2-%9: row and column of a_k, a_k+1, b_k, b_k+1
+%macro ALF_PAIR 9
+    LOAD_TAP             m4, %2, %3
+    LOAD_TAP             m5, %4, %5
+    punpckhwd            m6, m4, m5
+    punpcklwd            m4, m5
+    LOAD_TAP             m5, %6, %7
+    LOAD_TAP             m7, %8, %9
+    punpckhwd            m8, m5, m7
+    punpcklwd            m5, m7
+
+    psubw                m4, m2
+    psubw                m6, m3
+    psubw                m5, m2
+    psubw                m8, m3
+    pminsw               m4, [CLIP_LO(%1)]
+    pminsw               m6, [CLIP_HI(%1)]
+    pminsw               m5, [CLIP_LO(%1)]
+    pminsw               m8, [CLIP_HI(%1)]
+    pmaxsw               m4, [NCLIP_LO(%1)]
+    pmaxsw               m6, [NCLIP_HI(%1)]
+    pmaxsw               m5, [NCLIP_LO(%1)]
+    pmaxsw               m8, [NCLIP_HI(%1)]
+    paddw                m4, m5
+    paddw                m6, m8
+
+    pmaddwd              m4, [COEF_LO(%1)]
+    pmaddwd              m6, [COEF_HI(%1)]
+    paddd                m0, m4
+    paddd                m1, m6
+%endmacro
+
+; Sets up the row offsets and the shift for the current row. Rows close to the
+; virtual boundary only see the rows on their side of it, and the two rows
+; next to it use a shift of 10 instead of 7.
+%macro ALF_ROW_SETUP 0
+    mov                tmpq, vb_posq
+    sub                tmpq, iq
+    lea                 s5q, [tmpq - 1]
+    neg                tmpq
+    cmp                tmpq, s5q
+    cmovl              tmpq, s5q                ; distance to the virtual boundary
+
+    xor                 s3d, s3d
+    mov                 s1q, src_strideq
+    cmp                tmpq, 1
+    cmovl               s1q, s3q
+    lea                 s3q, [src_strideq * 2]
+    cmp                tmpq, 2
+    cmovl               s3q, s1q
+    lea                 s5q, [src_strideq * 3]
+    cmp                tmpq, 3
+    cmovl               s5q, s3q
+
+    cmp                tmpq, 1
+    sbb                tmpd, tmpd
+    and                tmpd, 3
+    add                tmpd, 7
+    movd               xm11, tmpd               ; shift
+    pslld               m12, m13, xm11
+    psrld               m12, 1                  ; offset
+%endmacro
+
+; %1: luma or chroma
+%macro ALF_FILTER_ROW 1
+    %assign tmp_row 0
+    LOAD_PIXELS         m14, [srcq]
+    punpcklwd            m2, m14, m14
+    punpckhwd            m3, m14, m14
+    pxor                 m0, m0
+    pxor                 m1, m1
+
+%ifidn %1, luma
+    ALF_PAIR              0, 5,  0, 3,  1, 6,  0, 4, -1
+    ALF_PAIR              1, 3,  0, 3, -1, 4,  0, 4,  1
+    ALF_PAIR              2, 1,  2, 1,  1, 2, -2, 2, -1
+    ALF_PAIR              3, 1,  0, 1, -1, 2,  0, 2,  1
+    ALF_PAIR              4, 1, -2, 0,  3, 2,  2, 0, -3
+    ALF_PAIR              5, 0,  2, 0,  1, 0, -2, 0, -1
+%else
+    ALF_PAIR              0, 3,  0, 1,  1, 4,  0, 2, -1
+    ALF_PAIR              1, 1,  0, 1, -1, 2,  0, 2,  1
+    ALF_PAIR              2, 0,  2, 0,  1, 0, -2, 0, -1
+%endif
+
+    paddd                m0, m12
+    paddd                m1, m12
+    psrad                m0, xm11
+    psrad                m1, xm11
+    packssdw             m0, m1
+    paddsw               m0, m14
+    pmaxsw               m0, m10
+    pminsw               m0, m9
+%endmacro
+
+; Stores the 16 filtered pixels of the row, or the 4, 8 or 12 left of the
+; right edge.
+%macro ALF_STORE_ROW 0
+    mov                tmpq, widthq
+    sub                tmpq, xq
+%if ps == 1
+    packuswb             m0, m0
+    vpermq               m0, m0, q0020
+%endif
+    cmp                tmpq, 16
+    jl .w_lt16
+%if ps == 2
+    movu             [dstq], m0
+%else
+    movu             [dstq], xm0
+%endif
+    jmp .stored
+.w_lt16:
+    cmp                tmpq, 8
+    jl .w4
+    jg .w12
+%if ps == 2
+    movu             [dstq], xm0
+%else
+    movq             [dstq], xm0
+%endif
+    jmp .stored
+.w12:
+%if ps == 2
+    movu             [dstq], xm0
+    vextracti128        xm0, m0, 1
+    movq        [dstq + 16], xm0
+%else
+    movq             [dstq], xm0
+    pextrd       [dstq + 8], xm0, 2
+%endif
+    jmp .stored
+.w4:
+%if ps == 2
+    movq             [dstq], xm0
+%else
+    movd             [dstq], xm0
+%endif
+.stored:
+%endmacro
+
+;void ff_vvc_alf_filter_%2_%1bpc_avx2(uint8_t *dst, ptrdiff_t dst_stride,
+;    const uint8_t *src, ptrdiff_t src_stride, ptrdiff_t width, ptrdiff_t height,
+;    const int16_t *filter, const int16_t *clip, ptrdiff_t vb_pos, ptrdiff_t pixel_max);
+%macro ALF_FILTER 2
+%assign ps %1 / 8
+%ifidn %2, luma
+    %assign pairs 6
+%else
+    %assign pairs 3
+%endif
+cglobal vvc_alf_filter_%2_%1bpc, 10, 15, 15, 0-pairs*PAIR_SIZE, dst, dst_stride, src, src_stride, width, height, filter, clip, vb_pos, pixel_max, x, s1, s3, s5, tmp
+    movd                xm9, pixel_maxd
+    vpbroadcastw         m9, xm9
+    pxor                m10, m10
+    vpbroadcastd        m13, [pd_1]
+
+    DEFINE_ARGS dst, dst_stride, src, src_stride, width, height, filter, clip, vb_pos, i, x, s1, s3, s5, tmp
+
+%ifidn %2, chroma
+    ALF_LOAD_PARAMS_CHROMA filter, 0
+    ALF_LOAD_PARAMS_CHROMA clip,   1
+%endif
+
+.loop_y:
+    xor                  xd, xd
+.loop_x:
+%ifidn %2, luma
+    mov                tmpq, widthq
+    sub                tmpq, xq
+    xor                  id, id
+    mov                 s1d, 24
+    cmp                tmpq, 4
+    cmovle              s1q, iq
+    mov                 s3d, 48
+    cmp                tmpq, 8
+    cmovle              s3q, iq
+    mov                 s5d, 72
+    cmp                tmpq, 12
+    cmovle              s5q, iq
+    ALF_LOAD_PARAMS_LUMA filter, 0
+    ALF_LOAD_PARAMS_LUMA clip,   1
+
+    mov                 s1d, 16
+    cmp                tmpq, 16
+    cmovl               s1q, tmpq
+    lea                 s1q, [s1q * 3]
+    add                 s1q, s1q                ; 24 bytes per 4 pixels
+    add             filterq, s1q
+    add               clipq, s1q
+%endif
+
+    xor                  id, id
+.loop_row:
+    ALF_ROW_SETUP
+    ALF_FILTER_ROW       %2
+    ALF_STORE_ROW
+    add                srcq, src_strideq
+    add                dstq, dst_strideq
+    inc                  id
+    cmp                  id, ALF_BLOCK_SIZE
+    jl .loop_row
+
+    lea                tmpq, [src_strideq * ALF_BLOCK_SIZE]
+    sub                srcq, tmpq
+    lea                tmpq, [dst_strideq * ALF_BLOCK_SIZE]
+    sub                dstq, tmpq
+    add                srcq, 16 * ps
+    add                dstq, 16 * ps
+    add                  xq, 16
+    cmp                  xq, widthq
+    jl .loop_x
+
+    lea                tmpq, [xq * ps]
+    sub                srcq, tmpq
+    sub                dstq, tmpq
+    lea                srcq, [srcq + src_strideq * ALF_BLOCK_SIZE]
+    lea                dstq, [dstq + dst_strideq * ALF_BLOCK_SIZE]
+    sub             vb_posq, ALF_BLOCK_SIZE
+    sub             heightq, ALF_BLOCK_SIZE
+    jg .loop_y
+    RET
+%endmacro
+
+INIT_YMM avx2
+ALF_FILTER  8, luma
+ALF_FILTER 16, luma
+ALF_FILTER  8, chroma
+ALF_FILTER 16, chroma
+
+%endif
+%endif
@@ -0,0 +1,109 @@
+;******************************************************************************
+;* VVC inverse transform SIMD optimizations
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+%if ARCH_X86_64
+%if HAVE_AVX2_EXTERNAL
+
+%macro STORE_DWORDS 1 ; src
+    movd          [coeffsq], %1
+    pextrd        [coeffsq + strideq], %1, 1
+    pextrd    [coeffsq + strideq * 2], %1, 2
+    pextrd      [coeffsq + stride3q], %1, 3
+    lea             coeffsq, [coeffsq + strideq * 4]
+%endmacro
+
+;void ff_vvc_inv_matrix_mul_%1_avx2(int *coeffs, ptrdiff_t stride,
+;    const int8_t *matrix, size_t nz);
+; coeffs[i * stride] = sum(coeffs[j * stride] * matrix[j * %1 + i], j < nz)
+%macro INV_MATRIX_MUL 1
+%assign regs (%1 + 7) / 8
+cglobal vvc_inv_matrix_mul_%1, 4, 6, 6, coeffs, stride, matrix, nz, src, stride3
+%assign i 0
+%rep regs
+    pxor                 m %+ i, m %+ i
+%assign i i + 1
+%endrep
+    shl             strideq, 2
+    mov                srcq, coeffsq
+    test                nzq, nzq
+    jz .store
+
+.loop:
+    vpbroadcastd         m4, [srcq]
+%if %1 == 4
+    pmovsxbd            xm5, [matrixq]
+    pmulld              xm5, xm4
+    paddd               xm0, xm5
+%else
+%assign i 0
+%rep regs
+    pmovsxbd             m5, [matrixq + i * 8]
+    pmulld               m5, m4
+    paddd            m %+ i, m5
+%assign i i + 1
+%endrep
+%endif
+    add                srcq, strideq
+    add             matrixq, %1
+    dec                 nzq
+    jnz .loop
+
+.store:
+    cmp             strideq, 4
+    jne .store_strided
+%if %1 == 4
+    movu          [coeffsq], xm0
+%else
+%assign i 0
+%rep regs
+    movu [coeffsq + i * mmsize], m %+ i
+%assign i i + 1
+%endrep
+%endif
+    RET
+
+.store_strided:
+    lea            stride3q, [strideq * 3]
+%if %1 == 4
+    STORE_DWORDS        xm0
+%else
+%assign i 0
+%rep regs
+    STORE_DWORDS     xm %+ i
+    vextracti128        xm5, m %+ i, 1
+    STORE_DWORDS        xm5
+%assign i i + 1
+%endrep
+%endif
+    RET
+%endmacro
+
+INIT_YMM avx2
+INV_MATRIX_MUL  4
+INV_MATRIX_MUL  8
+INV_MATRIX_MUL 16
+INV_MATRIX_MUL 32
+
+%endif
+%endif
@@ -0,0 +1,129 @@
+;******************************************************************************
+;* VVC luma mapping with chroma scaling SIMD optimizations
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA
+
+pd_255      dd 255
+pd_65535    dd 65535
+
+SECTION .text
+
+%if ARCH_X86_64
+%if HAVE_AVX2_EXTERNAL
+
+%macro LOAD_INDICES 2 ; dst, src
+%if ps == 2
+    pmovzxwd             %1, %2
+%else
+    pmovzxbd             %1, %2
+%endif
+%endmacro
+
+; The gathers read a dword per pixel, so the lookup table must be readable
+; for 2 bytes (3 at 8 bit) past its last entry.
+%macro LUT_GATHER 4 ; dst, indices, tmp mask, pixel mask
+    pcmpeqd              %3, %3
+    vpgatherdd           %1, [lutq + %2 * ps], %3
+    pand                 %1, %4
+%endmacro
+
+;void ff_vvc_lmcs_filter_%1bpc_avx2(uint8_t *dst, ptrdiff_t dst_stride,
+;    int width, int height, const void *lut);
+%macro LMCS_FILTER 1
+%assign ps %1 / 8
+cglobal vvc_lmcs_filter_%1bpc, 5, 7, 6, dst, dst_stride, width, height, lut, x, tmp
+    movsxd           widthq, widthd
+%if ps == 2
+    vpbroadcastd         m4, [pd_65535]
+%else
+    vpbroadcastd         m4, [pd_255]
+%endif
+
+.loop_y:
+    xor                  xd, xd
+.loop_x:
+    mov                tmpq, widthq
+    sub                tmpq, xq
+    cmp                tmpq, 16
+    jl .w8
+
+    LOAD_INDICES         m0, [dstq + xq * ps]
+    LOAD_INDICES         m1, [dstq + xq * ps + 8 * ps]
+    LUT_GATHER           m2, m0, m5, m4
+    LUT_GATHER           m3, m1, m5, m4
+    packusdw             m2, m3
+    vpermq               m2, m2, q3120
+%if ps == 2
+    movu     [dstq + xq * 2], m2
+%else
+    vextracti128        xm3, m2, 1
+    packuswb            xm2, xm3
+    movu         [dstq + xq], xm2
+%endif
+    add                  xq, 16
+    cmp                  xq, widthq
+    jl .loop_x
+    jmp .next_row
+
+.w8:
+    cmp                tmpq, 8
+    jl .w4
+
+    LOAD_INDICES         m0, [dstq + xq * ps]
+    LUT_GATHER           m2, m0, m5, m4
+    vextracti128        xm3, m2, 1
+    packusdw            xm2, xm3
+%if ps == 2
+    movu     [dstq + xq * 2], xm2
+%else
+    packuswb            xm2, xm2
+    movq         [dstq + xq], xm2
+%endif
+    add                  xq, 8
+    cmp                  xq, widthq
+    jge .next_row
+
+; the widths are multiples of 4, so at most 4 pixels are left
+.w4:
+    LOAD_INDICES        xm0, [dstq + xq * ps]
+    LUT_GATHER          xm2, xm0, xm5, xm4
+    packusdw            xm2, xm2
+%if ps == 2
+    movq     [dstq + xq * 2], xm2
+%else
+    packuswb            xm2, xm2
+    movd         [dstq + xq], xm2
+%endif
+
+.next_row:
+    add                dstq, dst_strideq
+    dec             heightd
+    jg .loop_y
+    RET
+%endmacro
+
+INIT_YMM avx2
+LMCS_FILTER  8
+LMCS_FILTER 16
+
+%endif
+%endif
@@ -28,6 +28,7 @@
 #include "libavutil/x86/cpu.h"
 #include "libavcodec/vvc/vvcdec.h"
 #include "libavcodec/vvc/vvc_ctu.h"
+#include "libavcodec/vvc/vvc_data.h"
 #include "libavcodec/vvc/vvcdsp.h"
 #include "libavcodec/x86/h26x/h2656dsp.h"
 
@@ -205,6 +206,123 @@ AVG_FUNCS(16, 12, avx2)
     c->inter.avg    = bf(avg, bd, opt);                                 \
     c->inter.w_avg  = bf(w_avg, bd, opt);                               \
 } while (0)
+
+#define ALF_BPC_FUNCS(bpc, opt)                                                                         \
+void BF(ff_vvc_alf_filter_luma, bpc, opt)(uint8_t *dst, ptrdiff_t dst_stride,                           \
+    const uint8_t *src, ptrdiff_t src_stride, ptrdiff_t width, ptrdiff_t height,                        \
+    const int16_t *filter, const int16_t *clip, ptrdiff_t vb_pos, ptrdiff_t pixel_max);                 \
+void BF(ff_vvc_alf_filter_chroma, bpc, opt)(uint8_t *dst, ptrdiff_t dst_stride,                         \
+    const uint8_t *src, ptrdiff_t src_stride, ptrdiff_t width, ptrdiff_t height,                        \
+    const int16_t *filter, const int16_t *clip, ptrdiff_t vb_pos, ptrdiff_t pixel_max);
+
+#define ALF_FUNCS(bpc, bd, opt)                                                                         \
+static void bf(alf_filter_luma, bd, opt)(uint8_t *dst, ptrdiff_t dst_stride,                            \
+    const uint8_t *src, ptrdiff_t src_stride, int width, int height,                                    \
+    const int16_t *filter, const int16_t *clip, int vb_pos)                                             \
+{                                                                                                       \
+    BF(ff_vvc_alf_filter_luma, bpc, opt)(dst, dst_stride, src, src_stride, width, height,               \
+        filter, clip, vb_pos, (1 << bd) - 1);                                                           \
+}                                                                                                       \
+static void bf(alf_filter_chroma, bd, opt)(uint8_t *dst, ptrdiff_t dst_stride,                          \
+    const uint8_t *src, ptrdiff_t src_stride, int width, int height,                                    \
+    const int16_t *filter, const int16_t *clip, int vb_pos)                                             \
+{                                                                                                       \
+    BF(ff_vvc_alf_filter_chroma, bpc, opt)(dst, dst_stride, src, src_stride, width, height,             \
+        filter, clip, vb_pos, (1 << bd) - 1);                                                           \
+}
+
+ALF_BPC_FUNCS(8,  avx2)
+ALF_BPC_FUNCS(16, avx2)
+
+ALF_FUNCS(8,  8,  avx2)
+ALF_FUNCS(16, 10, avx2)
+ALF_FUNCS(16, 12, avx2)
+
+#define ALF_INIT(bd, opt) do {                                          \
+    c->alf.filter[LUMA]   = bf(alf_filter_luma, bd, opt);               \
+    c->alf.filter[CHROMA] = bf(alf_filter_chroma, bd, opt);             \
+} while (0)
+
+#define ITX_MATRIX_MUL_FUNC(size, opt)                                                                  \
+void ff_vvc_inv_matrix_mul_##size##_##opt(int *coeffs, ptrdiff_t stride, const int8_t *matrix, size_t nz);
+
+#define ITX_MATRIX_FUNC(type, size, opt)                                                                \
+static void vvc_inv_##type##_##size##_##opt(int *coeffs, ptrdiff_t stride, size_t nz)                   \
+{                                                                                                       \
+    ff_vvc_inv_matrix_mul_##size##_##opt(coeffs, stride, &ff_vvc_##type##_##size##x##size[0][0], nz);   \
+}
+
+#define ITX_MATRIX_FUNCS(size, opt)                                                                     \
+    ITX_MATRIX_MUL_FUNC(size, opt)                                                                      \
+    ITX_MATRIX_FUNC(dst7, size, opt)                                                                    \
+    ITX_MATRIX_FUNC(dct8, size, opt)
+
+ITX_MATRIX_FUNCS( 4, avx2)
+ITX_MATRIX_FUNCS( 8, avx2)
+ITX_MATRIX_FUNCS(16, avx2)
+ITX_MATRIX_FUNCS(32, avx2)
+
+#define ITX_MATRIX_LINK(size, opt) do {                                 \
+    c->itx.itx[DST7][TX_SIZE_##size] = vvc_inv_dst7_##size##_##opt;     \
+    c->itx.itx[DCT8][TX_SIZE_##size] = vvc_inv_dct8_##size##_##opt;     \
+} while (0)
+
+// DCT-2 keeps the C partial butterfly, which needs fewer multiplies than
+// a matrix product. DCT-2, CC-ALF and the deblocking filters have no SIMD
+// versions yet.
+#define ITX_INIT(opt) do {                                              \
+    ITX_MATRIX_LINK( 4, opt);                                           \
+    ITX_MATRIX_LINK( 8, opt);                                           \
+    ITX_MATRIX_LINK(16, opt);                                           \
+    ITX_MATRIX_LINK(32, opt);                                           \
+} while (0)
+
+void ff_vvc_lmcs_filter_8bpc_avx2(uint8_t *dst, ptrdiff_t dst_stride, int width, int height, const void *lut);
+void ff_vvc_lmcs_filter_16bpc_avx2(uint8_t *dst, ptrdiff_t dst_stride, int width, int height, const void *lut);
+
+#define SAO_BAND_FILTER_FUNC(w, bd, opt)                                                                   \
+void ff_vvc_sao_band_filter_##w##_##bd##_##opt(uint8_t *_dst, const uint8_t *_src, ptrdiff_t _stride_dst,  \
+    ptrdiff_t _stride_src, const int16_t *sao_offset_val, int sao_left_class, int width, int height);
+
+#define SAO_EDGE_FILTER_FUNC(w, bd, opt)                                                                   \
+void ff_vvc_sao_edge_filter_##w##_##bd##_##opt(uint8_t *_dst, const uint8_t *_src, ptrdiff_t stride_dst,   \
+    const int16_t *sao_offset_val, int eo, int width, int height);
+
+#define SAO_FILTER_FUNCS(w, bd, opt)                                                                       \
+    SAO_BAND_FILTER_FUNC(w, bd, opt)                                                                       \
+    SAO_EDGE_FILTER_FUNC(w, bd, opt)
+
+#define SAO_FILTER_FUNCS_ALL(bd, opt)                                                                      \
+    SAO_FILTER_FUNCS(8,   bd, opt)                                                                         \
+    SAO_FILTER_FUNCS(16,  bd, opt)                                                                         \
+    SAO_FILTER_FUNCS(32,  bd, opt)                                                                         \
+    SAO_FILTER_FUNCS(48,  bd, opt)                                                                         \
+    SAO_FILTER_FUNCS(64,  bd, opt)                                                                         \
+    SAO_FILTER_FUNCS(80,  bd, opt)                                                                         \
+    SAO_FILTER_FUNCS(96,  bd, opt)                                                                         \
+    SAO_FILTER_FUNCS(112, bd, opt)                                                                         \
+    SAO_FILTER_FUNCS(128, bd, opt)
+
+SAO_FILTER_FUNCS_ALL(8,  avx2)
+SAO_FILTER_FUNCS_ALL(10, avx2)
+SAO_FILTER_FUNCS_ALL(12, avx2)
+
+#define SAO_FILTER_LINK(i, w, bd, opt) do {                             \
+    c->sao.band_filter[i] = ff_vvc_sao_band_filter_##w##_##bd##_##opt;  \
+    c->sao.edge_filter[i] = ff_vvc_sao_edge_filter_##w##_##bd##_##opt;  \
+} while (0)
+
+#define SAO_INIT(bd, opt) do {                                          \
+    SAO_FILTER_LINK(0,   8, bd, opt);                                   \
+    SAO_FILTER_LINK(1,  16, bd, opt);                                   \
+    SAO_FILTER_LINK(2,  32, bd, opt);                                   \
+    SAO_FILTER_LINK(3,  48, bd, opt);                                   \
+    SAO_FILTER_LINK(4,  64, bd, opt);                                   \
+    SAO_FILTER_LINK(5,  80, bd, opt);                                   \
+    SAO_FILTER_LINK(6,  96, bd, opt);                                   \
+    SAO_FILTER_LINK(7, 112, bd, opt);                                   \
+    SAO_FILTER_LINK(8, 128, bd, opt);                                   \
+} while (0)
 #endif
 
 void ff_vvc_dsp_init_x86(VVCDSPContext *const c, const int bd)
@@ -237,16 +355,27 @@ void ff_vvc_dsp_init_x86(VVCDSPContext *const c, const int bd)
         }
     }
 
+    if (EXTERNAL_AVX2(cpu_flags) && !(cpu_flags & AV_CPU_FLAG_SLOW_GATHER))
+        c->lmcs.filter = bd == 8 ? ff_vvc_lmcs_filter_8bpc_avx2 : ff_vvc_lmcs_filter_16bpc_avx2;
+
     if (EXTERNAL_AVX2(cpu_flags)) {
+        ITX_INIT(avx2);
+
         switch (bd) {
             case 8:
                 AVG_INIT(8, avx2);
+                SAO_INIT(8, avx2);
+                ALF_INIT(8, avx2);
                 break;
             case 10:
                 AVG_INIT(10, avx2);
+                SAO_INIT(10, avx2);
+                ALF_INIT(10, avx2);
                 break;
             case 12:
                 AVG_INIT(12, avx2);
+                SAO_INIT(12, avx2);
+                ALF_INIT(12, avx2);
                 break;
             default:
                 break;
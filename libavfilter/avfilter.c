@@ -234,6 +234,8 @@ static void update_link_current_pts(FilterLinkInternal *li, int64_t pts)
 void ff_filter_set_ready(AVFilterContext *filter, unsigned priority)
 {
     filter->ready = FFMAX(filter->ready, priority);
+    if (filter->graph && fffiltergraph(filter->graph)->use_ready_list)
+        ff_filter_graph_queue_ready(filter->graph, filter);
 }
 
 /**
@@ -647,8 +649,9 @@ static const AVClass *filter_child_class_iterate(void **iter)
 #define TFLAGS AV_OPT_FLAG_FILTERING_PARAM|AV_OPT_FLAG_RUNTIME_PARAM
 static const AVOption avfilter_options[] = {
     { "thread_type", "Allowed thread types", OFFSET(thread_type), AV_OPT_TYPE_FLAGS,
-        { .i64 = AVFILTER_THREAD_SLICE }, 0, INT_MAX, FLAGS, .unit = "thread_type" },
+        { .i64 = AVFILTER_THREAD_SLICE | AVFILTER_THREAD_GRAPH }, 0, INT_MAX, FLAGS, .unit = "thread_type" },
         { "slice", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_SLICE }, .flags = FLAGS, .unit = "thread_type" },
+        { "graph", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_GRAPH }, .flags = FLAGS, .unit = "thread_type" },
     { "enable", "set enable expression", OFFSET(enable_str), AV_OPT_TYPE_STRING, {.str=NULL}, .flags = TFLAGS },
     { "threads", "Allowed number of threads", OFFSET(nb_threads), AV_OPT_TYPE_INT,
         { .i64 = 0 }, 0, INT_MAX, FLAGS },
@@ -921,6 +924,10 @@ int avfilter_init_dict(AVFilterContext *ctx, AVDictionary **options)
         fffiltergraph(ctx->graph)->thread_execute) {
         ctx->thread_type       = AVFILTER_THREAD_SLICE;
         ctxi->execute    = fffiltergraph(ctx->graph)->thread_execute;
+    } else if (ctx->thread_type & ctx->graph->thread_type & AVFILTER_THREAD_GRAPH &&
+               !(ctx->filter->flags_internal & FF_FILTER_FLAG_SENDS_COMMANDS) &&
+               fffiltergraph(ctx->graph)->thread_execute) {
+        ctx->thread_type = AVFILTER_THREAD_GRAPH;
     } else {
         ctx->thread_type = 0;
     }
@@ -403,6 +403,12 @@ unsigned avfilter_filter_pad_count(const AVFilter *filter, int is_output);
  */
 #define AVFILTER_THREAD_SLICE (1 << 0)
 
+/**
+ * Run filters on independent branches of the graph concurrently. Filters
+ * using slice threading are never run concurrently with other filters.
+ */
+#define AVFILTER_THREAD_GRAPH (1 << 1)
+
 /** An instance of a filter */
 struct AVFilterContext {
     const AVClass *av_class;        ///< needed for av_log() and filters common options
@@ -429,7 +435,9 @@ struct AVFilterContext {
      *
      * May be set by the caller before initializing the filter to forbid some
      * or all kinds of multithreading for this filter. The default is allowing
-     * everything.
+     * everything, so that unless forbidden here, AVFilterGraph.thread_type
+     * alone decides; it is the graph default that keeps AVFILTER_THREAD_GRAPH
+     * disabled.
      *
      * When the filter is initialized, this field is combined using bit AND with
      * AVFilterGraph.thread_type to get the final mask used for determining
@@ -822,7 +830,11 @@ typedef struct AVFilterGraph {
      * of AVFILTER_THREAD_* flags.
      *
      * May be set by the caller at any point, the setting will apply to all
-     * filters initialized after that. The default is allowing everything.
+     * filters initialized after that. The default is AVFILTER_THREAD_SLICE,
+     * AVFILTER_THREAD_GRAPH has to be enabled explicitly here, since the caller
+     * must make sure that its own code driving the graph is safe to run
+     * concurrently with the filters. AVFilterContext.thread_type allows
+     * everything by default, so that this field alone decides.
      *
      * When a filter in this graph is initialized, this field is combined using
      * bit AND with AVFilterContext.thread_type to get the final mask used for
@@ -860,6 +872,17 @@ typedef struct AVFilterGraph {
     avfilter_execute_func *execute;
 
     char *aresample_swr_opts; ///< swr options to use for the auto-inserted aresample filters, Access ONLY through AVOptions
+
+    /**
+     * A reference to a thread pool created with av_thread_pool_alloc(). May be
+     * set by the caller before adding any filters to the filtergraph, the
+     * graph's threading and the scalers of its scale filters will then run on
+     * the pool instead of creating their own threads. nb_threads limits the
+     * number of the pool's threads working for the graph at the same time.
+     *
+     * Owned and freed by the graph afterwards.
+     */
+    AVBufferRef *thread_pool;
 } AVFilterGraph;
 
 /**
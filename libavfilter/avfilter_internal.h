@@ -106,6 +106,28 @@ typedef struct FFFilterGraph {
     void *thread;
     avfilter_execute_func *thread_execute;
     FFFrameQueueGlobal frame_queues;
+
+    /**
+     * Filters activated concurrently by ff_filter_graph_run_once() with
+     * AVFILTER_THREAD_GRAPH, and their return codes.
+     */
+    AVFilterContext **batch;
+    int              *batch_ret;
+    unsigned          batch_size;
+    unsigned          batch_mark;
+    int               in_batch;
+
+    /**
+     * Filters which were marked ready since they were last activated, so that
+     * ff_filter_graph_run_once() does not have to scan the whole graph with
+     * AVFILTER_THREAD_GRAPH. Entries whose ready field was cleared since are
+     * dropped lazily. Each filter is listed at most once, so the array has
+     * room for all filters of the graph. The list is only maintained while
+     * use_ready_list is set, i.e. while graph threading is in use.
+     */
+    AVFilterContext **ready_list;
+    unsigned       nb_ready;
+    int            use_ready_list;
 } FFFilterGraph;
 
 static inline FFFilterGraph *fffiltergraph(AVFilterGraph *graph)
@@ -134,6 +156,11 @@ AVFilterContext *ff_filter_alloc(const AVFilter *filter, const char *inst_name);
  */
 void ff_filter_graph_remove_filter(AVFilterGraph *graph, AVFilterContext *filter);
 
+/**
+ * Add a filter whose ready field was set to the ready list of its graph.
+ */
+void ff_filter_graph_queue_ready(AVFilterGraph *graph, AVFilterContext *filter);
+
 int ff_filter_activate(AVFilterContext *filter);
 
 /**
@@ -48,6 +48,7 @@ static const AVOption filtergraph_options[] = {
     { "thread_type", "Allowed thread types", OFFSET(thread_type), AV_OPT_TYPE_FLAGS,
         { .i64 = AVFILTER_THREAD_SLICE }, 0, INT_MAX, F|V|A, .unit = "thread_type" },
         { "slice", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_SLICE }, .flags = F|V|A, .unit = "thread_type" },
+        { "graph", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_GRAPH }, .flags = F|V|A, .unit = "thread_type" },
     { "threads",     "Maximum number of threads", OFFSET(nb_threads), AV_OPT_TYPE_INT,
         { .i64 = 0 }, 0, INT_MAX, F|V|A, .unit = "threads"},
         {"auto", "autodetect a suitable number of threads to use", 0, AV_OPT_TYPE_CONST, {.i64 = 0 }, .flags = F|V|A, .unit = "threads"},
@@ -100,6 +101,15 @@ void ff_filter_graph_remove_filter(AVFilterGraph *graph, AVFilterContext *filter
     int i, j;
     for (i = 0; i < graph->nb_filters; i++) {
         if (graph->filters[i] == filter) {
+            FFFilterGraph *graphi = fffiltergraph(graph);
+
+            if (fffilterctx(filter)->ready_queued) {
+                for (j = 0; graphi->ready_list[j] != filter; j++)
+                    ;
+                graphi->ready_list[j] = graphi->ready_list[--graphi->nb_ready];
+                fffilterctx(filter)->ready_queued = 0;
+            }
+
             FFSWAP(AVFilterContext*, graph->filters[i],
                    graph->filters[graph->nb_filters - 1]);
             graph->nb_filters--;
@@ -125,9 +135,14 @@ void avfilter_graph_free(AVFilterGraph **graphp)
         avfilter_free(graph->filters[0]);
 
     ff_graph_thread_free(graphi);
+    av_buffer_unref(&graph->thread_pool);
 
     av_freep(&graphi->sink_links);
 
+    av_freep(&graphi->batch);
+    av_freep(&graphi->batch_ret);
+    av_freep(&graphi->ready_list);
+
     av_opt_free(graph);
 
     av_freep(&graph->filters);
@@ -185,6 +200,11 @@ AVFilterContext *avfilter_graph_alloc_filter(AVFilterGraph *graph,
         return NULL;
     graph->filters = filters;
 
+    filters = av_realloc_array(graphi->ready_list, graph->nb_filters + 1, sizeof(*filters));
+    if (!filters)
+        return NULL;
+    graphi->ready_list = filters;
+
     s = ff_filter_alloc(filter, name);
     if (!s)
         return NULL;
@@ -1417,12 +1437,207 @@ int avfilter_graph_request_oldest(AVFilterGraph *graph)
     return 0;
 }
 
+static int batch_is_free(AVFilterContext *filter, unsigned mark)
+{
+    if (fffilterctx(filter)->batch_mark == mark)
+        return 0;
+    for (unsigned i = 0; i < filter->nb_inputs; i++)
+        if (filter->inputs[i] &&
+            fffilterctx(filter->inputs[i]->src)->batch_mark == mark)
+            return 0;
+    for (unsigned i = 0; i < filter->nb_outputs; i++)
+        if (filter->outputs[i] &&
+            fffilterctx(filter->outputs[i]->dst)->batch_mark == mark)
+            return 0;
+    return 1;
+}
+
+static void batch_mark(AVFilterContext *filter, unsigned mark)
+{
+    fffilterctx(filter)->batch_mark = mark;
+    for (unsigned i = 0; i < filter->nb_inputs; i++)
+        if (filter->inputs[i])
+            fffilterctx(filter->inputs[i]->src)->batch_mark = mark;
+    for (unsigned i = 0; i < filter->nb_outputs; i++)
+        if (filter->outputs[i])
+            fffilterctx(filter->outputs[i]->dst)->batch_mark = mark;
+}
+
+/**
+ * Check whether activating the filter may update the sink links heap.
+ */
+static int batch_touches_sink(AVFilterContext *filter)
+{
+    for (unsigned i = 0; i < filter->nb_inputs; i++)
+        if (filter->inputs[i] && ff_link_internal(filter->inputs[i])->age_index >= 0)
+            return 1;
+    for (unsigned i = 0; i < filter->nb_outputs; i++)
+        if (filter->outputs[i] && ff_link_internal(filter->outputs[i])->age_index >= 0)
+            return 1;
+    return 0;
+}
+
+/**
+ * Collect the ready filters that can be activated together with the given
+ * one. Activating a filter only touches its own links and the state of its
+ * immediate neighbours, so filters whose neighbourhoods do not overlap are
+ * independent of each other.
+ *
+ * @return number of filters in graphi->batch, 0 on allocation failure
+ */
+static unsigned batch_collect(FFFilterGraph *graphi, AVFilterContext *first)
+{
+    AVFilterGraph *graph = &graphi->p;
+    unsigned nb_batch = 0, mark;
+    int sink_used;
+
+    if (graphi->batch_size < graph->nb_filters) {
+        av_freep(&graphi->batch);
+        av_freep(&graphi->batch_ret);
+        graphi->batch_size = 0;
+
+        graphi->batch     = av_malloc_array(graph->nb_filters, sizeof(*graphi->batch));
+        graphi->batch_ret = av_malloc_array(graph->nb_filters, sizeof(*graphi->batch_ret));
+        if (!graphi->batch || !graphi->batch_ret)
+            return 0;
+        graphi->batch_size = graph->nb_filters;
+    }
+
+    mark = ++graphi->batch_mark;
+    if (!mark)
+        mark = graphi->batch_mark = 1;
+
+    graphi->batch[nb_batch++] = first;
+    batch_mark(first, mark);
+    sink_used = batch_touches_sink(first);
+
+    for (unsigned i = 0; i < graphi->nb_ready; i++) {
+        AVFilterContext *filter = graphi->ready_list[i];
+        int touches_sink;
+
+        if (!filter->ready || !(filter->thread_type & AVFILTER_THREAD_GRAPH) ||
+            !batch_is_free(filter, mark))
+            continue;
+
+        touches_sink = batch_touches_sink(filter);
+        if (touches_sink && sink_used)
+            continue;
+        sink_used |= touches_sink;
+
+        graphi->batch[nb_batch++] = filter;
+        batch_mark(filter, mark);
+    }
+
+    return nb_batch;
+}
+
+static int batch_activate(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    FFFilterGraph *graphi = arg;
+    return ff_filter_activate(graphi->batch[jobnr]);
+}
+
+void ff_filter_graph_queue_ready(AVFilterGraph *graph, AVFilterContext *filter)
+{
+    FFFilterGraph   *graphi = fffiltergraph(graph);
+    FFFilterContext *ctxi   = fffilterctx(filter);
+
+    /* the filters of a batch only mark themselves and their neighbours
+     * ready, they are queued once the batch is done */
+    if (!graphi->use_ready_list || !filter->ready || ctxi->ready_queued ||
+        graphi->in_batch)
+        return;
+    ctxi->ready_queued = 1;
+    graphi->ready_list[graphi->nb_ready++] = filter;
+}
+
+static void batch_queue_ready(AVFilterGraph *graph, AVFilterContext *filter)
+{
+    ff_filter_graph_queue_ready(graph, filter);
+    for (unsigned i = 0; i < filter->nb_inputs; i++)
+        if (filter->inputs[i])
+            ff_filter_graph_queue_ready(graph, filter->inputs[i]->src);
+    for (unsigned i = 0; i < filter->nb_outputs; i++)
+        if (filter->outputs[i])
+            ff_filter_graph_queue_ready(graph, filter->outputs[i]->dst);
+}
+
+/**
+ * Pick the next filter to activate from the ready list, dropping the filters
+ * which are no longer ready.
+ */
+static AVFilterContext *ready_list_pick(FFFilterGraph *graphi)
+{
+    AVFilterContext *filter = NULL;
+    unsigned nb_ready = 0;
+
+    for (unsigned i = 0; i < graphi->nb_ready; i++) {
+        AVFilterContext *f = graphi->ready_list[i];
+
+        if (!f->ready) {
+            fffilterctx(f)->ready_queued = 0;
+            continue;
+        }
+        graphi->ready_list[nb_ready++] = f;
+        if (!filter || f->ready > filter->ready)
+            filter = f;
+    }
+    graphi->nb_ready = nb_ready;
+
+    return filter;
+}
+
+static int run_once_batch(FFFilterGraph *graphi)
+{
+    AVFilterContext *filter = ready_list_pick(graphi);
+    unsigned i, nb_batch;
+    int ret = 0;
+
+    if (!filter)
+        return AVERROR(EAGAIN);
+
+    if (!(filter->thread_type & AVFILTER_THREAD_GRAPH))
+        return ff_filter_activate(filter);
+
+    nb_batch = batch_collect(graphi, filter);
+    if (nb_batch <= 1)
+        return ff_filter_activate(filter);
+
+    graphi->in_batch = 1;
+    graphi->thread_execute(filter, batch_activate, graphi, graphi->batch_ret, nb_batch);
+    graphi->in_batch = 0;
+
+    for (i = 0; i < nb_batch; i++) {
+        batch_queue_ready(&graphi->p, graphi->batch[i]);
+        if (!ret && graphi->batch_ret[i] < 0)
+            ret = graphi->batch_ret[i];
+    }
+    return ret;
+}
+
 int ff_filter_graph_run_once(AVFilterGraph *graph)
 {
+    FFFilterGraph *graphi = fffiltergraph(graph);
     AVFilterContext *filter;
     unsigned i;
 
     av_assert0(graph->nb_filters);
+    if (graph->thread_type & AVFILTER_THREAD_GRAPH && graphi->thread_execute) {
+        if (!graphi->use_ready_list) {
+            graphi->use_ready_list = 1;
+            for (i = 0; i < graph->nb_filters; i++)
+                ff_filter_graph_queue_ready(graph, graph->filters[i]);
+        }
+        return run_once_batch(graphi);
+    }
+
+    if (graphi->use_ready_list) {
+        for (i = 0; i < graphi->nb_ready; i++)
+            fffilterctx(graphi->ready_list[i])->ready_queued = 0;
+        graphi->nb_ready       = 0;
+        graphi->use_ready_list = 0;
+    }
+
     filter = graph->filters[0];
     for (i = 1; i < graph->nb_filters; i++)
         if (graph->filters[i]->ready > filter->ready)
@@ -124,6 +124,13 @@ typedef struct FFFilterContext {
     // 1 when avfilter_init_*() was successfully called on this filter
     // 0 otherwise
     int initialized;
+
+    // set to FFFilterGraph.batch_mark when this filter or one of its
+    // neighbours is part of the batch being built by ff_filter_graph_run_once()
+    unsigned batch_mark;
+
+    // 1 when this filter is in FFFilterGraph.ready_list
+    int ready_queued;
 } FFFilterContext;
 
 static inline FFFilterContext *fffilterctx(AVFilterContext *ctx)
@@ -350,6 +357,12 @@ int ff_filter_frame(AVFilterLink *link, AVFrame *frame);
  */
 #define FF_FILTER_FLAG_HWFRAME_AWARE (1 << 0)
 
+/**
+ * The filter sends commands to other filters of the graph while it is
+ * activated, so it must not run concurrently with them.
+ */
+#define FF_FILTER_FLAG_SENDS_COMMANDS (1 << 1)
+
 /**
  * Run one round of processing on a filter graph.
  */
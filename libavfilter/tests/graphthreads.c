@@ -0,0 +1,153 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Run a filtergraph with the given thread type and number of threads and
+ * print a checksum of every frame it outputs. The sinks are read in turn,
+ * so the output does not depend on the threading.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "libavutil/adler32.h"
+#include "libavutil/frame.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/opt.h"
+#include "libavutil/pixdesc.h"
+#include "libavutil/samplefmt.h"
+
+#include "libavfilter/avfilter.h"
+#include "libavfilter/buffersink.h"
+
+#define MAX_SINKS 16
+
+static uint32_t frame_checksum(const AVFrame *frame)
+{
+    uint32_t crc = 0;
+
+    if (frame->nb_samples) {
+        int planar = av_sample_fmt_is_planar(frame->format);
+        int planes = planar ? frame->ch_layout.nb_channels : 1;
+        int size   = frame->nb_samples * av_get_bytes_per_sample(frame->format) *
+                     (planar ? 1 : frame->ch_layout.nb_channels);
+
+        for (int i = 0; i < planes; i++)
+            crc = av_adler32_update(crc, frame->extended_data[i], size);
+    } else {
+        const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(frame->format);
+
+        for (int i = 0; i < 4 && frame->data[i]; i++) {
+            int h = i == 1 || i == 2 ? AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h) :
+                                       frame->height;
+            int w = av_image_get_linesize(frame->format, frame->width, i);
+
+            for (int y = 0; y < h; y++)
+                crc = av_adler32_update(crc, frame->data[i] + y * frame->linesize[i], w);
+        }
+    }
+
+    return crc;
+}
+
+int main(int argc, char **argv)
+{
+    AVFilterGraph *graph;
+    AVFilterInOut *inputs = NULL, *outputs = NULL, *cur;
+    AVFilterContext *sinks[MAX_SINKS];
+    int eof[MAX_SINKS] = { 0 };
+    AVFrame *frame;
+    int nb_sinks = 0, nb_eof = 0, ret;
+
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s <thread_type> <threads> <filtergraph>\n", argv[0]);
+        return 1;
+    }
+
+    graph = avfilter_graph_alloc();
+    frame = av_frame_alloc();
+    if (!graph || !frame)
+        return 1;
+
+    if ((ret = av_opt_set(graph, "thread_type", argv[1], 0)) < 0 ||
+        (ret = av_opt_set(graph, "threads",     argv[2], 0)) < 0)
+        goto end;
+
+    ret = avfilter_graph_parse2(graph, argv[3], &inputs, &outputs);
+    if (ret < 0)
+        goto end;
+    if (inputs) {
+        fprintf(stderr, "The filtergraph must not have open inputs\n");
+        ret = AVERROR(EINVAL);
+        goto end;
+    }
+
+    for (cur = outputs; cur; cur = cur->next) {
+        enum AVMediaType type = avfilter_pad_get_type(cur->filter_ctx->output_pads, cur->pad_idx);
+        char name[32];
+
+        if (nb_sinks == MAX_SINKS) {
+            ret = AVERROR(EINVAL);
+            goto end;
+        }
+        snprintf(name, sizeof(name), "sink%d", nb_sinks);
+        ret = avfilter_graph_create_filter(&sinks[nb_sinks],
+                                           avfilter_get_by_name(type == AVMEDIA_TYPE_AUDIO ?
+                                                                "abuffersink" : "buffersink"),
+                                           name, NULL, NULL, graph);
+        if (ret < 0)
+            goto end;
+        ret = avfilter_link(cur->filter_ctx, cur->pad_idx, sinks[nb_sinks], 0);
+        if (ret < 0)
+            goto end;
+        nb_sinks++;
+    }
+
+    ret = avfilter_graph_config(graph, NULL);
+    if (ret < 0)
+        goto end;
+
+    while (nb_eof < nb_sinks) {
+        for (int i = 0; i < nb_sinks; i++) {
+            if (eof[i])
+                continue;
+
+            ret = av_buffersink_get_frame(sinks[i], frame);
+            if (ret == AVERROR_EOF) {
+                eof[i] = 1;
+                nb_eof++;
+                continue;
+            } else if (ret < 0)
+                goto end;
+
+            printf("%d, %10"PRId64", 0x%08"PRIx32"\n",
+                   i, frame->pts, frame_checksum(frame));
+            av_frame_unref(frame);
+        }
+    }
+    ret = 0;
+
+end:
+    if (ret < 0)
+        fprintf(stderr, "Error: %s\n", av_err2str(ret));
+    avfilter_inout_free(&inputs);
+    avfilter_inout_free(&outputs);
+    avfilter_graph_free(&graph);
+    av_frame_free(&frame);
+    return ret < 0;
+}
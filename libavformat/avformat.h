@@ -1854,6 +1854,10 @@ typedef struct AVFormatContext {
      * additional internal format contexts. Thus the AVFormatContext pointer
      * passed to this callback may be different from the one facing the caller.
      * It will, however, have the same 'opaque' field.
+     *
+     * @note Some muxers, e.g. hls and dash with the async_io option, call
+     * this callback from a background thread rather than from the thread
+     * calling the muxing functions, so it must be thread-safe then.
      */
     int (*io_open)(struct AVFormatContext *s, AVIOContext **pb, const char *url,
                    int flags, AVDictionary **options);
@@ -1868,8 +1872,32 @@ typedef struct AVFormatContext {
      * @param s the format context
      * @param pb IO context to be closed and freed
      * @return 0 on success, a negative AVERROR code on failure
+     *
+     * @note Like io_open, this may be called from a background thread.
      */
     int (*io_close2)(struct AVFormatContext *s, AVIOContext *pb);
+
+    /**
+     * Directory of a persistent cache for avformat_find_stream_info().
+     *
+     * When set, the stream information of seekable inputs whose streams are
+     * all known after avformat_open_input() is stored there, keyed by the
+     * input size, modification time and first bytes. Later calls on the same
+     * input load it back instead of reading and decoding packets.
+     *
+     * - demuxing: Set by user.
+     */
+    char *stream_info_cache;
+
+    /**
+     * Number of threads decoding the streams in parallel during
+     * avformat_find_stream_info(), 0 for automatic. With a value other
+     * than 1, packets are demuxed in batches and the packets of each stream
+     * of a batch are decoded by a separate job.
+     *
+     * - demuxing: Set by user.
+     */
+    int probe_threads;
 } AVFormatContext;
 
 /**
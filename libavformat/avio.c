@@ -463,6 +463,8 @@ int ffio_fdopen(AVIOContext **sp, URLContext *h)
             s->seekable |= AVIO_SEEKABLE_TIME;
     }
     ((FFIOContext*)s)->short_seek_get = ffurl_get_short_seek;
+    if (!(h->flags & AVIO_FLAG_WRITE) && h->prot && h->prot->url_get_mapping)
+        ((FFIOContext*)s)->get_mapping = ffurl_get_mapping;
     s->av_class = &ff_avio_class;
     return 0;
 }
@@ -834,6 +836,15 @@ int ffurl_get_multi_file_handle(URLContext *h, int **handles, int *numhandles)
     return h->prot->url_get_multi_file_handle(h, handles, numhandles);
 }
 
+int ffurl_get_mapping(void *urlcontext, int64_t pos, int size, const uint8_t **data)
+{
+    URLContext *h = urlcontext;
+
+    if (!h || !h->prot || !h->prot->url_get_mapping)
+        return AVERROR(ENOSYS);
+    return h->prot->url_get_mapping(h, pos, size, data);
+}
+
 int ffurl_get_short_seek(void *urlcontext)
 {
     URLContext *h = urlcontext;
@@ -76,6 +76,13 @@ typedef struct FFIOContext {
      * is updated each time a successful writeout ends up further position-wise
      */
     int64_t written_output_size;
+
+    /**
+     * Return a pointer to size bytes at pos in a read-only memory mapping
+     * of the resource, if the protocol provides one; used by
+     * ffio_read_indirect() to avoid copies.
+     */
+    int (*get_mapping)(void *opaque, int64_t pos, int size, const uint8_t **data);
 } FFIOContext;
 
 static av_always_inline FFIOContext *ffiocontext(AVIOContext *ctx)
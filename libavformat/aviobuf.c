@@ -670,14 +670,35 @@ int ffio_read_size(AVIOContext *s, unsigned char *buf, int size)
 
 int ffio_read_indirect(AVIOContext *s, unsigned char *buf, int size, const unsigned char **data)
 {
+    FFIOContext *const ctx = ffiocontext(s);
+
     if (s->buf_end - s->buf_ptr >= size && !s->write_flag) {
         *data = s->buf_ptr;
         s->buf_ptr += size;
         return size;
-    } else {
-        *data = buf;
-        return avio_read(s, buf, size);
     }
+    if (ctx->get_mapping && !s->write_flag && !s->update_checksum && s->seek) {
+        /* Hand out the data straight from the mapping and move the
+         * underlying position past it, leaving the buffer empty. */
+        int64_t pos = avio_tell(s);
+        const uint8_t *map;
+
+        if (pos >= 0 && size >= 0 && ctx->get_mapping(s->opaque, pos, size, &map) >= 0 &&
+            s->seek(s->opaque, pos + size, SEEK_SET) >= 0) {
+            /* the same bookkeeping as a seek outside the buffer in
+             * avio_seek(), and as a read in fill_buffer() */
+            *data = map;
+            ctx->seek_count++;
+            s->buf_end = s->buf_ptr = s->buf_ptr_max = s->buffer;
+            s->pos = pos + size;
+            s->eof_reached = 0;
+            ctx->bytes_read += size;
+            s->bytes_read    = ctx->bytes_read;
+            return size;
+        }
+    }
+    *data = buf;
+    return avio_read(s, buf, size);
 }
 
 int avio_read_partial(AVIOContext *s, unsigned char *buf, int size)
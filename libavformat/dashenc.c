@@ -50,6 +50,7 @@
 #include "http.h"
 #endif
 #include "internal.h"
+#include "ioqueue.h"
 #include "isom.h"
 #include "mux.h"
 #include "os_support.h"
@@ -75,6 +76,8 @@ enum {
 #define MPD_PROFILE_DASH 1
 #define MPD_PROFILE_DVB  2
 
+#define IO_QUEUE_SIZE 16
+
 typedef struct Segment {
     char file[1024];
     int64_t start_pos;
@@ -188,6 +191,8 @@ typedef struct DASHContext {
     int global_sidx;
     SegmentType segment_type_option;  /* segment type as specified in options */
     int ignore_io_errors;
+    int async_io;
+    FFIOQueue *io_queue;
     int lhls;
     int ldash;
     int master_publish_rate;
@@ -481,6 +486,39 @@ static void set_http_options(AVDictionary **options, DASHContext *c)
         av_dict_set_int(options, "timeout", c->timeout, 0);
 }
 
+static int dashenc_manifest_open(AVFormatContext *s, AVIOContext **pb,
+                                 char *filename, AVDictionary **options)
+{
+    DASHContext *c = s->priv_data;
+
+    if (c->io_queue)
+        return avio_open_dyn_buf(pb);
+    return dashenc_io_open(s, pb, filename, options);
+}
+
+/* Finish a manifest and rename it to final_filename if not NULL */
+static int dashenc_manifest_close(AVFormatContext *s, AVIOContext **pb,
+                                  char *filename, const char *final_filename)
+{
+    DASHContext *c = s->priv_data;
+    AVDictionary *opts = NULL;
+    uint8_t *buffer;
+    int size, ret;
+
+    if (!c->io_queue) {
+        dashenc_io_close(s, pb, filename);
+        return final_filename ? ff_rename(filename, final_filename, s) : 0;
+    }
+
+    size = avio_close_dyn_buf(*pb, &buffer);
+    *pb = NULL;
+    set_http_options(&opts, c);
+    ret = ff_io_queue_write(c->io_queue, filename, &opts, buffer, size);
+    if (ret >= 0 && final_filename)
+        ret = ff_io_queue_rename(c->io_queue, filename, final_filename);
+    return ret;
+}
+
 static void get_hls_playlist_name(char *playlist_name, int string_size,
                                   const char *base_url, int id) {
     if (base_url)
@@ -526,7 +564,7 @@ static void write_hls_media_playlist(OutputStream *os, AVFormatContext *s,
     snprintf(temp_filename_hls, sizeof(temp_filename_hls), use_rename ? "%s.tmp" : "%s", filename_hls);
 
     set_http_options(&http_opts, c);
-    ret = dashenc_io_open(s, &c->m3u8_out, temp_filename_hls, &http_opts);
+    ret = dashenc_manifest_open(s, &c->m3u8_out, temp_filename_hls, &http_opts);
     av_dict_free(&http_opts);
     if (ret < 0) {
         handle_io_open_error(s, ret, temp_filename_hls);
@@ -572,10 +610,8 @@ static void write_hls_media_playlist(OutputStream *os, AVFormatContext *s,
     if (final)
         ff_hls_write_end_list(c->m3u8_out);
 
-    dashenc_io_close(s, &c->m3u8_out, temp_filename_hls);
-
-    if (use_rename)
-        ff_rename(temp_filename_hls, filename_hls, os->ctx);
+    dashenc_manifest_close(s, &c->m3u8_out, temp_filename_hls,
+                           use_rename ? filename_hls : NULL);
 }
 
 static int flush_init_segment(AVFormatContext *s, OutputStream *os)
@@ -633,6 +669,7 @@ static void dash_free(AVFormatContext *s)
     }
     av_freep(&c->streams);
 
+    ff_io_queue_free(&c->io_queue);
     ff_format_io_close(s, &c->mpd_out);
     ff_format_io_close(s, &c->m3u8_out);
     ff_format_io_close(s, &c->http_delete);
@@ -1144,7 +1181,7 @@ static int write_manifest(AVFormatContext *s, int final)
 
     snprintf(temp_filename, sizeof(temp_filename), use_rename ? "%s.tmp" : "%s", s->url);
     set_http_options(&opts, c);
-    ret = dashenc_io_open(s, &c->mpd_out, temp_filename, &opts);
+    ret = dashenc_manifest_open(s, &c->mpd_out, temp_filename, &opts);
     av_dict_free(&opts);
     if (ret < 0) {
         return handle_io_open_error(s, ret, temp_filename);
@@ -1236,12 +1273,10 @@ static int write_manifest(AVFormatContext *s, int final)
 
     avio_printf(out, "</MPD>\n");
     avio_flush(out);
-    dashenc_io_close(s, &c->mpd_out, temp_filename);
-
-    if (use_rename) {
-        if ((ret = ff_rename(temp_filename, s->url, s)) < 0)
-            return ret;
-    }
+    ret = dashenc_manifest_close(s, &c->mpd_out, temp_filename,
+                                 use_rename ? s->url : NULL);
+    if (ret < 0)
+        return ret;
 
     if (c->hls_playlist) {
         char filename_hls[1024];
@@ -1259,7 +1294,7 @@ static int write_manifest(AVFormatContext *s, int final)
         snprintf(temp_filename, sizeof(temp_filename), use_rename ? "%s.tmp" : "%s", filename_hls);
 
         set_http_options(&opts, c);
-        ret = dashenc_io_open(s, &c->m3u8_out, temp_filename, &opts);
+        ret = dashenc_manifest_open(s, &c->m3u8_out, temp_filename, &opts);
         av_dict_free(&opts);
         if (ret < 0) {
             return handle_io_open_error(s, ret, temp_filename);
@@ -1353,10 +1388,10 @@ static int write_manifest(AVFormatContext *s, int final)
             }
         }
 
-        dashenc_io_close(s, &c->m3u8_out, temp_filename);
-        if (use_rename)
-            if ((ret = ff_rename(temp_filename, filename_hls, s)) < 0)
-                return ret;
+        ret = dashenc_manifest_close(s, &c->m3u8_out, temp_filename,
+                                     use_rename ? filename_hls : NULL);
+        if (ret < 0)
+            return ret;
         c->master_playlist_created = 1;
     }
 
@@ -1419,6 +1454,19 @@ static int dash_init(AVFormatContext *s)
         c->global_sidx = 0;
     }
 
+    if (c->async_io) {
+        if (c->single_file || c->streaming || c->http_persistent) {
+            av_log(s, AV_LOG_WARNING, "async_io is not supported with single_file, "
+                   "streaming and http_persistent, disabling it\n");
+        } else {
+            ret = ff_io_queue_alloc(&c->io_queue, s, IO_QUEUE_SIZE);
+            if (ret == AVERROR(ENOSYS))
+                av_log(s, AV_LOG_WARNING, "async_io requires threading support, disabling it\n");
+            else if (ret < 0)
+                return ret;
+        }
+    }
+
     if (c->global_sidx && c->streaming) {
         av_log(s, AV_LOG_WARNING, "Global SIDX option will be ignored as streaming is enabled\n");
         c->global_sidx = 0;
@@ -1848,7 +1896,15 @@ static void dashenc_delete_file(AVFormatContext *s, char *filename) {
     DASHContext *c = s->priv_data;
     int http_base_proto = ff_is_http_proto(filename);
 
-    if (http_base_proto) {
+    if (c->io_queue) {
+        AVDictionary *http_opts = NULL;
+
+        if (http_base_proto) {
+            set_http_options(&http_opts, c);
+            av_dict_set(&http_opts, "method", "DELETE", 0);
+        }
+        ff_io_queue_delete(c->io_queue, filename, http_base_proto ? &http_opts : NULL);
+    } else if (http_base_proto) {
         AVDictionary *http_opts = NULL;
 
         set_http_options(&http_opts, c);
@@ -1904,6 +1960,30 @@ static inline void dashenc_delete_media_segments(AVFormatContext *s, OutputStrea
     memmove(os->segments, os->segments + remove_count, os->nb_segments * sizeof(*os->segments));
 }
 
+/* Hand the segment buffered in os->ctx over to the I/O queue */
+static int dash_queue_segment(AVFormatContext *s, OutputStream *os,
+                              int use_rename, int *range_length)
+{
+    DASHContext *c = s->priv_data;
+    AVDictionary *opts = NULL;
+    uint8_t *buffer;
+    int ret;
+
+    av_write_frame(os->ctx, NULL);
+    *range_length = avio_close_dyn_buf(os->ctx->pb, &buffer);
+    os->ctx->pb = NULL;
+    if ((ret = avio_open_dyn_buf(&os->ctx->pb)) < 0) {
+        av_free(buffer);
+        return ret;
+    }
+
+    set_http_options(&opts, c);
+    ret = ff_io_queue_write(c->io_queue, os->temp_path, &opts, buffer, *range_length);
+    if (ret >= 0 && use_rename)
+        ret = ff_io_queue_rename(c->io_queue, os->temp_path, os->full_path);
+    return ret;
+}
+
 static int dash_flush(AVFormatContext *s, int final, int stream)
 {
     DASHContext *c = s->priv_data;
@@ -1928,6 +2008,10 @@ static int dash_flush(AVFormatContext *s, int final, int stream)
         }
     }
 
+    if (c->io_queue && (ret = ff_io_queue_error(c->io_queue)) < 0 &&
+        !c->ignore_io_errors)
+        return ret;
+
     for (i = 0; i < s->nb_streams; i++) {
         OutputStream *os = &c->streams[i];
         AVStream *st = s->streams[i];
@@ -1955,14 +2039,17 @@ static int dash_flush(AVFormatContext *s, int final, int stream)
         if (c->single_file)
             snprintf(os->full_path, sizeof(os->full_path), "%s%s", c->dirname, os->initfile);
 
-        ret = flush_dynbuf(c, os, &range_length);
+        if (c->io_queue)
+            ret = dash_queue_segment(s, os, use_rename, &range_length);
+        else
+            ret = flush_dynbuf(c, os, &range_length);
         if (ret < 0)
             break;
         os->packets_written = 0;
 
         if (c->single_file) {
             find_index_range(s, os->full_path, os->pos, &index_length);
-        } else {
+        } else if (!c->io_queue) {
             dashenc_io_close(s, &os->out, os->temp_path);
 
             if (use_rename) {
@@ -2254,11 +2341,13 @@ static int dash_write_packet(AVFormatContext *s, AVPacket *pkt)
                  os->filename);
         snprintf(os->temp_path, sizeof(os->temp_path),
                  use_rename ? "%s.tmp" : "%s", os->full_path);
-        set_http_options(&opts, c);
-        ret = dashenc_io_open(s, &os->out, os->temp_path, &opts);
-        av_dict_free(&opts);
-        if (ret < 0) {
-            return handle_io_open_error(s, ret, os->temp_path);
+        if (!c->io_queue) {
+            set_http_options(&opts, c);
+            ret = dashenc_io_open(s, &os->out, os->temp_path, &opts);
+            av_dict_free(&opts);
+            if (ret < 0) {
+                return handle_io_open_error(s, ret, os->temp_path);
+            }
         }
 
         // in streaming mode, the segments are available for playing
@@ -2329,6 +2418,12 @@ static int dash_write_trailer(AVFormatContext *s)
         }
     }
 
+    if (c->io_queue) {
+        int ret = ff_io_queue_flush(c->io_queue);
+        if (ret < 0 && !c->ignore_io_errors)
+            return ret;
+    }
+
     return 0;
 }
 
@@ -2376,6 +2471,7 @@ static const AVOption options[] = {
     { "http_persistent", "Use persistent HTTP connections", OFFSET(http_persistent), AV_OPT_TYPE_BOOL, {.i64 = 0 }, 0, 1, E },
     { "http_user_agent", "override User-Agent field in HTTP header", OFFSET(user_agent), AV_OPT_TYPE_STRING, {.str = NULL}, 0, 0, E},
     { "ignore_io_errors", "Ignore IO errors during open and write. Useful for long-duration runs with network output", OFFSET(ignore_io_errors), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
+    { "async_io", "Write segments and manifests and delete old segments in a background thread", OFFSET(async_io), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
     { "index_correction", "Enable/Disable segment index correction logic", OFFSET(index_correction), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
     { "init_seg_name", "DASH-templated name to used for the initialization segment", OFFSET(init_seg_name), AV_OPT_TYPE_STRING, {.str = "init-stream$RepresentationID$.$ext$"}, 0, 0, E },
     { "ldash", "Enable Low-latency dash. Constrains the value of a few elements", OFFSET(ldash), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
@@ -31,6 +31,7 @@
 #include "libavutil/mathematics.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixfmt.h"
+#include "libavutil/slicethread.h"
 #include "libavutil/time.h"
 #include "libavutil/timestamp.h"
 
@@ -2171,6 +2172,100 @@ fail:
     return ret;
 }
 
+/* Number of packets demuxed before their decoding is run in parallel */
+#define PROBE_DECODE_BATCH 64
+
+typedef struct ProbeDecodeEntry {
+    const AVPacket *pkt;
+    /* codec_info_nb_frames at the time the packet was read */
+    int nb_frames;
+} ProbeDecodeEntry;
+
+/**
+ * Defers the try_decode_frame() calls of avformat_find_stream_info() and
+ * runs them in batches, each stream being decoded by its own job. The
+ * packets of a stream are still decoded in demuxing order.
+ */
+typedef struct ProbeDecodeContext {
+    AVFormatContext *ic;
+    AVDictionary **options;
+    unsigned nb_options;
+    AVSliceThread *thread;
+    ProbeDecodeEntry entries[PROBE_DECODE_BATCH];
+    int nb_entries;
+} ProbeDecodeContext;
+
+static void probe_decode_worker(void *priv, int jobnr, int threadnr,
+                                int nb_jobs, int nb_threads)
+{
+    ProbeDecodeContext *pd = priv;
+    AVStream *st = pd->ic->streams[jobnr];
+    FFStream *const sti = ffstream(st);
+    const int nb_frames = sti->codec_info_nb_frames;
+    /* the options of a stream must only be touched by its own job */
+    AVDictionary **options = pd->options && jobnr < pd->nb_options ?
+                             &pd->options[jobnr] : NULL;
+
+    for (int i = 0; i < pd->nb_entries; i++) {
+        const ProbeDecodeEntry *e = &pd->entries[i];
+        if (e->pkt->stream_index != jobnr)
+            continue;
+        /* try_decode_frame() must see the stream state of a serial run */
+        sti->codec_info_nb_frames = e->nb_frames;
+        try_decode_frame(pd->ic, st, e->pkt, options);
+    }
+    sti->codec_info_nb_frames = nb_frames;
+}
+
+static void probe_decode_flush(ProbeDecodeContext *pd)
+{
+    if (!pd->nb_entries)
+        return;
+    avpriv_slicethread_execute(pd->thread, pd->ic->nb_streams, 0);
+    pd->nb_entries = 0;
+}
+
+static int probe_decode_init(AVFormatContext *ic, AVDictionary **options,
+                             unsigned nb_options, ProbeDecodeContext **ppd)
+{
+    ProbeDecodeContext *pd;
+    int ret;
+
+    *ppd = NULL;
+    /* the packets must stay around until their batch is decoded */
+    if (ic->probe_threads == 1 || ic->flags & AVFMT_FLAG_NOBUFFER)
+        return 0;
+
+    pd = av_mallocz(sizeof(*pd));
+    if (!pd)
+        return AVERROR(ENOMEM);
+    pd->ic         = ic;
+    pd->options    = options;
+    pd->nb_options = nb_options;
+
+    ret = avpriv_slicethread_create(&pd->thread, pd, probe_decode_worker,
+                                    NULL, ic->probe_threads);
+    if (ret <= 1) {
+        /* no threading support or a single thread: decode inline */
+        avpriv_slicethread_free(&pd->thread);
+        av_free(pd);
+        return ret == AVERROR(ENOMEM) ? ret : 0;
+    }
+
+    av_log(ic, AV_LOG_DEBUG, "Decoding probe packets with %d threads\n", ret);
+    *ppd = pd;
+    return 0;
+}
+
+static void probe_decode_free(ProbeDecodeContext **ppd)
+{
+    ProbeDecodeContext *pd = *ppd;
+    if (!pd)
+        return;
+    avpriv_slicethread_free(&pd->thread);
+    av_freep(ppd);
+}
+
 static int chapter_start_cmp(const void *p1, const void *p2)
 {
     const AVChapter *const ch1 = *(AVChapter**)p1;
@@ -2512,6 +2607,8 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
     int64_t probesize = ic->probesize;
     int eof_reached = 0;
     int *missing_streams = av_opt_ptr(ic->iformat->priv_class, ic->priv_data, "missing_streams");
+    char cache_key[FF_STREAM_INFO_CACHE_KEY_SIZE] = "";
+    ProbeDecodeContext *pd = NULL;
 
     flush_codecs = probesize > 0;
 
@@ -2535,6 +2632,19 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
                avio_tell(ic->pb), ctx->bytes_read, ctx->seek_count, ic->nb_streams);
     }
 
+    if (ic->stream_info_cache && ff_stream_info_cache_key(ic, cache_key) >= 0) {
+        ret = ff_stream_info_cache_load(ic, cache_key);
+        if (ret < 0)
+            goto find_stream_info_err;
+        if (ret > 0) {
+            /* nothing left to analyze, the entry is not rewritten either */
+            cache_key[0] = 0;
+            ret = 0;
+            av_opt_set_int(ic, "skip_clear", 0, AV_OPT_SEARCH_CHILDREN);
+            goto stream_info_done;
+        }
+    }
+
     for (unsigned i = 0; i < ic->nb_streams; i++) {
         const AVCodec *codec;
         AVDictionary *thread_opt = NULL;
@@ -2591,6 +2701,10 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
             av_dict_free(&thread_opt);
     }
 
+    ret = probe_decode_init(ic, options, orig_nb_streams, &pd);
+    if (ret < 0)
+        goto find_stream_info_err;
+
     read_size = 0;
     for (;;) {
         const AVPacket *pkt;
@@ -2820,8 +2934,16 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
          * least one frame of codec data, this makes sure the codec initializes
          * the channel configuration and does not only trust the values from
          * the container. */
-        try_decode_frame(ic, st, pkt,
-                         (options && i < orig_nb_streams) ? &options[i] : NULL);
+        if (pd) {
+            ProbeDecodeEntry *e = &pd->entries[pd->nb_entries++];
+            e->pkt       = pkt;
+            e->nb_frames = sti->codec_info_nb_frames;
+            if (pd->nb_entries == PROBE_DECODE_BATCH)
+                probe_decode_flush(pd);
+        } else {
+            try_decode_frame(ic, st, pkt,
+                             (options && i < orig_nb_streams) ? &options[i] : NULL);
+        }
 
         if (ic->flags & AVFMT_FLAG_NOBUFFER)
             av_packet_unref(pkt1);
@@ -2830,6 +2952,15 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
         count++;
     }
 
+    /* an analysis that was interrupted or hit a read error is not cached */
+    if (ret < 0 && ret != AVERROR_EOF)
+        cache_key[0] = 0;
+
+    if (pd) {
+        probe_decode_flush(pd);
+        probe_decode_free(&pd);
+    }
+
     if (eof_reached) {
         for (unsigned stream_index = 0; stream_index < ic->nb_streams; stream_index++) {
             AVStream *const st = ic->streams[stream_index];
@@ -3005,11 +3136,13 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
                    "Could not find codec parameters for stream %d (%s): %s\n"
                    "Consider increasing the value for the 'analyzeduration' (%"PRId64") and 'probesize' (%"PRId64") options\n",
                    i, buf, errmsg, ic->max_analyze_duration, ic->probesize);
+            cache_key[0] = 0;
         } else {
             ret = 0;
         }
     }
 
+stream_info_done:
     err = compute_chapters_end(ic);
     if (err < 0) {
         ret = err;
@@ -3074,7 +3207,11 @@ FF_ENABLE_DEPRECATION_WARNINGS
 #endif
     }
 
+    if (ret >= 0 && cache_key[0] && ic->nb_streams == orig_nb_streams)
+        ff_stream_info_cache_store(ic, cache_key);
+
 find_stream_info_err:
+    probe_decode_free(&pd);
     for (unsigned i = 0; i < ic->nb_streams; i++) {
         AVStream *const st  = ic->streams[i];
         FFStream *const sti = ffstream(st);
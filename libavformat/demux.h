@@ -252,7 +252,8 @@ void ff_configure_buffers_for_index(AVFormatContext *s, int64_t time_tolerance);
 /**
  * Ensure the index uses less memory than the maximum specified in
  * AVFormatContext.max_index_size by discarding entries if it grows
- * too large.
+ * too large. The remaining entries are spread evenly over the indexed
+ * time range.
  */
 void ff_reduce_index(AVFormatContext *s, int stream_index);
 
@@ -349,4 +350,29 @@ int ff_find_stream_index(const AVFormatContext *s, int id);
 
 int ff_buffer_packet(AVFormatContext *s, AVPacket *pkt);
 
+#define FF_STREAM_INFO_CACHE_KEY_SIZE 65
+
+/**
+ * Compute the stream info cache key of the opened input.
+ *
+ * @param key buffer of FF_STREAM_INFO_CACHE_KEY_SIZE bytes
+ * @return 0 on success, a negative AVERROR code if the input cannot be
+ *         cached (e.g. not a local file or streams created while reading)
+ */
+int ff_stream_info_cache_key(AVFormatContext *s, char *key);
+
+/**
+ * Fill the streams from the entry for key in AVFormatContext.stream_info_cache.
+ *
+ * @return 1 if the entry was applied, 0 if there is no usable entry,
+ *         a negative AVERROR code on failure
+ */
+int ff_stream_info_cache_load(AVFormatContext *s, const char *key);
+
+/**
+ * Store the current stream information under key in
+ * AVFormatContext.stream_info_cache.
+ */
+int ff_stream_info_cache_store(AVFormatContext *s, const char *key);
+
 #endif /* AVFORMAT_DEMUX_H */
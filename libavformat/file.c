@@ -38,6 +38,9 @@
 #endif
 #include <sys/stat.h>
 #include <stdlib.h>
+#if HAVE_MMAP
+#include <sys/mman.h>
+#endif
 #include "os_support.h"
 #include "url.h"
 
@@ -86,6 +89,11 @@
 #  endif
 #endif
 
+/* Readahead window requested from the kernel after a seek in a mapped file */
+#define MMAP_WILLNEED_SIZE (4 << 20)
+/* Range of a mapped file that can be accessed before its size is checked again */
+#define MMAP_CHECK_SIZE (64 << 10)
+
 /* standard file protocol */
 
 typedef struct FileContext {
@@ -99,6 +107,13 @@ typedef struct FileContext {
     DIR *dir;
 #endif
     int64_t initial_pos;
+    int use_mmap;
+    const uint8_t *map;
+    size_t map_length;
+    int64_t map_size;
+    int64_t map_pos;
+    int64_t map_checked_pos;
+    int mapped;
 } FileContext;
 
 static const AVOption file_options[] = {
@@ -106,6 +121,7 @@ static const AVOption file_options[] = {
     { "blocksize", "set I/O operation maximum block size", offsetof(FileContext, blocksize), AV_OPT_TYPE_INT, { .i64 = INT_MAX }, 1, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM },
     { "follow", "Follow a file as it is being written", offsetof(FileContext, follow), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1, AV_OPT_FLAG_DECODING_PARAM },
     { "seekable", "Sets if the file is seekable", offsetof(FileContext, seekable), AV_OPT_TYPE_INT, { .i64 = -1 }, -1, 0, AV_OPT_FLAG_DECODING_PARAM | AV_OPT_FLAG_ENCODING_PARAM },
+    { "mmap", "Map regular files into memory when reading", offsetof(FileContext, use_mmap), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, AV_OPT_FLAG_DECODING_PARAM },
     { NULL }
 };
 
@@ -136,11 +152,56 @@ static const AVClass fd_class = {
     .version    = LIBAVUTIL_VERSION_INT,
 };
 
+/*
+ * Touching the pages of a mapping past the end of the file raises SIGBUS, so
+ * the file size is checked before accessing [pos, end). To keep fstat() calls
+ * rare, it is only checked again once an access leaves the MMAP_CHECK_SIZE
+ * bytes after the last check. If the size changed since the file was mapped,
+ * the file is being truncated or written to: the mapping is not used anymore
+ * and the file is read with read() from the current position on.
+ * This narrows the window but cannot close it: a truncation right after a
+ * check, or while data returned by file_get_mapping() is still in use, still
+ * crashes the process.
+ */
+static int file_map_check(URLContext *h, int64_t pos, int64_t end)
+{
+    FileContext *c = h->priv_data;
+    struct stat st;
+
+    if (pos >= c->map_checked_pos && end - c->map_checked_pos <= MMAP_CHECK_SIZE)
+        return 0;
+    if (fstat(c->fd, &st) < 0)
+        return AVERROR(errno);
+    if (st.st_size != c->map_size) {
+        av_log(h, AV_LOG_VERBOSE, "File size changed from %"PRId64" to %"PRId64
+               ", not using the mapping anymore\n", c->map_size, (int64_t)st.st_size);
+        if (lseek(c->fd, c->map_pos, SEEK_SET) < 0)
+            return AVERROR(errno);
+        c->mapped = 0;
+        return 0;
+    }
+    c->map_checked_pos = pos;
+    return 0;
+}
+
 static int file_read(URLContext *h, unsigned char *buf, int size)
 {
     FileContext *c = h->priv_data;
     int ret;
     size = FFMIN(size, c->blocksize);
+    if (c->mapped) {
+        ret = file_map_check(h, c->map_pos, c->map_pos + size);
+        if (ret < 0)
+            return ret;
+    }
+    if (c->mapped) {
+        if (c->map_pos >= c->map_size)
+            return AVERROR_EOF;
+        size = FFMIN(size, c->map_size - c->map_pos);
+        memcpy(buf, c->map + c->map_pos, size);
+        c->map_pos += size;
+        return size;
+    }
     ret = read(c->fd, buf, size);
     if (ret == 0 && c->follow)
         return AVERROR(EAGAIN);
@@ -164,6 +225,24 @@ static int file_get_handle(URLContext *h)
     return c->fd;
 }
 
+static int file_get_mapping(URLContext *h, int64_t pos, int size, const uint8_t **data)
+{
+    FileContext *c = h->priv_data;
+    int ret;
+
+    if (!c->mapped)
+        return AVERROR(ENOSYS);
+    ret = file_map_check(h, pos, pos + size);
+    if (ret < 0)
+        return ret;
+    if (!c->mapped)
+        return AVERROR(ENOSYS);
+    if (pos > c->map_size || size > c->map_size - pos)
+        return AVERROR_EOF;
+    *data = c->map + pos;
+    return 0;
+}
+
 static int file_check(URLContext *h, int mask)
 {
     int ret = 0;
@@ -224,6 +303,12 @@ static int file_close(URLContext *h)
     if (c->initial_pos >= 0 && !h->is_streamed)
         lseek(c->fd, c->initial_pos, SEEK_SET);
 
+#if HAVE_MMAP
+    if (c->map)
+        munmap((void *)c->map, c->map_length);
+    c->map = NULL;
+#endif
+
     ret = close(c->fd);
     return (ret == -1) ? AVERROR(errno) : 0;
 }
@@ -240,6 +325,30 @@ static int64_t file_seek(URLContext *h, int64_t pos, int whence)
         return ret < 0 ? AVERROR(errno) : (S_ISFIFO(st.st_mode) ? 0 : st.st_size);
     }
 
+    if (c->mapped) {
+        if (whence == SEEK_CUR)
+            pos += c->map_pos;
+        else if (whence == SEEK_END)
+            pos += c->map_size;
+        else if (whence != SEEK_SET)
+            return AVERROR(EINVAL);
+        if (pos < 0)
+            return AVERROR(EINVAL);
+#if HAVE_POSIX_MADVISE
+        /* A jump away from the current position means the demuxer is
+         * seeking rather than reading sequentially: ask the kernel to
+         * start reading the pages around the new position right away. */
+        if (pos != c->map_pos && pos < c->map_size) {
+            int64_t page  = sysconf(_SC_PAGESIZE);
+            int64_t start = pos & ~(page - 1);
+            int64_t len   = FFMIN(MMAP_WILLNEED_SIZE, c->map_size - start);
+            posix_madvise((void *)(c->map + start), len, POSIX_MADV_WILLNEED);
+        }
+#endif
+        c->map_pos = pos;
+        return pos;
+    }
+
     ret = lseek(c->fd, pos, whence);
 
     return ret < 0 ? AVERROR(errno) : ret;
@@ -322,6 +431,28 @@ static int file_open(URLContext *h, const char *filename, int flags)
     if (c->seekable >= 0)
         h->is_streamed = !c->seekable;
 
+#if HAVE_MMAP
+    if (c->use_mmap && !(flags & AVIO_FLAG_WRITE) && !c->follow && !fstat(fd, &st) &&
+        !h->is_streamed && S_ISREG(st.st_mode) && st.st_size > 0 &&
+        st.st_size <= SIZE_MAX) {
+        void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (map == MAP_FAILED) {
+            av_log(h, AV_LOG_WARNING, "Could not map the file, falling back to read(): %s\n",
+                   av_err2str(AVERROR(errno)));
+        } else {
+            c->map             = map;
+            c->map_length      = st.st_size;
+            c->map_size        = st.st_size;
+            c->map_pos         = 0;
+            c->map_checked_pos = 0;
+            c->mapped          = 1;
+#if HAVE_POSIX_MADVISE
+            posix_madvise(map, st.st_size, POSIX_MADV_SEQUENTIAL);
+#endif
+        }
+    }
+#endif
+
     return 0;
 }
 
@@ -417,6 +548,7 @@ const URLProtocol ff_file_protocol = {
     .url_seek            = file_seek,
     .url_close           = file_close,
     .url_get_file_handle = file_get_handle,
+    .url_get_mapping     = file_get_mapping,
     .url_check           = file_check,
     .url_delete          = file_delete,
     .url_move            = file_move,
@@ -33,10 +33,12 @@
 #include "libavutil/aes.h"
 #include "libavutil/avstring.h"
 #include "libavutil/avassert.h"
+#include "libavutil/bprint.h"
 #include "libavutil/intreadwrite.h"
 #include "libavutil/mathematics.h"
 #include "libavutil/opt.h"
 #include "libavutil/dict.h"
+#include "libavutil/thread.h"
 #include "libavutil/time.h"
 #include "avformat.h"
 #include "demux.h"
@@ -48,6 +50,7 @@
 #include "hls_sample_encryption.h"
 
 #define INITIAL_BUFFER_SIZE 32768
+#define PREFETCH_CHUNK_SIZE 65536
 
 #define MAX_FIELD_LEN 64
 #define MAX_CHARACTERISTICS_LEN 512
@@ -86,6 +89,34 @@ struct segment {
 };
 
 struct rendition;
+struct playlist;
+
+enum PrefetchState {
+    PREFETCH_QUEUED,
+    PREFETCH_RUNNING,
+    PREFETCH_DONE,
+};
+
+/*
+ * A media segment, or a media playlist, downloaded into memory ahead of
+ * time by the prefetch threads.
+ */
+struct prefetch {
+    struct playlist *pls;
+    int64_t seq_no; /* -1 for the media playlist itself */
+    char *url;
+    int64_t url_offset;
+    int64_t size;
+    AVDictionary *opts;
+    enum PrefetchState state;
+    int cancelled;
+    int error;
+    char *location; /* final playlist url after redirects */
+    char *sent_cookies; /* cookies of the request, to find those of the response */
+    uint8_t *data;
+    unsigned int data_alloc;
+    int64_t data_size;
+};
 
 enum PlaylistType {
     PLS_TYPE_UNSPECIFIED,
@@ -132,6 +163,7 @@ struct playlist {
     int m3u8_hold_counters;
     int64_t cur_seg_offset;
     int64_t last_load_time;
+    struct prefetch *cur_prefetch; /* current segment, if it was prefetched */
 
     /* Currently active Media Initialization Section */
     struct segment *cur_init_section;
@@ -227,8 +259,23 @@ typedef struct HLSContext {
     int http_multiple;
     int http_seekable;
     int seg_max_retry;
+    int prefetch_segments;
+    int prefetch_threads;
+    int64_t prefetch_max_size;
     AVIOContext *playlist_pb;
     HLSCryptoContext  crypto_ctx;
+
+    /* downloads queued for, running in or finished by the prefetch threads */
+    struct prefetch **prefetches;
+    int n_prefetches;
+    int64_t prefetch_mem;
+    int prefetch_quit;
+#if HAVE_THREADS
+    pthread_t *prefetch_workers;
+    int n_prefetch_workers;
+    pthread_mutex_t prefetch_lock;
+    pthread_cond_t prefetch_cond;
+#endif
 } HLSContext;
 
 static void free_segment_dynarray(struct segment **segments, int n_segments)
@@ -260,6 +307,20 @@ static void free_init_section_list(struct playlist *pls)
     pls->n_init_sections = 0;
 }
 
+static void prefetch_free(struct prefetch **pp)
+{
+    struct prefetch *p = *pp;
+
+    if (!p)
+        return;
+    av_freep(&p->url);
+    av_freep(&p->location);
+    av_freep(&p->sent_cookies);
+    av_dict_free(&p->opts);
+    av_freep(&p->data);
+    av_freep(pp);
+}
+
 static void free_playlist_list(HLSContext *c)
 {
     int i;
@@ -275,6 +336,7 @@ static void free_playlist_list(HLSContext *c)
         av_freep(&pls->init_sec_buf);
         av_packet_free(&pls->pkt);
         av_freep(&pls->pb.pub.buffer);
+        prefetch_free(&pls->cur_prefetch);
         ff_format_io_close(c->ctx, &pls->input);
         pls->input_read_done = 0;
         ff_format_io_close(c->ctx, &pls->input_next);
@@ -1071,7 +1133,14 @@ static int read_from_url(struct playlist *pls, struct segment *seg,
     if (seg->size >= 0)
         buf_size = FFMIN(buf_size, seg->size - pls->cur_seg_offset);
 
-    ret = avio_read(pls->input, buf, buf_size);
+    if (pls->cur_prefetch) {
+        ret = FFMIN(buf_size, pls->cur_prefetch->data_size - pls->cur_seg_offset);
+        if (ret <= 0)
+            return AVERROR_EOF;
+        memcpy(buf, pls->cur_prefetch->data + pls->cur_seg_offset, ret);
+    } else {
+        ret = avio_read(pls->input, buf, buf_size);
+    }
     if (ret > 0)
         pls->cur_seg_offset += ret;
 
@@ -1362,6 +1431,465 @@ cleanup:
     return ret;
 }
 
+#if HAVE_THREADS
+
+/* Must be called with prefetch_lock held. */
+static struct prefetch *prefetch_find(HLSContext *c, struct playlist *pls, int64_t seq_no)
+{
+    for (int i = 0; i < c->n_prefetches; i++) {
+        struct prefetch *p = c->prefetches[i];
+        if (p->pls == pls && p->seq_no == seq_no && !p->cancelled)
+            return p;
+    }
+    return NULL;
+}
+
+/* Must be called with prefetch_lock held. */
+static void prefetch_remove(HLSContext *c, struct prefetch *p)
+{
+    for (int i = 0; i < c->n_prefetches; i++) {
+        if (c->prefetches[i] == p) {
+            memmove(&c->prefetches[i], &c->prefetches[i + 1],
+                    (c->n_prefetches - i - 1) * sizeof(*c->prefetches));
+            c->n_prefetches--;
+            break;
+        }
+    }
+}
+
+/* Must be called with prefetch_lock held. */
+static void prefetch_discard(HLSContext *c, struct prefetch *p)
+{
+    if (p->state == PREFETCH_RUNNING) {
+        /* freed by the thread downloading it */
+        p->cancelled = 1;
+        return;
+    }
+    prefetch_remove(c, p);
+    c->prefetch_mem -= p->data_size;
+    prefetch_free(&p);
+}
+
+/* Must be called with prefetch_lock held. */
+static int prefetch_add(HLSContext *c, struct playlist *pls, int64_t seq_no,
+                        const char *url, int64_t url_offset, int64_t size)
+{
+    struct prefetch *p = av_mallocz(sizeof(*p));
+    int ret;
+
+    if (!p)
+        return AVERROR(ENOMEM);
+    p->pls        = pls;
+    p->seq_no     = seq_no;
+    p->url_offset = url_offset;
+    p->size       = size;
+    p->url        = av_strdup(url);
+    if (!p->url || av_dict_copy(&p->opts, c->avio_opts, 0) < 0) {
+        prefetch_free(&p);
+        return AVERROR(ENOMEM);
+    }
+    ret = av_dynarray_add_nofree(&c->prefetches, &c->n_prefetches, p);
+    if (ret < 0) {
+        prefetch_free(&p);
+        return ret;
+    }
+    return 0;
+}
+
+static int prefetch_download(HLSContext *c, struct prefetch *p)
+{
+    AVFormatContext *s = c->ctx;
+    const AVDictionaryEntry *cookies = av_dict_get(p->opts, "cookies", NULL, 0);
+    AVDictionary *opts = NULL;
+    AVIOContext *pb = NULL;
+    int is_http = 0;
+    int ret;
+
+    if (cookies && !(p->sent_cookies = av_strdup(cookies->value)))
+        return AVERROR(ENOMEM);
+    if (p->size >= 0) {
+        av_dict_set_int(&opts, "offset", p->url_offset, 0);
+        av_dict_set_int(&opts, "end_offset", p->url_offset + p->size, 0);
+    }
+    ret = open_url(s, &pb, p->url, &p->opts, opts, &is_http);
+    av_dict_free(&opts);
+    if (ret < 0)
+        return ret;
+
+    if (!is_http && p->url_offset) {
+        int64_t seekret = avio_seek(pb, p->url_offset, SEEK_SET);
+        if (seekret < 0) {
+            ff_format_io_close(s, &pb);
+            return seekret;
+        }
+    }
+    if (p->seq_no < 0)
+        av_opt_get(pb, "location", AV_OPT_SEARCH_CHILDREN, (uint8_t **)&p->location);
+
+    for (;;) {
+        int64_t left = p->size >= 0 ? p->size - p->data_size : PREFETCH_CHUNK_SIZE;
+        int len = FFMIN(left, PREFETCH_CHUNK_SIZE);
+        uint8_t *data;
+        int stop;
+
+        if (len <= 0)
+            break;
+        if (p->data_size + len > INT_MAX) {
+            ret = AVERROR(ERANGE);
+            break;
+        }
+        data = av_fast_realloc(p->data, &p->data_alloc, p->data_size + len);
+        if (!data) {
+            ret = AVERROR(ENOMEM);
+            break;
+        }
+        p->data = data;
+
+        ret = avio_read(pb, p->data + p->data_size, len);
+        if (ret == AVERROR_EOF) {
+            ret = 0;
+            break;
+        } else if (ret < 0) {
+            break;
+        }
+
+        pthread_mutex_lock(&c->prefetch_lock);
+        p->data_size    += ret;
+        c->prefetch_mem += ret;
+        stop = p->cancelled || c->prefetch_quit;
+        pthread_mutex_unlock(&c->prefetch_lock);
+        if (stop) {
+            ret = AVERROR_EXIT;
+            break;
+        }
+    }
+    ff_format_io_close(s, &pb);
+    return ret;
+}
+
+static void *prefetch_worker(void *arg)
+{
+    HLSContext *c = arg;
+
+    pthread_mutex_lock(&c->prefetch_lock);
+    while (!c->prefetch_quit) {
+        struct prefetch *p = NULL;
+        int ret;
+
+        /* playlists are small and needed right away, so they are fetched
+         * regardless of the memory limit */
+        for (int i = 0; i < c->n_prefetches && !p; i++) {
+            struct prefetch *q = c->prefetches[i];
+            if (q->state == PREFETCH_QUEUED &&
+                (q->seq_no < 0 || c->prefetch_mem < c->prefetch_max_size))
+                p = q;
+        }
+        if (!p) {
+            pthread_cond_wait(&c->prefetch_cond, &c->prefetch_lock);
+            continue;
+        }
+
+        p->state = PREFETCH_RUNNING;
+        pthread_mutex_unlock(&c->prefetch_lock);
+        ret = prefetch_download(c, p);
+        pthread_mutex_lock(&c->prefetch_lock);
+
+        p->error = ret;
+        p->state = PREFETCH_DONE;
+        if (p->cancelled)
+            prefetch_discard(c, p);
+        pthread_cond_broadcast(&c->prefetch_cond);
+    }
+    pthread_mutex_unlock(&c->prefetch_lock);
+
+    return NULL;
+}
+
+static int prefetch_init(AVFormatContext *s)
+{
+    HLSContext *c = s->priv_data;
+    int ret;
+
+    c->prefetch_workers = av_calloc(c->prefetch_threads, sizeof(*c->prefetch_workers));
+    if (!c->prefetch_workers)
+        return AVERROR(ENOMEM);
+    if ((ret = pthread_mutex_init(&c->prefetch_lock, NULL)))
+        goto fail;
+    if ((ret = pthread_cond_init(&c->prefetch_cond, NULL))) {
+        pthread_mutex_destroy(&c->prefetch_lock);
+        goto fail;
+    }
+    for (int i = 0; i < c->prefetch_threads; i++) {
+        ret = pthread_create(&c->prefetch_workers[i], NULL, prefetch_worker, c);
+        if (ret)
+            break;
+        c->n_prefetch_workers++;
+    }
+    if (!c->n_prefetch_workers) {
+        pthread_cond_destroy(&c->prefetch_cond);
+        pthread_mutex_destroy(&c->prefetch_lock);
+        goto fail;
+    }
+    return 0;
+fail:
+    av_freep(&c->prefetch_workers);
+    return AVERROR(ret);
+}
+
+static void prefetch_uninit(HLSContext *c)
+{
+    if (!c->n_prefetch_workers)
+        return;
+
+    pthread_mutex_lock(&c->prefetch_lock);
+    c->prefetch_quit = 1;
+    pthread_cond_broadcast(&c->prefetch_cond);
+    pthread_mutex_unlock(&c->prefetch_lock);
+    for (int i = 0; i < c->n_prefetch_workers; i++)
+        pthread_join(c->prefetch_workers[i], NULL);
+    c->n_prefetch_workers = 0;
+    av_freep(&c->prefetch_workers);
+    pthread_cond_destroy(&c->prefetch_cond);
+    pthread_mutex_destroy(&c->prefetch_lock);
+
+    for (int i = 0; i < c->n_prefetches; i++)
+        prefetch_free(&c->prefetches[i]);
+    av_freep(&c->prefetches);
+    c->n_prefetches = 0;
+}
+
+/**
+ * Queue the download of the segments following the current one, and
+ * drop the downloads the reader does not need anymore.
+ */
+static void prefetch_schedule(HLSContext *c, struct playlist *pls)
+{
+    int64_t last = pls->cur_seq_no + c->prefetch_segments;
+
+    if (!c->n_prefetch_workers)
+        return;
+
+    pthread_mutex_lock(&c->prefetch_lock);
+    for (int i = c->n_prefetches - 1; i >= 0; i--) {
+        struct prefetch *p = c->prefetches[i];
+        if (p->pls == pls && p->seq_no >= 0 &&
+            (p->seq_no < pls->cur_seq_no || p->seq_no > last))
+            prefetch_discard(c, p);
+    }
+    for (int64_t seq_no = pls->cur_seq_no + 1; seq_no <= last; seq_no++) {
+        int64_t n = seq_no - pls->start_seq_no;
+        struct segment *seg;
+
+        if (n < 0)
+            continue;
+        if (n >= pls->n_segments)
+            break;
+        seg = pls->segments[n];
+        /* encrypted segments need the key state of the playlist */
+        if (seg->key_type != KEY_NONE)
+            break;
+        if (prefetch_find(c, pls, seq_no))
+            continue;
+        if (prefetch_add(c, pls, seq_no, seg->url, seg->url_offset, seg->size) < 0)
+            break;
+    }
+    pthread_cond_broadcast(&c->prefetch_cond);
+    pthread_mutex_unlock(&c->prefetch_lock);
+}
+
+/* Check if the newline separated Set-Cookie values in cookies have line. */
+static int find_cookie(const char *cookies, const char *line, size_t len)
+{
+    while (cookies && *cookies) {
+        size_t n = strcspn(cookies, "\n");
+        if (n == len && !strncmp(cookies, line, len))
+            return 1;
+        cookies += n + !!cookies[n];
+    }
+    return 0;
+}
+
+static int same_cookie_name(const char *a, size_t a_len, const char *b, size_t b_len)
+{
+    const char *a_eq = memchr(a, '=', a_len), *b_eq = memchr(b, '=', b_len);
+
+    a_len = a_eq ? a_eq - a : a_len;
+    b_len = b_eq ? b_eq - b : b_len;
+    return a_len == b_len && !strncmp(a, b, a_len);
+}
+
+/*
+ * Check if the response to the prefetch request set a cookie with the name
+ * of line, i.e. if its cookies have one which the request did not send.
+ */
+static int prefetch_set_cookie(const struct prefetch *p, const char *received,
+                               const char *line, size_t len)
+{
+    while (*received) {
+        size_t n = strcspn(received, "\n");
+        if (n && same_cookie_name(received, n, line, len) &&
+            !find_cookie(p->sent_cookies, received, n))
+            return 1;
+        received += n + !!received[n];
+    }
+    return 0;
+}
+
+/**
+ * Add the cookies set by the response to a prefetch request to those of
+ * the next requests, as open_url() does for the requests of the reader.
+ */
+static int prefetch_merge_cookies(HLSContext *c, const struct prefetch *p)
+{
+    const AVDictionaryEntry *e = av_dict_get(p->opts, "cookies", NULL, 0);
+    const char *received = e ? e->value : NULL, *line;
+    AVBPrint bp;
+    char *cookies;
+    int ret;
+
+    if (!received || !strcmp(received, p->sent_cookies ? p->sent_cookies : ""))
+        return 0;
+
+    av_bprint_init(&bp, 0, AV_BPRINT_SIZE_UNLIMITED);
+    /* the cookies of the reader, without those the response replaced */
+    e = av_dict_get(c->avio_opts, "cookies", NULL, 0);
+    for (line = e ? e->value : ""; *line; ) {
+        size_t n = strcspn(line, "\n");
+        if (n && !prefetch_set_cookie(p, received, line, n))
+            av_bprintf(&bp, "%.*s\n", (int)n, line);
+        line += n + !!line[n];
+    }
+    for (line = received; *line; ) {
+        size_t n = strcspn(line, "\n");
+        if (n && !find_cookie(p->sent_cookies, line, n))
+            av_bprintf(&bp, "%.*s\n", (int)n, line);
+        line += n + !!line[n];
+    }
+    if ((ret = av_bprint_finalize(&bp, &cookies)) < 0)
+        return ret;
+    return av_dict_set(&c->avio_opts, "cookies", cookies, AV_DICT_DONT_STRDUP_VAL);
+}
+
+/**
+ * Take the prefetched segment seq_no (or the playlist itself if seq_no is
+ * -1) of pls, waiting for its download to finish.
+ *
+ * @return the downloaded data, or NULL if it must be opened directly
+ */
+static struct prefetch *prefetch_take(HLSContext *c, struct playlist *pls,
+                                      int64_t seq_no)
+{
+    struct prefetch *p;
+
+    if (!c->n_prefetch_workers)
+        return NULL;
+
+    pthread_mutex_lock(&c->prefetch_lock);
+    p = prefetch_find(c, pls, seq_no);
+    if (p && p->state == PREFETCH_QUEUED) {
+        /* faster to open it here than to wait for a free thread */
+        prefetch_discard(c, p);
+        p = NULL;
+    }
+    while (p && p->state != PREFETCH_DONE)
+        pthread_cond_wait(&c->prefetch_cond, &c->prefetch_lock);
+    if (p && p->error < 0) {
+        if (p->error != AVERROR_EXIT)
+            av_log(c->ctx, AV_LOG_WARNING,
+                   "Prefetching '%s' failed: %s\n", p->url, av_err2str(p->error));
+        prefetch_discard(c, p);
+        p = NULL;
+    }
+    if (p)
+        prefetch_remove(c, p);
+    pthread_mutex_unlock(&c->prefetch_lock);
+
+    if (p && prefetch_merge_cookies(c, p) < 0)
+        av_log(c->ctx, AV_LOG_WARNING, "Failed to keep the cookies of '%s'\n", p->url);
+
+    return p;
+}
+
+/* Free a segment or playlist returned by prefetch_take(). */
+static void prefetch_release(HLSContext *c, struct prefetch **pp)
+{
+    if (!*pp)
+        return;
+    pthread_mutex_lock(&c->prefetch_lock);
+    c->prefetch_mem -= (*pp)->data_size;
+    pthread_cond_broadcast(&c->prefetch_cond);
+    pthread_mutex_unlock(&c->prefetch_lock);
+    prefetch_free(pp);
+}
+
+/* Download all the media playlists in parallel while opening. */
+static int prefetch_playlists(HLSContext *c)
+{
+    int ret = 0;
+
+    if (!c->n_prefetch_workers)
+        return 0;
+
+    pthread_mutex_lock(&c->prefetch_lock);
+    for (int i = 0; i < c->n_playlists && ret >= 0; i++)
+        ret = prefetch_add(c, c->playlists[i], -1, c->playlists[i]->url, 0, -1);
+    pthread_cond_broadcast(&c->prefetch_cond);
+    pthread_mutex_unlock(&c->prefetch_lock);
+    return ret;
+}
+
+/* Drop all the prefetched segments of pls, e.g. after seeking. */
+static void prefetch_reset(HLSContext *c, struct playlist *pls)
+{
+    prefetch_release(c, &pls->cur_prefetch);
+    if (!c->n_prefetch_workers)
+        return;
+
+    pthread_mutex_lock(&c->prefetch_lock);
+    for (int i = c->n_prefetches - 1; i >= 0; i--) {
+        if (c->prefetches[i]->pls == pls)
+            prefetch_discard(c, c->prefetches[i]);
+    }
+    pthread_mutex_unlock(&c->prefetch_lock);
+}
+
+#else
+
+static int prefetch_init(AVFormatContext *s)
+{
+    return AVERROR(ENOSYS);
+}
+
+static void prefetch_uninit(HLSContext *c)
+{
+}
+
+static void prefetch_schedule(HLSContext *c, struct playlist *pls)
+{
+}
+
+static struct prefetch *prefetch_take(HLSContext *c, struct playlist *pls,
+                                      int64_t seq_no)
+{
+    return NULL;
+}
+
+static int prefetch_playlists(HLSContext *c)
+{
+    return 0;
+}
+
+static void prefetch_release(HLSContext *c, struct prefetch **pp)
+{
+    prefetch_free(pp);
+}
+
+static void prefetch_reset(HLSContext *c, struct playlist *pls)
+{
+}
+
+#endif /* HAVE_THREADS */
+
 static int update_init_section(struct playlist *pls, struct segment *seg)
 {
     static const int max_init_section_size = 1024*1024;
@@ -1486,7 +2014,7 @@ restart:
     if (!v->needed)
         return AVERROR_EOF;
 
-    if (!v->input || (c->http_persistent && v->input_read_done)) {
+    if ((!v->input && !v->cur_prefetch) || (c->http_persistent && v->input_read_done)) {
         int64_t reload_interval;
 
         /* Check that the playlist is still needed before opening a new
@@ -1562,6 +2090,9 @@ reload:
             v->cur_seg_offset = 0;
             v->input_next_requested = 0;
             ret = 0;
+        } else if ((v->cur_prefetch = prefetch_take(c, v, v->cur_seq_no))) {
+            v->cur_seg_offset = 0;
+            ret = 0;
         } else {
             ret = open_input(c, v, seg, &v->input);
         }
@@ -1584,6 +2115,7 @@ reload:
         }
         segment_retries = 0;
         just_opened = 1;
+        prefetch_schedule(c, v);
     }
 
     if (c->http_multiple == -1) {
@@ -1629,7 +2161,11 @@ reload:
 
         return ret;
     }
-    if (c->http_persistent &&
+    if (v->cur_prefetch) {
+        prefetch_release(c, &v->cur_prefetch);
+        /* reuse a persistent connection for the next segment, if open */
+        v->input_read_done = 1;
+    } else if (c->http_persistent &&
         seg->key_type == KEY_NONE && av_strstart(seg->url, "http", NULL)) {
         v->input_read_done = 1;
     } else {
@@ -1913,6 +2449,7 @@ static int hls_close(AVFormatContext *s)
 {
     HLSContext *c = s->priv_data;
 
+    prefetch_uninit(c);
     free_playlist_list(c);
     free_variant_list(c);
     free_rendition_list(c);
@@ -1954,13 +2491,36 @@ static int hls_read_header(AVFormatContext *s)
         av_log(s, AV_LOG_WARNING, "Empty playlist\n");
         return AVERROR_EOF;
     }
+    if (c->prefetch_segments > 0) {
+        ret = prefetch_init(s);
+        if (ret == AVERROR(ENOSYS))
+            av_log(s, AV_LOG_WARNING, "Prefetching requires threading support\n");
+        else if (ret < 0)
+            return ret;
+        else
+            c->http_multiple = 0;
+    }
+
     /* If the playlist only contained playlists (Master Playlist),
      * parse each individual playlist. */
     if (c->n_playlists > 1 || c->playlists[0]->n_segments == 0) {
+        if ((ret = prefetch_playlists(c)) < 0)
+            return ret;
         for (i = 0; i < c->n_playlists; i++) {
             struct playlist *pls = c->playlists[i];
+            struct prefetch *p = prefetch_take(c, pls, -1);
             pls->m3u8_hold_counters = 0;
-            if ((ret = parse_playlist(c, pls->url, pls, NULL)) < 0) {
+            if (p) {
+                FFIOContext pb;
+
+                ffio_init_read_context(&pb, p->data, p->data_size);
+                ret = parse_playlist(c, p->location ? p->location : pls->url,
+                                     pls, &pb.pub);
+                prefetch_release(c, &p);
+            } else {
+                ret = parse_playlist(c, pls->url, pls, NULL);
+            }
+            if (ret < 0) {
                 av_log(s, AV_LOG_WARNING, "parse_playlist error %s [%s]\n", av_err2str(ret), pls->url);
                 pls->broken = 1;
                 if (c->n_playlists > 1)
@@ -2078,6 +2638,7 @@ static int hls_read_header(AVFormatContext *s)
             }
             ret = 0;
             /* Reset reading */
+            prefetch_reset(c, pls);
             ff_format_io_close(pls->parent, &pls->input);
             pls->input = NULL;
             pls->input_read_done = 0;
@@ -2234,6 +2795,7 @@ static int recheck_discard_flags(AVFormatContext *s, int first)
             }
             av_log(s, AV_LOG_INFO, "Now receiving playlist %d, segment %"PRId64"\n", i, pls->cur_seq_no);
         } else if (first && !cur_needed && pls->needed) {
+            prefetch_reset(c, pls);
             ff_format_io_close(pls->parent, &pls->input);
             pls->input_read_done = 0;
             ff_format_io_close(pls->parent, &pls->input_next);
@@ -2490,6 +3052,7 @@ static int hls_read_seek(AVFormatContext *s, int stream_index,
         /* Reset reading */
         struct playlist *pls = c->playlists[i];
         AVIOContext *const pb = &pls->pb.pub;
+        prefetch_reset(c, pls);
         ff_format_io_close(pls->parent, &pls->input);
         pls->input_read_done = 0;
         ff_format_io_close(pls->parent, &pls->input_next);
@@ -2586,6 +3149,12 @@ static const AVOption hls_options[] = {
         OFFSET(seg_format_opts), AV_OPT_TYPE_DICT, {.str = NULL}, 0, 0, FLAGS},
     {"seg_max_retry", "Maximum number of times to reload a segment on error.",
      OFFSET(seg_max_retry), AV_OPT_TYPE_INT, {.i64 = 0}, 0, INT_MAX, FLAGS},
+    {"prefetch_segments", "Number of segments to download ahead of the reading position, per playlist",
+        OFFSET(prefetch_segments), AV_OPT_TYPE_INT, {.i64 = 0}, 0, 64, FLAGS},
+    {"prefetch_threads", "Number of parallel connections used for prefetching",
+        OFFSET(prefetch_threads), AV_OPT_TYPE_INT, {.i64 = 4}, 1, 64, FLAGS},
+    {"prefetch_max_size", "Maximum amount of memory used by prefetched segments",
+        OFFSET(prefetch_max_size), AV_OPT_TYPE_INT64, {.i64 = 64 << 20}, 0, INT64_MAX, FLAGS},
     {NULL}
 };
 
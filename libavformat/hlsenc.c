@@ -49,6 +49,7 @@
 #endif
 #include "hlsplaylist.h"
 #include "internal.h"
+#include "ioqueue.h"
 #include "mux.h"
 #include "os_support.h"
 #include "url.h"
@@ -70,6 +71,7 @@ typedef enum {
 #define LINE_BUFFER_SIZE MAX_URL_SIZE
 #define HLS_MICROSECOND_UNIT   1000000
 #define BUFSIZE (16 * 1024)
+#define IO_QUEUE_SIZE 16
 #define POSTFIX_PATTERN "_%d"
 
 typedef struct HLSSegment {
@@ -252,6 +254,8 @@ typedef struct HLSContext {
     AVIOContext *http_delete;
     int64_t timeout;
     int ignore_io_errors;
+    int async_io;
+    FFIOQueue *io_queue;
     char *headers;
     int has_default_key; /* has DEFAULT field of var_stream_map */
     int has_video_m3u8; /* has video stream m3u8 list */
@@ -585,6 +589,9 @@ static int hls_delete_file(HLSContext *hls, AVFormatContext *avf,
         set_http_options(avf, &opt, hls);
         av_dict_set(&opt, "method", "DELETE", 0);
 
+        if (hls->io_queue)
+            return ff_io_queue_delete(hls->io_queue, path, &opt);
+
         ret = hlsenc_io_open(avf, &hls->http_delete, path, &opt);
         av_dict_free(&opt);
         if (ret < 0)
@@ -592,6 +599,8 @@ static int hls_delete_file(HLSContext *hls, AVFormatContext *avf,
 
         //Nothing to write
         hlsenc_io_close(avf, &hls->http_delete, path);
+    } else if (hls->io_queue) {
+        return ff_io_queue_delete(hls->io_queue, path, NULL);
     } else if (unlink(path) < 0) {
         av_log(hls, AV_LOG_ERROR, "failed to delete old segment %s: %s\n",
                path, strerror(errno));
@@ -1329,6 +1338,91 @@ static int hls_rename_temp_file(AVFormatContext *s, AVFormatContext *oc)
     return ret;
 }
 
+/* Hand the segment buffered in vs->avf over to the I/O queue */
+static int hls_queue_segment(AVFormatContext *s, VariantStream *vs, int use_temp_file)
+{
+    HLSContext *hls = s->priv_data;
+    AVFormatContext *oc = vs->avf;
+    AVDictionary *options = NULL;
+    char *filename;
+    uint8_t *data;
+    int size, ret;
+
+    av_write_frame(oc, NULL);
+    size = avio_close_dyn_buf(oc->pb, &data);
+    oc->pb = NULL;
+    if ((ret = avio_open_dyn_buf(&oc->pb)) < 0) {
+        av_free(data);
+        return ret;
+    }
+
+    if (hls->segment_type == SEGMENT_TYPE_FMP4) {
+        AVIOContext *pb;
+        uint8_t *segment = data;
+
+        ret = avio_open_dyn_buf(&pb);
+        if (ret < 0) {
+            av_free(segment);
+            return ret;
+        }
+        write_styp(pb);
+        avio_write(pb, segment, size);
+        av_free(segment);
+        size = avio_close_dyn_buf(pb, &data);
+    }
+
+    if (hls->key_info_file || hls->encrypt) {
+        av_dict_set(&options, "encryption_key", vs->key_string, 0);
+        av_dict_set(&options, "encryption_iv", vs->iv_string, 0);
+        filename = av_asprintf("crypto:%s", oc->url);
+    } else {
+        filename = av_strdup(oc->url);
+    }
+    if (!filename) {
+        av_dict_free(&options);
+        av_free(data);
+        return AVERROR(ENOMEM);
+    }
+    if (use_temp_file)
+        av_dict_set(&options, "mpegts_flags", "resend_headers", 0);
+    set_http_options(s, &options, hls);
+
+    ret = ff_io_queue_write(hls->io_queue, filename, &options, data, size);
+    av_free(filename);
+    if (ret >= 0 && use_temp_file) {
+        size_t len = strlen(oc->url);
+        char *final_filename = av_strndup(oc->url, len - 4);
+
+        if (!final_filename)
+            return AVERROR(ENOMEM);
+        ret = ff_io_queue_rename(hls->io_queue, oc->url, final_filename);
+        oc->url[len - 4] = '\0';
+        av_free(final_filename);
+    }
+    return ret;
+}
+
+/* Hand a playlist written into the dynamic buffer *pb over to the I/O queue */
+static int hls_queue_playlist(AVFormatContext *s, AVIOContext **pb,
+                              const char *filename, const char *final_filename)
+{
+    HLSContext *hls = s->priv_data;
+    AVDictionary *options = NULL;
+    uint8_t *data;
+    int size, ret;
+
+    if (!*pb)
+        return 0;
+    size = avio_close_dyn_buf(*pb, &data);
+    *pb = NULL;
+
+    set_http_options(s, &options, hls);
+    ret = ff_io_queue_write(hls->io_queue, filename, &options, data, size);
+    if (ret >= 0 && final_filename)
+        ret = ff_io_queue_rename(hls->io_queue, filename, final_filename);
+    return ret;
+}
+
 static const char* get_relative_url(const char *master_url, const char *media_url)
 {
     const char *p = strrchr(master_url, '/');
@@ -1401,7 +1495,10 @@ static int create_master_playlist(AVFormatContext *s,
 
     set_http_options(s, &options, hls);
     snprintf(temp_filename, sizeof(temp_filename), use_temp_file ? "%s.tmp" : "%s", hls->master_m3u8_url);
-    ret = hlsenc_io_open(s, &hls->m3u8_out, temp_filename, &options);
+    if (hls->io_queue)
+        ret = avio_open_dyn_buf(&hls->m3u8_out);
+    else
+        ret = hlsenc_io_open(s, &hls->m3u8_out, temp_filename, &options);
     av_dict_free(&options);
     if (ret < 0) {
         av_log(s, AV_LOG_ERROR, "Failed to open master play list file '%s'\n",
@@ -1531,6 +1628,14 @@ static int create_master_playlist(AVFormatContext *s,
 fail:
     if (ret >=0)
         hls->master_m3u8_created = 1;
+    if (hls->io_queue) {
+        /* queued after the variant playlists it references */
+        int err = hls_queue_playlist(s, &hls->m3u8_out, temp_filename,
+                                     use_temp_file ? hls->master_m3u8_url : NULL);
+        if (ret >= 0)
+            ret = err;
+        return ret;
+    }
     hlsenc_io_close(s, &hls->m3u8_out, temp_filename);
     if (use_temp_file)
         ff_rename(temp_filename, hls->master_m3u8_url, s);
@@ -1585,7 +1690,10 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
 
     set_http_options(s, &options, hls);
     snprintf(temp_filename, sizeof(temp_filename), use_temp_file ? "%s.tmp" : "%s", vs->m3u8_name);
-    ret = hlsenc_io_open(s, byterange_mode ? &hls->m3u8_out : &vs->out, temp_filename, &options);
+    if (hls->io_queue)
+        ret = avio_open_dyn_buf(&vs->out);
+    else
+        ret = hlsenc_io_open(s, byterange_mode ? &hls->m3u8_out : &vs->out, temp_filename, &options);
     av_dict_free(&options);
     if (ret < 0) {
         if (hls->ignore_io_errors)
@@ -1644,7 +1752,10 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
     if (vs->vtt_m3u8_name) {
         set_http_options(vs->vtt_avf, &options, hls);
         snprintf(temp_vtt_filename, sizeof(temp_vtt_filename), use_temp_file ? "%s.tmp" : "%s", vs->vtt_m3u8_name);
-        ret = hlsenc_io_open(s, &hls->sub_m3u8_out, temp_vtt_filename, &options);
+        if (hls->io_queue)
+            ret = avio_open_dyn_buf(&hls->sub_m3u8_out);
+        else
+            ret = hlsenc_io_open(s, &hls->sub_m3u8_out, temp_vtt_filename, &options);
         av_dict_free(&options);
         if (ret < 0) {
             if (hls->ignore_io_errors)
@@ -1669,15 +1780,25 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
 
 fail:
     av_dict_free(&options);
-    ret = hlsenc_io_close(s, byterange_mode ? &hls->m3u8_out : &vs->out, temp_filename);
-    if (ret < 0) {
-        return ret;
-    }
-    hlsenc_io_close(s, &hls->sub_m3u8_out, vs->vtt_m3u8_name);
-    if (use_temp_file) {
-        ff_rename(temp_filename, vs->m3u8_name, s);
-        if (vs->vtt_m3u8_name)
-            ff_rename(temp_vtt_filename, vs->vtt_m3u8_name, s);
+    if (hls->io_queue) {
+        ret = hls_queue_playlist(s, &vs->out, temp_filename,
+                                 use_temp_file ? vs->m3u8_name : NULL);
+        if (ret >= 0)
+            ret = hls_queue_playlist(s, &hls->sub_m3u8_out, temp_vtt_filename,
+                                     use_temp_file ? vs->vtt_m3u8_name : NULL);
+        if (ret < 0)
+            return ret;
+    } else {
+        ret = hlsenc_io_close(s, byterange_mode ? &hls->m3u8_out : &vs->out, temp_filename);
+        if (ret < 0) {
+            return ret;
+        }
+        hlsenc_io_close(s, &hls->sub_m3u8_out, vs->vtt_m3u8_name);
+        if (use_temp_file) {
+            ff_rename(temp_filename, vs->m3u8_name, s);
+            if (vs->vtt_m3u8_name)
+                ff_rename(temp_vtt_filename, vs->vtt_m3u8_name, s);
+        }
     }
     if (ret >= 0 && hls->master_pl_name)
         if (create_master_playlist(s, vs) < 0)
@@ -2514,6 +2635,10 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
         int64_t new_start_pos;
         int byterange_mode = (hls->flags & HLS_SINGLE_FILE) || (hls->max_seg_size > 0);
 
+        if (hls->io_queue && (ret = ff_io_queue_error(hls->io_queue)) < 0 &&
+            !hls->ignore_io_errors)
+            return ret;
+
         av_write_frame(oc, NULL); /* Flush any buffered data */
         new_start_pos = avio_tell(oc->pb);
         vs->size = new_start_pos - vs->start_pos;
@@ -2530,13 +2655,21 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
                 avio_open_dyn_buf(&oc->pb);
                 vs->packets_written = 0;
                 vs->start_pos = range_length;
-                if (!byterange_mode) {
+                if (hls->io_queue) {
+                    ret = ff_io_queue_close(hls->io_queue, &vs->out);
+                    if (ret < 0)
+                        return ret;
+                } else if (!byterange_mode) {
                     hlsenc_io_close(s, &vs->out, vs->base_output_dirname);
                 }
             }
         }
         if (!byterange_mode) {
-            if (vs->vtt_avf) {
+            if (vs->vtt_avf && hls->io_queue) {
+                ret = ff_io_queue_close(hls->io_queue, &vs->vtt_avf->pb);
+                if (ret < 0)
+                    return ret;
+            } else if (vs->vtt_avf) {
                 hlsenc_io_close(s, &vs->vtt_avf->pb, vs->vtt_avf->url);
             }
         }
@@ -2557,7 +2690,9 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
                                       && (hls->flags & HLS_TEMP_FILE);
             }
 
-            if ((hls->max_seg_size > 0 && (vs->size + vs->start_pos >= hls->max_seg_size)) || !byterange_mode) {
+            if (hls->io_queue) {
+                ret = hls_queue_segment(s, vs, use_temp_file);
+            } else if ((hls->max_seg_size > 0 && (vs->size + vs->start_pos >= hls->max_seg_size)) || !byterange_mode) {
                 AVDictionary *options = NULL;
                 char *filename = NULL;
                 if (hls->key_info_file || hls->encrypt) {
@@ -2611,7 +2746,7 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
                 av_freep(&filename);
             }
 
-            if (use_temp_file)
+            if (use_temp_file && !hls->io_queue)
                 hls_rename_temp_file(s, oc);
         }
 
@@ -2726,6 +2861,7 @@ static void hls_deinit(AVFormatContext *s)
         av_freep(&vs->streams);
     }
 
+    ff_io_queue_free(&hls->io_queue);
     ff_format_io_close(s, &hls->m3u8_out);
     ff_format_io_close(s, &hls->sub_m3u8_out);
     ff_format_io_close(s, &hls->http_delete);
@@ -2870,6 +3006,12 @@ failed:
         av_free(old_filename);
     }
 
+    if (hls->io_queue) {
+        ret = ff_io_queue_flush(hls->io_queue);
+        if (ret < 0 && !hls->ignore_io_errors)
+            return ret;
+    }
+
     return 0;
 }
 
@@ -2962,6 +3104,22 @@ static int hls_init(AVFormatContext *s)
 
     hls->recording_time = hls->init_time && hls->max_nb_segments > 0 ? hls->init_time : hls->time;
 
+    if (hls->async_io) {
+        if (hls->flags & (HLS_SINGLE_FILE | HLS_SECOND_LEVEL_SEGMENT_SIZE |
+                          HLS_SECOND_LEVEL_SEGMENT_DURATION) ||
+            hls->max_seg_size > 0 || hls->http_persistent) {
+            av_log(s, AV_LOG_WARNING, "async_io is not supported with single_file, "
+                   "hls_segment_size, http_persistent and second level segment "
+                   "names, disabling it\n");
+        } else {
+            ret = ff_io_queue_alloc(&hls->io_queue, s, IO_QUEUE_SIZE);
+            if (ret == AVERROR(ENOSYS))
+                av_log(s, AV_LOG_WARNING, "async_io requires threading support, disabling it\n");
+            else if (ret < 0)
+                return ret;
+        }
+    }
+
     if (hls->flags & HLS_SPLIT_BY_TIME && hls->flags & HLS_INDEPENDENT_SEGMENTS) {
         // Independent segments cannot be guaranteed when splitting by time
         hls->flags &= ~HLS_INDEPENDENT_SEGMENTS;
@@ -3185,6 +3343,7 @@ static const AVOption options[] = {
     {"http_persistent", "Use persistent HTTP connections", OFFSET(http_persistent), AV_OPT_TYPE_BOOL, {.i64 = 0 }, 0, 1, E },
     {"timeout", "set timeout for socket I/O operations", OFFSET(timeout), AV_OPT_TYPE_DURATION, { .i64 = -1 }, -1, INT_MAX, .flags = E },
     {"ignore_io_errors", "Ignore IO errors for stable long-duration runs with network output", OFFSET(ignore_io_errors), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
+    {"async_io", "Write segments and playlists and delete old segments in a background thread", OFFSET(async_io), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
     {"headers", "set custom HTTP headers, can override built in default headers", OFFSET(headers), AV_OPT_TYPE_STRING, { .str = NULL }, 0, 0, E },
     { NULL },
 };
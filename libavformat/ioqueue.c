@@ -0,0 +1,397 @@
+/*
+ * Background I/O queue for muxers writing multiple files
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+
+#include "libavutil/avstring.h"
+#include "libavutil/error.h"
+#include "libavutil/mem.h"
+#include "libavutil/thread.h"
+#include "libavutil/time.h"
+#include "avformat.h"
+#include "internal.h"
+#include "ioqueue.h"
+#include "url.h"
+
+enum IOJobType {
+    IO_JOB_WRITE,
+    IO_JOB_CLOSE,
+    IO_JOB_RENAME,
+    IO_JOB_DELETE,
+};
+
+typedef struct IOJob {
+    enum IOJobType type;
+    char *url;
+    char *url_dst;
+    AVDictionary *options;
+    uint8_t *data;
+    int size;
+    AVIOContext *pb;
+} IOJob;
+
+struct FFIOQueue {
+    AVFormatContext *s;
+
+    IOJob *jobs;
+    int max_jobs;
+    int first_job;
+    /* number of queued jobs, including the one running */
+    int nb_jobs;
+    int error;
+    int quit;
+
+    /* statistics reported when the queue is freed */
+    int     nb_files;
+    int64_t bytes_written;
+    int64_t io_time;
+    int64_t wait_time;
+
+#if HAVE_THREADS
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+#endif
+};
+
+static void free_job(AVFormatContext *s, IOJob *job)
+{
+    av_freep(&job->url);
+    av_freep(&job->url_dst);
+    av_dict_free(&job->options);
+    av_freep(&job->data);
+    ff_format_io_close(s, &job->pb);
+}
+
+static int run_write(AVFormatContext *s, IOJob *job)
+{
+    AVIOContext *pb = NULL;
+    int ret;
+
+    /* retry once, which gives HTTP uploads a new session */
+    for (int tries = 0; tries < 2; tries++) {
+        AVDictionary *options = NULL;
+
+        ret = av_dict_copy(&options, job->options, 0);
+        if (ret >= 0)
+            ret = s->io_open(s, &pb, job->url, AVIO_FLAG_WRITE, &options);
+        av_dict_free(&options);
+        if (ret < 0)
+            break;
+        avio_write(pb, job->data, job->size);
+        ret = ff_format_io_close(s, &pb);
+        if (ret >= 0)
+            break;
+        av_log(s, AV_LOG_WARNING, "Writing '%s' failed, retrying\n", job->url);
+    }
+    return ret;
+}
+
+static int run_delete(AVFormatContext *s, IOJob *job)
+{
+    AVIOContext *pb = NULL;
+    int ret;
+
+    if (!job->options)
+        return ffurl_delete(job->url);
+
+    ret = s->io_open(s, &pb, job->url, AVIO_FLAG_WRITE, &job->options);
+    if (ret < 0)
+        return ret;
+    /* nothing to write */
+    return ff_format_io_close(s, &pb);
+}
+
+static int run_job(AVFormatContext *s, IOJob *job)
+{
+    int ret = 0;
+
+    switch (job->type) {
+    case IO_JOB_WRITE:
+        ret = run_write(s, job);
+        break;
+    case IO_JOB_CLOSE:
+        ret = ff_format_io_close(s, &job->pb);
+        break;
+    case IO_JOB_RENAME:
+        ret = ff_rename(job->url, job->url_dst, s);
+        break;
+    case IO_JOB_DELETE:
+        ret = run_delete(s, job);
+        if (ret == AVERROR(ENOENT)) {
+            av_log(s, AV_LOG_WARNING, "File '%s' to delete not found\n", job->url);
+            ret = 0;
+        }
+        break;
+    }
+    if (ret < 0 && job->url)
+        av_log(s, AV_LOG_ERROR, "Background I/O on '%s' failed: %s\n",
+               job->url, av_err2str(ret));
+    else if (ret < 0)
+        av_log(s, AV_LOG_ERROR, "Background I/O failed: %s\n", av_err2str(ret));
+    free_job(s, job);
+    return ret;
+}
+
+#if HAVE_THREADS
+
+static void *io_queue_thread(void *arg)
+{
+    FFIOQueue *q = arg;
+
+    pthread_mutex_lock(&q->lock);
+    for (;;) {
+        IOJob *job;
+        int64_t start;
+        int ret, size;
+
+        while (!q->nb_jobs && !q->quit)
+            pthread_cond_wait(&q->cond, &q->lock);
+        if (!q->nb_jobs)
+            break;
+
+        /* the job stays queued while it runs, so flushing waits for it */
+        job = &q->jobs[q->first_job];
+        pthread_mutex_unlock(&q->lock);
+        start = av_gettime_relative();
+        size  = job->type == IO_JOB_WRITE ? job->size : 0;
+        ret = run_job(q->s, job);
+        start = av_gettime_relative() - start;
+        pthread_mutex_lock(&q->lock);
+
+        q->io_time += start;
+        if (ret >= 0 && size) {
+            q->nb_files++;
+            q->bytes_written += size;
+        }
+        if (ret < 0 && !q->error)
+            q->error = ret;
+        q->first_job = (q->first_job + 1) % q->max_jobs;
+        q->nb_jobs--;
+        pthread_cond_broadcast(&q->cond);
+    }
+    pthread_mutex_unlock(&q->lock);
+
+    return NULL;
+}
+
+int ff_io_queue_alloc(FFIOQueue **pq, AVFormatContext *s, int max_jobs)
+{
+    FFIOQueue *q;
+    int ret;
+
+    *pq = NULL;
+    q = av_mallocz(sizeof(*q));
+    if (!q)
+        return AVERROR(ENOMEM);
+    q->jobs = av_calloc(max_jobs, sizeof(*q->jobs));
+    if (!q->jobs) {
+        av_free(q);
+        return AVERROR(ENOMEM);
+    }
+    q->s        = s;
+    q->max_jobs = max_jobs;
+
+    if ((ret = pthread_mutex_init(&q->lock, NULL))) {
+        ret = AVERROR(ret);
+        goto fail;
+    }
+    if ((ret = pthread_cond_init(&q->cond, NULL))) {
+        pthread_mutex_destroy(&q->lock);
+        ret = AVERROR(ret);
+        goto fail;
+    }
+    if ((ret = pthread_create(&q->thread, NULL, io_queue_thread, q))) {
+        pthread_cond_destroy(&q->cond);
+        pthread_mutex_destroy(&q->lock);
+        ret = AVERROR(ret);
+        goto fail;
+    }
+
+    *pq = q;
+    return 0;
+fail:
+    av_free(q->jobs);
+    av_free(q);
+    return ret;
+}
+
+static int submit(FFIOQueue *q, IOJob *job)
+{
+    pthread_mutex_lock(&q->lock);
+    if (q->nb_jobs == q->max_jobs) {
+        int64_t start = av_gettime_relative();
+        while (q->nb_jobs == q->max_jobs)
+            pthread_cond_wait(&q->cond, &q->lock);
+        q->wait_time += av_gettime_relative() - start;
+    }
+    q->jobs[(q->first_job + q->nb_jobs) % q->max_jobs] = *job;
+    q->nb_jobs++;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+    return 0;
+}
+
+int ff_io_queue_error(FFIOQueue *q)
+{
+    int ret;
+
+    pthread_mutex_lock(&q->lock);
+    ret      = q->error;
+    q->error = 0;
+    pthread_mutex_unlock(&q->lock);
+    return ret;
+}
+
+int ff_io_queue_flush(FFIOQueue *q)
+{
+    int64_t start = av_gettime_relative();
+
+    pthread_mutex_lock(&q->lock);
+    while (q->nb_jobs)
+        pthread_cond_wait(&q->cond, &q->lock);
+    q->wait_time += av_gettime_relative() - start;
+    pthread_mutex_unlock(&q->lock);
+    return ff_io_queue_error(q);
+}
+
+void ff_io_queue_free(FFIOQueue **pq)
+{
+    FFIOQueue *q = *pq;
+
+    if (!q)
+        return;
+
+    pthread_mutex_lock(&q->lock);
+    q->quit = 1;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+    pthread_join(q->thread, NULL);
+
+    av_log(q->s, AV_LOG_VERBOSE, "Background I/O: %d files, %"PRId64" bytes "
+           "written in %.3fs, muxer blocked for %.3fs\n", q->nb_files,
+           q->bytes_written, q->io_time / 1000000.0, q->wait_time / 1000000.0);
+
+    pthread_cond_destroy(&q->cond);
+    pthread_mutex_destroy(&q->lock);
+    av_free(q->jobs);
+    av_freep(pq);
+}
+
+#else
+
+int ff_io_queue_alloc(FFIOQueue **q, AVFormatContext *s, int max_jobs)
+{
+    *q = NULL;
+    return AVERROR(ENOSYS);
+}
+
+static int submit(FFIOQueue *q, IOJob *job)
+{
+    return AVERROR(ENOSYS);
+}
+
+int ff_io_queue_error(FFIOQueue *q)
+{
+    return 0;
+}
+
+int ff_io_queue_flush(FFIOQueue *q)
+{
+    return 0;
+}
+
+void ff_io_queue_free(FFIOQueue **q)
+{
+}
+
+#endif /* HAVE_THREADS */
+
+static int submit_or_free(FFIOQueue *q, IOJob *job)
+{
+    int ret = submit(q, job);
+    if (ret < 0)
+        free_job(q->s, job);
+    return ret;
+}
+
+int ff_io_queue_write(FFIOQueue *q, const char *url, AVDictionary **options,
+                      uint8_t *data, int size)
+{
+    IOJob job = {
+        .type    = IO_JOB_WRITE,
+        .url     = av_strdup(url),
+        .options = *options,
+        .data    = data,
+        .size    = size,
+    };
+
+    *options = NULL;
+    if (!job.url) {
+        free_job(q->s, &job);
+        return AVERROR(ENOMEM);
+    }
+    return submit_or_free(q, &job);
+}
+
+int ff_io_queue_close(FFIOQueue *q, AVIOContext **pb)
+{
+    IOJob job = {
+        .type = IO_JOB_CLOSE,
+        .pb   = *pb,
+    };
+
+    *pb = NULL;
+    if (!job.pb)
+        return 0;
+    return submit_or_free(q, &job);
+}
+
+int ff_io_queue_rename(FFIOQueue *q, const char *url_src, const char *url_dst)
+{
+    IOJob job = {
+        .type    = IO_JOB_RENAME,
+        .url     = av_strdup(url_src),
+        .url_dst = av_strdup(url_dst),
+    };
+
+    if (!job.url || !job.url_dst) {
+        free_job(q->s, &job);
+        return AVERROR(ENOMEM);
+    }
+    return submit_or_free(q, &job);
+}
+
+int ff_io_queue_delete(FFIOQueue *q, const char *url, AVDictionary **options)
+{
+    IOJob job = {
+        .type    = IO_JOB_DELETE,
+        .url     = av_strdup(url),
+        .options = options ? *options : NULL,
+    };
+
+    if (options)
+        *options = NULL;
+    if (!job.url) {
+        free_job(q->s, &job);
+        return AVERROR(ENOMEM);
+    }
+    return submit_or_free(q, &job);
+}
@@ -0,0 +1,101 @@
+/*
+ * Background I/O queue for muxers writing multiple files
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFORMAT_IOQUEUE_H
+#define AVFORMAT_IOQUEUE_H
+
+#include <stdint.h>
+
+#include "libavutil/dict.h"
+#include "avformat.h"
+#include "avio.h"
+
+/**
+ * A queue of file operations, run in submission order on a background
+ * thread, so that muxers splitting their output into segments do not
+ * block on finishing files, writing playlists or deleting old segments.
+ *
+ * Files are opened and closed with the io_open and io_close2 callbacks
+ * of the muxer context, which must therefore be thread-safe.
+ */
+typedef struct FFIOQueue FFIOQueue;
+
+/**
+ * Allocate a queue and start its thread.
+ *
+ * @param s        muxer context the operations are done for
+ * @param max_jobs number of operations which may be pending; submitting
+ *                 another one blocks until the oldest is done
+ * @return 0 on success, AVERROR(ENOSYS) without threading support, or
+ *         another negative error code
+ */
+int ff_io_queue_alloc(FFIOQueue **q, AVFormatContext *s, int max_jobs);
+
+/**
+ * Queue writing data to a new file.
+ *
+ * @param options options for io_open(), taken over by the queue
+ * @param data    contents of the file, allocated with av_malloc() and
+ *                taken over by the queue, also on failure
+ */
+int ff_io_queue_write(FFIOQueue *q, const char *url, AVDictionary **options,
+                      uint8_t *data, int size);
+
+/**
+ * Queue closing an AVIOContext opened with io_open(), which flushes
+ * the data still buffered in it. *pb is set to NULL.
+ */
+int ff_io_queue_close(FFIOQueue *q, AVIOContext **pb);
+
+/**
+ * Queue renaming a file, once the operations queued before are done.
+ */
+int ff_io_queue_rename(FFIOQueue *q, const char *url_src, const char *url_dst);
+
+/**
+ * Queue deleting a file.
+ *
+ * @param options if not NULL, the file is deleted by opening it with
+ *                these options, e.g. an HTTP DELETE request; they are
+ *                taken over by the queue. Otherwise ffurl_delete() is used.
+ */
+int ff_io_queue_delete(FFIOQueue *q, const char *url, AVDictionary **options);
+
+/**
+ * Return and clear the error of the first operation which failed since
+ * the last call, 0 if there is none.
+ */
+int ff_io_queue_error(FFIOQueue *q);
+
+/**
+ * Wait until all the queued operations are done.
+ *
+ * @return the same as ff_io_queue_error() afterwards
+ */
+int ff_io_queue_flush(FFIOQueue *q);
+
+/**
+ * Run the pending operations, stop the thread and free the queue. The
+ * amount of data written, the time spent on I/O and the time the muxer
+ * was blocked on the queue are logged at verbose level.
+ */
+void ff_io_queue_free(FFIOQueue **q);
+
+#endif /* AVFORMAT_IOQUEUE_H */
@@ -164,6 +164,29 @@ typedef struct MOVIndexRange {
     int64_t end;
 } MOVIndexRange;
 
+/** Where mov_build_index() stopped adding the entries of the samples */
+typedef struct MOVIndexBuild {
+    int started;
+    int incremental;    ///< entries can be added as they are read or seeked to
+    int done;
+    unsigned int chunk;
+    unsigned int chunk_sample;
+    unsigned int sample;
+    unsigned int stts_index;
+    unsigned int stts_sample;
+    unsigned int stsc_index;
+    unsigned int stss_index;
+    unsigned int stps_index;
+    unsigned int rap_group_index;
+    unsigned int rap_group_sample;
+    unsigned int distance;
+    int key_off;
+    int64_t offset;
+    int64_t dts;
+    int64_t last_key_dts; ///< timestamp of the last keyframe entry added
+    uint64_t stream_size;
+} MOVIndexBuild;
+
 typedef struct MOVStreamContext {
     AVIOContext *pb;
     int refcount;
@@ -222,6 +245,7 @@ typedef struct MOVStreamContext {
     uint32_t tmcd_flags;  ///< tmcd track flags
     uint8_t tmcd_nb_frames;  ///< tmcd number of frames per tick / second
     int64_t track_end;    ///< used for dts generation in fragmented movie files
+    int64_t moov_track_end; ///< track_end before any fragment, used by lazy_frag_index
     int start_pad;        ///< amount of samples to skip due to enc-dec delay
     unsigned int rap_group_count;
     MOVSbgp *rap_group;
@@ -267,6 +291,9 @@ typedef struct MOVStreamContext {
     } cenc;
 
     struct IAMFDemuxContext *iamf;
+
+    int index_pending;  ///< sample tables kept, index not complete yet (lazy_index)
+    MOVIndexBuild index_build;
 } MOVStreamContext;
 
 typedef struct HEIFItem {
@@ -356,6 +383,10 @@ typedef struct MOVContext {
     int thmb_item_id;
     int64_t idat_offset;
     int interleaved_read;
+    int lazy_index;
+    int nb_pending_indexes;
+    int lazy_index_started; ///< packets were read or seeked to since opening
+    int lazy_frag_index;
 } MOVContext;
 
 int ff_mp4_read_descr_len(AVIOContext *pb);
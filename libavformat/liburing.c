@@ -0,0 +1,484 @@
+/*
+ * io_uring based file protocol
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * File protocol doing its I/O through io_uring: reads are prefetched
+ * queue_depth blocks ahead of the reader, writes are queued behind the
+ * writer and only waited for when their buffer is needed again.
+ */
+
+#define _GNU_SOURCE /* O_DIRECT */
+
+#include <liburing.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "libavutil/avstring.h"
+#include "libavutil/file_open.h"
+#include "libavutil/macros.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+#include "avio.h"
+#include "url.h"
+
+/* Alignment of the buffers, offsets and block size, as required by O_DIRECT */
+#define URING_ALIGN 4096
+
+enum URingSlotState {
+    SLOT_IDLE,
+    SLOT_PENDING,
+    SLOT_DONE,
+};
+
+typedef struct URingSlot {
+    uint8_t *buf;
+    int64_t offset;                 ///< file offset of the block
+    int size;                       ///< bytes to write, or bytes read so far / read error
+    int eof;                        ///< the last read hit the end of the file
+    enum URingSlotState state;
+} URingSlot;
+
+typedef struct URingContext {
+    const AVClass *class;
+    int queue_depth;
+    int block_size;
+    int direct;
+    int fixed_buffers;
+    int trunc;
+
+    int fd;
+    int write;
+    struct io_uring ring;
+    int ring_initialized;
+    uint8_t *buffer;
+    URingSlot *slots;
+    int nb_pending;
+    int error;                      ///< first failed write, reported on the next call
+
+    int64_t pos;
+    int64_t file_size;
+    int64_t first_block;            ///< first block of the read-ahead window
+    int64_t next_block;             ///< next block to submit a read for
+    int cur_slot;                   ///< slot being filled by writes
+} URingContext;
+
+static int uring_submit(URingContext *c)
+{
+    int ret = io_uring_submit(&c->ring);
+    return ret < 0 ? AVERROR(-ret) : 0;
+}
+
+static int uring_prep(URingContext *c, int idx)
+{
+    URingSlot *slot = &c->slots[idx];
+    struct io_uring_sqe *sqe = io_uring_get_sqe(&c->ring);
+
+    if (!sqe) {
+        /* the submission queue is full, hand what is in it to the kernel */
+        int ret = uring_submit(c);
+        if (ret < 0)
+            return ret;
+        if (!(sqe = io_uring_get_sqe(&c->ring)))
+            return AVERROR(EAGAIN);
+    }
+
+    if (c->write) {
+        if (c->fixed_buffers)
+            io_uring_prep_write_fixed(sqe, c->fd, slot->buf, slot->size, slot->offset, idx);
+        else
+            io_uring_prep_write(sqe, c->fd, slot->buf, slot->size, slot->offset);
+    } else {
+        /* continue after whatever an earlier short read already filled in */
+        uint8_t *buf = slot->buf + slot->size;
+        int64_t offset = slot->offset + slot->size;
+        int size = c->block_size - slot->size;
+
+        if (c->fixed_buffers)
+            io_uring_prep_read_fixed(sqe, c->fd, buf, size, offset, idx);
+        else
+            io_uring_prep_read(sqe, c->fd, buf, size, offset);
+    }
+    io_uring_sqe_set_data(sqe, slot);
+    slot->state = SLOT_PENDING;
+    c->nb_pending++;
+    return 0;
+}
+
+/* Wait for one completion and update the slot it belongs to. */
+static int uring_reap(URingContext *c)
+{
+    struct io_uring_cqe *cqe;
+    URingSlot *slot;
+    int ret, res;
+
+    do {
+        ret = io_uring_wait_cqe(&c->ring, &cqe);
+    } while (ret == -EINTR);
+    if (ret < 0)
+        return AVERROR(-ret);
+
+    slot = io_uring_cqe_get_data(cqe);
+    res  = cqe->res;
+    io_uring_cqe_seen(&c->ring, cqe);
+    c->nb_pending--;
+
+    if (c->write) {
+        if (res >= 0 && res < slot->size)
+            res = -EIO;
+        if (res < 0 && !c->error)
+            c->error = AVERROR(-res);
+        slot->size  = 0;
+        slot->state = SLOT_IDLE;
+    } else {
+        slot->size  = res < 0 ? res : slot->size + res;
+        slot->eof   = !res;
+        slot->state = SLOT_DONE;
+    }
+    return 0;
+}
+
+static int uring_wait_slot(URingContext *c, int idx)
+{
+    while (c->slots[idx].state == SLOT_PENDING) {
+        int ret = uring_reap(c);
+        if (ret < 0)
+            return ret;
+    }
+    return 0;
+}
+
+static int uring_drain(URingContext *c)
+{
+    while (c->nb_pending) {
+        int ret = uring_reap(c);
+        if (ret < 0)
+            return ret;
+    }
+    return c->error;
+}
+
+/* Queue the slot being filled and make the next one available. */
+static int uring_flush_slot(URingContext *c)
+{
+    int ret;
+
+    if (c->slots[c->cur_slot].size) {
+        if ((ret = uring_prep(c, c->cur_slot)) < 0 ||
+            (ret = uring_submit(c)) < 0)
+            return ret;
+        c->cur_slot = (c->cur_slot + 1) % c->queue_depth;
+        if ((ret = uring_wait_slot(c, c->cur_slot)) < 0)
+            return ret;
+    }
+    return c->error;
+}
+
+static int uring_read(URLContext *h, unsigned char *buf, int size)
+{
+    URingContext *c = h->priv_data;
+    int64_t block = c->pos / c->block_size;
+    URingSlot *slot;
+    int ret, idx, off, queued = 0;
+
+    if (c->pos >= c->file_size)
+        return AVERROR_EOF;
+
+    if (block < c->first_block || block >= c->next_block) {
+        /* the reader moved away from the read-ahead window, restart it */
+        if ((ret = uring_drain(c)) < 0)
+            return ret;
+        c->first_block = c->next_block = block;
+    } else {
+        /* the reader skipped blocks inside the window, their reads have to
+         * complete before the slots can be queued again */
+        for (; c->first_block < block; c->first_block++) {
+            idx = c->first_block % c->queue_depth;
+            if ((ret = uring_wait_slot(c, idx)) < 0)
+                return ret;
+            c->slots[idx].state = SLOT_IDLE;
+        }
+    }
+
+    while (c->next_block < c->first_block + c->queue_depth &&
+           c->next_block * c->block_size < c->file_size) {
+        idx = c->next_block % c->queue_depth;
+        c->slots[idx].offset = c->next_block * c->block_size;
+        c->slots[idx].size   = 0;
+        if ((ret = uring_prep(c, idx)) < 0)
+            return ret;
+        c->next_block++;
+        queued = 1;
+    }
+    if (queued && (ret = uring_submit(c)) < 0)
+        return ret;
+
+    idx  = block % c->queue_depth;
+    slot = &c->slots[idx];
+    if ((ret = uring_wait_slot(c, idx)) < 0)
+        return ret;
+    /* a read may complete short of the block without being at the end of
+     * the file, queue the remainder until the block is full or EOF is hit */
+    while (slot->size >= 0 && !slot->eof &&
+           slot->size < FFMIN(c->block_size, c->file_size - slot->offset)) {
+        if ((ret = uring_prep(c, idx)) < 0 || (ret = uring_submit(c)) < 0 ||
+            (ret = uring_wait_slot(c, idx)) < 0)
+            return ret;
+    }
+    if (slot->size < 0) {
+        ret = AVERROR(-slot->size);
+        /* drop the window so that the block is read again on retry */
+        uring_drain(c);
+        c->first_block = c->next_block = 0;
+        return ret;
+    }
+
+    off = c->pos - slot->offset;
+    if (off >= slot->size)
+        return AVERROR_EOF;
+    size = FFMIN(size, slot->size - off);
+    memcpy(buf, slot->buf + off, size);
+    c->pos += size;
+
+    if (c->pos >= slot->offset + c->block_size) {
+        slot->state    = SLOT_IDLE;
+        c->first_block = block + 1;
+    }
+    return size;
+}
+
+static int uring_write(URLContext *h, const unsigned char *buf, int size)
+{
+    URingContext *c = h->priv_data;
+    URingSlot *slot = &c->slots[c->cur_slot];
+    int ret;
+
+    if (c->error)
+        return c->error;
+
+    if (!slot->size)
+        slot->offset = c->pos;
+    size = FFMIN(size, c->block_size - slot->size);
+    memcpy(slot->buf + slot->size, buf, size);
+    slot->size += size;
+    c->pos     += size;
+
+    if (slot->size == c->block_size && (ret = uring_flush_slot(c)) < 0)
+        return ret;
+    return size;
+}
+
+static int64_t uring_seek(URLContext *h, int64_t pos, int whence)
+{
+    URingContext *c = h->priv_data;
+    int ret;
+
+    if (c->write) {
+        /* queued writes may overlap the new position, complete them first */
+        if ((ret = uring_flush_slot(c)) < 0 || (ret = uring_drain(c)) < 0)
+            return ret;
+        if (whence == AVSEEK_SIZE || whence == SEEK_END) {
+            struct stat st;
+            if (fstat(c->fd, &st) < 0)
+                return AVERROR(errno);
+            c->file_size = st.st_size;
+        }
+    }
+
+    switch (whence) {
+    case AVSEEK_SIZE:
+        return c->file_size;
+    case SEEK_SET:
+        break;
+    case SEEK_CUR:
+        pos += c->pos;
+        break;
+    case SEEK_END:
+        pos += c->file_size;
+        break;
+    default:
+        return AVERROR(EINVAL);
+    }
+    if (pos < 0)
+        return AVERROR(EINVAL);
+
+    c->pos = pos;
+    return pos;
+}
+
+static int uring_get_handle(URLContext *h)
+{
+    URingContext *c = h->priv_data;
+    return c->fd;
+}
+
+static av_cold void uring_free(URingContext *c)
+{
+    if (c->ring_initialized)
+        io_uring_queue_exit(&c->ring);
+    c->ring_initialized = 0;
+    if (c->fd >= 0)
+        close(c->fd);
+    c->fd = -1;
+    av_freep(&c->slots);
+    av_freep(&c->buffer);
+}
+
+static av_cold int uring_close(URLContext *h)
+{
+    URingContext *c = h->priv_data;
+    int ret = 0;
+
+    if (c->write) {
+        ret = uring_flush_slot(c);
+        if (!ret)
+            ret = uring_drain(c);
+    } else {
+        uring_drain(c);
+    }
+    uring_free(c);
+    return ret;
+}
+
+static av_cold int uring_open(URLContext *h, const char *filename, int flags)
+{
+    URingContext *c = h->priv_data;
+    uint8_t *buf;
+    struct stat st;
+    int access, ret, i;
+
+    av_strstart(filename, "uring:", &filename);
+    c->fd = -1;
+
+    if ((flags & AVIO_FLAG_READ_WRITE) == AVIO_FLAG_READ_WRITE) {
+        av_log(h, AV_LOG_ERROR, "Opening for both reading and writing is not supported\n");
+        return AVERROR(ENOSYS);
+    }
+    c->write      = !!(flags & AVIO_FLAG_WRITE);
+    c->block_size = FFALIGN(c->block_size, URING_ALIGN);
+
+    if (c->write) {
+        access = O_CREAT | O_WRONLY;
+        if (c->trunc)
+            access |= O_TRUNC;
+        if (c->direct)
+            av_log(h, AV_LOG_WARNING, "Direct I/O is only used for reading\n");
+    } else {
+        access = O_RDONLY;
+        if (c->direct)
+            access |= O_DIRECT;
+    }
+    c->fd = avpriv_open(filename, access, 0666);
+    if (c->fd < 0)
+        return AVERROR(errno);
+
+    if (fstat(c->fd, &st) < 0) {
+        ret = AVERROR(errno);
+        goto fail;
+    }
+    if (!S_ISREG(st.st_mode)) {
+        av_log(h, AV_LOG_ERROR, "Only regular files are supported\n");
+        ret = AVERROR(EINVAL);
+        goto fail;
+    }
+    c->file_size = st.st_size;
+
+    c->buffer = av_malloc((size_t)c->queue_depth * c->block_size + URING_ALIGN);
+    c->slots  = av_calloc(c->queue_depth, sizeof(*c->slots));
+    if (!c->buffer || !c->slots) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    buf = (uint8_t *)FFALIGN((uintptr_t)c->buffer, URING_ALIGN);
+    for (i = 0; i < c->queue_depth; i++)
+        c->slots[i].buf = buf + (size_t)i * c->block_size;
+
+    ret = io_uring_queue_init(c->queue_depth, &c->ring, 0);
+    if (ret < 0) {
+        av_log(h, AV_LOG_ERROR, "Could not set up the io_uring queue: %s\n",
+               av_err2str(AVERROR(-ret)));
+        ret = AVERROR(-ret);
+        goto fail;
+    }
+    c->ring_initialized = 1;
+
+    if (c->fixed_buffers) {
+        struct iovec *iov = av_calloc(c->queue_depth, sizeof(*iov));
+        if (!iov) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+        for (i = 0; i < c->queue_depth; i++) {
+            iov[i].iov_base = c->slots[i].buf;
+            iov[i].iov_len  = c->block_size;
+        }
+        ret = io_uring_register_buffers(&c->ring, iov, c->queue_depth);
+        av_free(iov);
+        if (ret < 0) {
+            av_log(h, AV_LOG_WARNING, "Could not register the buffers, "
+                   "using unregistered ones: %s\n", av_err2str(AVERROR(-ret)));
+            c->fixed_buffers = 0;
+        }
+    }
+
+    /* Hand blocks to the protocol in one go when writing. */
+    if (c->write)
+        h->min_packet_size = h->max_packet_size = c->block_size;
+
+    return 0;
+
+fail:
+    uring_free(c);
+    return ret;
+}
+
+#define OFFSET(x) offsetof(URingContext, x)
+#define D AV_OPT_FLAG_DECODING_PARAM
+#define E AV_OPT_FLAG_ENCODING_PARAM
+static const AVOption options[] = {
+    { "queue_depth",   "set the number of blocks in flight",          OFFSET(queue_depth),   AV_OPT_TYPE_INT,  { .i64 = 16 }, 1, 4096, D|E },
+    { "block_size",    "set the size of each I/O request",            OFFSET(block_size),    AV_OPT_TYPE_INT,  { .i64 = 256 * 1024 }, URING_ALIGN, 64 * 1024 * 1024, D|E },
+    { "direct",        "bypass the page cache with O_DIRECT when reading", OFFSET(direct),   AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, D|E },
+    { "fixed_buffers", "register the I/O buffers with the kernel",    OFFSET(fixed_buffers), AV_OPT_TYPE_BOOL, { .i64 = 1 }, 0, 1, D|E },
+    { "truncate",      "truncate existing files on write",            OFFSET(trunc),         AV_OPT_TYPE_BOOL, { .i64 = 1 }, 0, 1, E },
+    { NULL }
+};
+
+static const AVClass liburing_context_class = {
+    .class_name = "uring",
+    .item_name  = av_default_item_name,
+    .option     = options,
+    .version    = LIBAVUTIL_VERSION_INT,
+};
+
+const URLProtocol ff_liburing_protocol = {
+    .name                = "uring",
+    .url_open            = uring_open,
+    .url_read            = uring_read,
+    .url_write           = uring_write,
+    .url_seek            = uring_seek,
+    .url_close           = uring_close,
+    .url_get_file_handle = uring_get_handle,
+    .priv_data_size      = sizeof(URingContext),
+    .priv_data_class     = &liburing_context_class,
+};
@@ -84,6 +84,9 @@ typedef struct MOVParseTableEntry {
 static int mov_read_default(MOVContext *c, AVIOContext *pb, MOVAtom atom);
 static int mov_read_mfra(MOVContext *c, AVIOContext *f);
 static void mov_free_stream_context(AVFormatContext *s, AVStream *st);
+static int mov_seek_stream(AVFormatContext *s, AVStream *st, int64_t timestamp, int flags);
+static int mov_switch_root(AVFormatContext *s, int64_t target, int index);
+static void mov_build_pending_index(MOVContext *mov, AVStream *st);
 static int64_t add_ctts_entry(MOVCtts** ctts_data, unsigned int* ctts_count, unsigned int* allocated_size,
                               int count, int duration);
 
@@ -1674,13 +1677,20 @@ static void fix_frag_index_entries(MOVFragmentIndex *frag_index, int index,
 
 static int mov_read_moof(MOVContext *c, AVIOContext *pb, MOVAtom atom)
 {
+    int complete = c->frag_index.complete;
+    int ret;
+
     // Set by mov_read_tfhd(). mov_read_trun() will reject files missing tfhd.
     c->fragment.found_tfhd = 0;
 
-    if (!c->has_looked_for_mfra && c->use_mfra_for > 0) {
+    /* fragments append to the index, so it must exist first */
+    for (int i = 0; i < c->fc->nb_streams && c->nb_pending_indexes; i++)
+        mov_build_pending_index(c, c->fc->streams[i]);
+
+    if (!c->has_looked_for_mfra &&
+        (c->use_mfra_for > 0 || (c->lazy_frag_index && !c->frag_index.complete))) {
         c->has_looked_for_mfra = 1;
         if (pb->seekable & AVIO_SEEKABLE_NORMAL) {
-            int ret;
             av_log(c->fc, AV_LOG_VERBOSE, "stream has moof boxes, will look "
                     "for a mfra\n");
             if ((ret = mov_read_mfra(c, pb)) < 0) {
@@ -1695,7 +1705,15 @@ static int mov_read_moof(MOVContext *c, AVIOContext *pb, MOVAtom atom)
     c->fragment.moof_offset = c->fragment.implicit_offset = avio_tell(pb) - 8;
     av_log(c->fc, AV_LOG_TRACE, "moof offset %"PRIx64"\n", c->fragment.moof_offset);
     c->frag_index.current = update_frag_index(c, c->fragment.moof_offset);
-    return mov_read_default(c, pb, atom);
+    if (complete || !c->frag_index.complete)
+        return mov_read_default(c, pb, atom);
+
+    /* The mfra just completed the fragment index, which would make
+     * mov_read_default() stop after the first child box of this moof. */
+    c->frag_index.complete = 0;
+    ret = mov_read_default(c, pb, atom);
+    c->frag_index.complete = 1;
+    return ret;
 }
 
 static void mov_metadata_creation_time(MOVContext *c, AVIOContext *pb, AVDictionary **metadata, int version)
@@ -3462,7 +3480,7 @@ static int mov_read_stts(MOVContext *c, AVIOContext *pb, MOVAtom atom)
                st->index, sc->id);
         st->discard = AVDISCARD_ALL;
     }
-    sc->track_end = duration;
+    sc->track_end = sc->moov_track_end = duration;
     return 0;
 }
 
@@ -3936,6 +3954,10 @@ static void mov_estimate_video_delay(MOVContext *c, AVStream* st)
     int64_t pts_buf[MAX_REORDER_DELAY + 1]; // Circular buffer to sort pts.
     int buf_start = 0;
     int j, r, num_swaps;
+    // a pending index has the timestamps of the stts table, see mov_build_index()
+    int64_t dts = -msc->dts_shift;
+    unsigned int stts_ind = 0, stts_sample = 0;
+    int64_t nb_samples = msc->index_pending ? msc->sample_count : sti->nb_index_entries;
 
     for (j = 0; j < MAX_REORDER_DELAY + 1; j++)
         pts_buf[j] = INT64_MIN;
@@ -3943,14 +3965,23 @@ static void mov_estimate_video_delay(MOVContext *c, AVStream* st)
     if (st->codecpar->video_delay <= 0 && msc->ctts_data &&
         st->codecpar->codec_id == AV_CODEC_ID_H264) {
         st->codecpar->video_delay = 0;
-        for (int ind = 0; ind < sti->nb_index_entries && ctts_ind < msc->ctts_count; ++ind) {
+        for (int64_t ind = 0; ind < nb_samples && ctts_ind < msc->ctts_count; ++ind) {
             // Point j to the last elem of the buffer and insert the current pts there.
             j = buf_start;
             buf_start = (buf_start + 1);
             if (buf_start == MAX_REORDER_DELAY + 1)
                 buf_start = 0;
 
-            pts_buf[j] = sti->index_entries[ind].timestamp + msc->ctts_data[ctts_ind].duration;
+            if (msc->index_pending) {
+                pts_buf[j] = dts + msc->ctts_data[ctts_ind].duration;
+                dts += msc->stts_data[stts_ind].duration;
+                if (stts_ind + 1 < msc->stts_count && ++stts_sample == msc->stts_data[stts_ind].count) {
+                    stts_sample = 0;
+                    stts_ind++;
+                }
+            } else {
+                pts_buf[j] = sti->index_entries[ind].timestamp + msc->ctts_data[ctts_ind].duration;
+            }
 
             // The timestamps that are already in the sorted buffer, and are greater than the
             // current pts, are exactly the timestamps that need to be buffered to output PTS
@@ -4411,133 +4442,149 @@ static int build_open_gop_key_points(AVStream *st)
     return 0;
 }
 
-static void mov_build_index(MOVContext *mov, AVStream *st)
+/**
+ * Set the time offset of a track from the start of its edit list, and the
+ * AAC padding when the advanced edit list support is disabled.
+ */
+static void mov_set_edit_list_offset(MOVContext *mov, AVStream *st)
 {
     MOVStreamContext *sc = st->priv_data;
-    FFStream *const sti = ffstream(st);
-    int64_t current_offset;
-    int64_t current_dts = 0;
-    unsigned int stts_index = 0;
-    unsigned int stsc_index = 0;
-    unsigned int stss_index = 0;
-    unsigned int stps_index = 0;
-    unsigned int i, j;
-    uint64_t stream_size = 0;
-    MOVCtts *ctts_data_old = sc->ctts_data;
-    unsigned int ctts_count_old = sc->ctts_count;
+    int i, edit_start_index = 0, multiple_edits = 0;
+    int64_t empty_duration = 0; // empty duration of the first edit list entry
+    int64_t start_time = 0; // start time of the media
+
+    for (i = 0; i < sc->elst_count; i++) {
+        const MOVElst *e = &sc->elst_data[i];
+        if (i == 0 && e->time == -1) {
+            /* if empty, the first entry is the start time of the stream
+             * relative to the presentation itself */
+            empty_duration = e->duration;
+            edit_start_index = 1;
+        } else if (i == edit_start_index && e->time >= 0) {
+            start_time = e->time;
+        } else {
+            multiple_edits = 1;
+        }
+    }
 
-    int ret = build_open_gop_key_points(st);
-    if (ret < 0)
-        return;
+    if (multiple_edits && !mov->advanced_editlist) {
+        if (mov->advanced_editlist_autodisabled)
+            av_log(mov->fc, AV_LOG_WARNING, "multiple edit list entries, "
+                   "not supported in fragmented MP4 files\n");
+        else
+            av_log(mov->fc, AV_LOG_WARNING, "multiple edit list entries, "
+                   "Use -advanced_editlist to correctly decode otherwise "
+                   "a/v desync might occur\n");
+    }
 
-    if (sc->elst_count) {
-        int i, edit_start_index = 0, multiple_edits = 0;
-        int64_t empty_duration = 0; // empty duration of the first edit list entry
-        int64_t start_time = 0; // start time of the media
-
-        for (i = 0; i < sc->elst_count; i++) {
-            const MOVElst *e = &sc->elst_data[i];
-            if (i == 0 && e->time == -1) {
-                /* if empty, the first entry is the start time of the stream
-                 * relative to the presentation itself */
-                empty_duration = e->duration;
-                edit_start_index = 1;
-            } else if (i == edit_start_index && e->time >= 0) {
-                start_time = e->time;
-            } else {
-                multiple_edits = 1;
-            }
-        }
+    /* adjust first dts according to edit list */
+    if ((empty_duration || start_time) && mov->time_scale > 0) {
+        if (empty_duration)
+            empty_duration = av_rescale(empty_duration, sc->time_scale, mov->time_scale);
 
-        if (multiple_edits && !mov->advanced_editlist) {
-            if (mov->advanced_editlist_autodisabled)
-                av_log(mov->fc, AV_LOG_WARNING, "multiple edit list entries, "
-                       "not supported in fragmented MP4 files\n");
-            else
-                av_log(mov->fc, AV_LOG_WARNING, "multiple edit list entries, "
-                       "Use -advanced_editlist to correctly decode otherwise "
-                       "a/v desync might occur\n");
-        }
+        if (av_sat_sub64(start_time, empty_duration) != start_time - (uint64_t)empty_duration)
+            av_log(mov->fc, AV_LOG_WARNING, "start_time - empty_duration is not representable\n");
 
-        /* adjust first dts according to edit list */
-        if ((empty_duration || start_time) && mov->time_scale > 0) {
-            if (empty_duration)
-                empty_duration = av_rescale(empty_duration, sc->time_scale, mov->time_scale);
+        sc->time_offset = start_time -  (uint64_t)empty_duration;
+        sc->min_corrected_pts = start_time;
+    }
 
-            if (av_sat_sub64(start_time, empty_duration) != start_time - (uint64_t)empty_duration)
-                av_log(mov->fc, AV_LOG_WARNING, "start_time - empty_duration is not representable\n");
+    if (!multiple_edits && !mov->advanced_editlist &&
+        st->codecpar->codec_id == AV_CODEC_ID_AAC && start_time > 0)
+        sc->start_pad = start_time;
+}
 
-            sc->time_offset = start_time -  (uint64_t)empty_duration;
-            sc->min_corrected_pts = start_time;
-            if (!mov->advanced_editlist)
-                current_dts = -sc->time_offset;
-        }
+/**
+ * Allocate nb_entries index entries for a track, expand its ctts table to
+ * one entry per sample and set up mov_build_index_samples().
+ */
+static int mov_init_index_build(MOVContext *mov, AVStream *st, unsigned int nb_entries)
+{
+    MOVStreamContext *sc = st->priv_data;
+    FFStream *const sti = ffstream(st);
+    MOVIndexBuild *b = &sc->index_build;
+    MOVCtts *ctts_data_old = sc->ctts_data;
+    unsigned int ctts_count_old = sc->ctts_count;
+    unsigned int i, j;
 
-        if (!multiple_edits && !mov->advanced_editlist &&
-            st->codecpar->codec_id == AV_CODEC_ID_AAC && start_time > 0)
-            sc->start_pad = start_time;
+    if (sc->sample_count >= UINT_MAX / sizeof(*sti->index_entries) - sti->nb_index_entries)
+        return AVERROR(ENOMEM);
+    if (av_reallocp_array(&sti->index_entries,
+                          sti->nb_index_entries + nb_entries,
+                          sizeof(*sti->index_entries)) < 0) {
+        sti->nb_index_entries = 0;
+        return AVERROR(ENOMEM);
     }
+    sti->index_entries_allocated_size = (sti->nb_index_entries + nb_entries) * sizeof(*sti->index_entries);
 
-    /* only use old uncompressed audio chunk demuxing when stts specifies it */
-    if (!(st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO &&
-          sc->stts_count == 1 && sc->stts_data[0].duration == 1)) {
-        unsigned int current_sample = 0;
-        unsigned int stts_sample = 0;
-        unsigned int sample_size;
-        unsigned int distance = 0;
-        unsigned int rap_group_index = 0;
-        unsigned int rap_group_sample = 0;
-        int rap_group_present = sc->rap_group_count && sc->rap_group;
-        int key_off = (sc->keyframe_count && sc->keyframes[0] > 0) || (sc->stps_count && sc->stps_data[0] > 0);
+    if (ctts_data_old) {
+        // Expand ctts entries such that we have a 1-1 mapping with samples
+        if (sc->sample_count >= UINT_MAX / sizeof(*sc->ctts_data))
+            return AVERROR(ENOMEM);
+        sc->ctts_count = 0;
+        sc->ctts_allocated_size = 0;
+        sc->ctts_data = av_fast_realloc(NULL, &sc->ctts_allocated_size,
+                                sc->sample_count * sizeof(*sc->ctts_data));
+        if (!sc->ctts_data) {
+            av_free(ctts_data_old);
+            return AVERROR(ENOMEM);
+        }
 
-        current_dts -= sc->dts_shift;
+        memset((uint8_t*)(sc->ctts_data), 0, sc->ctts_allocated_size);
 
-        if (!sc->sample_count || sti->nb_index_entries)
-            return;
-        if (sc->sample_count >= UINT_MAX / sizeof(*sti->index_entries) - sti->nb_index_entries)
-            return;
-        if (av_reallocp_array(&sti->index_entries,
-                              sti->nb_index_entries + sc->sample_count,
-                              sizeof(*sti->index_entries)) < 0) {
-            sti->nb_index_entries = 0;
-            return;
-        }
-        sti->index_entries_allocated_size = (sti->nb_index_entries + sc->sample_count) * sizeof(*sti->index_entries);
+        for (i = 0; i < ctts_count_old &&
+                    sc->ctts_count < sc->sample_count; i++)
+            for (j = 0; j < ctts_data_old[i].count &&
+                        sc->ctts_count < sc->sample_count; j++)
+                add_ctts_entry(&sc->ctts_data, &sc->ctts_count,
+                               &sc->ctts_allocated_size, 1,
+                               ctts_data_old[i].duration);
+        av_free(ctts_data_old);
+    }
 
-        if (ctts_data_old) {
-            // Expand ctts entries such that we have a 1-1 mapping with samples
-            if (sc->sample_count >= UINT_MAX / sizeof(*sc->ctts_data))
-                return;
-            sc->ctts_count = 0;
-            sc->ctts_allocated_size = 0;
-            sc->ctts_data = av_fast_realloc(NULL, &sc->ctts_allocated_size,
-                                    sc->sample_count * sizeof(*sc->ctts_data));
-            if (!sc->ctts_data) {
-                av_free(ctts_data_old);
-                return;
-            }
+    b->started      = 1;
+    b->key_off      = (sc->keyframe_count && sc->keyframes[0] > 0) || (sc->stps_count && sc->stps_data[0] > 0);
+    b->dts          = (mov->advanced_editlist ? 0 : -sc->time_offset) - sc->dts_shift;
+    b->last_key_dts = INT64_MIN;
+    return 0;
+}
 
-            memset((uint8_t*)(sc->ctts_data), 0, sc->ctts_allocated_size);
+/**
+ * Add the index entries of the samples of a track, from where the previous
+ * call stopped, until there are nb_entries of them and a keyframe after
+ * timestamp was added, or until the entries of all samples were added.
+ *
+ * @param timestamp AV_NOPTS_VALUE if only the number of entries matters
+ * @return 0, or a negative error code if the sample tables are invalid, in
+ *         which case no more entries are added
+ */
+static int mov_build_index_samples(MOVContext *mov, AVStream *st,
+                                   int64_t nb_entries, int64_t timestamp)
+{
+    MOVStreamContext *sc = st->priv_data;
+    FFStream *const sti = ffstream(st);
+    MOVIndexBuild *b = &sc->index_build;
+    int rap_group_present = sc->rap_group_count && sc->rap_group;
 
-            for (i = 0; i < ctts_count_old &&
-                        sc->ctts_count < sc->sample_count; i++)
-                for (j = 0; j < ctts_data_old[i].count &&
-                            sc->ctts_count < sc->sample_count; j++)
-                    add_ctts_entry(&sc->ctts_data, &sc->ctts_count,
-                                   &sc->ctts_allocated_size, 1,
-                                   ctts_data_old[i].duration);
-            av_free(ctts_data_old);
-        }
+    while (!b->done &&
+           (sti->nb_index_entries < nb_entries ||
+            (timestamp != AV_NOPTS_VALUE && b->last_key_dts <= timestamp))) {
+        unsigned int sample_size;
+        int keyframe = 0;
 
-        for (i = 0; i < sc->chunk_count; i++) {
-            int64_t next_offset = i+1 < sc->chunk_count ? sc->chunk_offsets[i+1] : INT64_MAX;
-            current_offset = sc->chunk_offsets[i];
-            while (mov_stsc_index_valid(stsc_index, sc->stsc_count) &&
-                i + 1 == sc->stsc_data[stsc_index + 1].first)
-                stsc_index++;
+        if (b->chunk >= sc->chunk_count) {
+            b->done = 1;
+            break;
+        }
+        if (!b->chunk_sample) {
+            int64_t next_offset = b->chunk + 1 < sc->chunk_count ? sc->chunk_offsets[b->chunk + 1] : INT64_MAX;
+            b->offset = sc->chunk_offsets[b->chunk];
+            while (mov_stsc_index_valid(b->stsc_index, sc->stsc_count) &&
+                b->chunk + 1 == sc->stsc_data[b->stsc_index + 1].first)
+                b->stsc_index++;
 
-            if (next_offset > current_offset && sc->sample_size>0 && sc->sample_size < sc->stsz_sample_size &&
-                sc->stsc_data[stsc_index].count * (int64_t)sc->stsz_sample_size > next_offset - current_offset) {
+            if (next_offset > b->offset && sc->sample_size>0 && sc->sample_size < sc->stsz_sample_size &&
+                sc->stsc_data[b->stsc_index].count * (int64_t)sc->stsz_sample_size > next_offset - b->offset) {
                 av_log(mov->fc, AV_LOG_WARNING, "STSZ sample size %d invalid (too large), ignoring\n", sc->stsz_sample_size);
                 sc->stsz_sample_size = sc->sample_size;
             }
@@ -4545,88 +4592,147 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
                 av_log(mov->fc, AV_LOG_WARNING, "STSZ sample size %d invalid (too small), ignoring\n", sc->stsz_sample_size);
                 sc->stsz_sample_size = sc->sample_size;
             }
+        }
+        if (b->chunk_sample >= sc->stsc_data[b->stsc_index].count) {
+            b->chunk++;
+            b->chunk_sample = 0;
+            continue;
+        }
 
-            for (j = 0; j < sc->stsc_data[stsc_index].count; j++) {
-                int keyframe = 0;
-                if (current_sample >= sc->sample_count) {
-                    av_log(mov->fc, AV_LOG_ERROR, "wrong sample count\n");
-                    return;
-                }
+        if (b->sample >= sc->sample_count) {
+            av_log(mov->fc, AV_LOG_ERROR, "wrong sample count\n");
+            b->done = 1;
+            return AVERROR_INVALIDDATA;
+        }
 
-                if (!sc->keyframe_absent && (!sc->keyframe_count || current_sample+key_off == sc->keyframes[stss_index])) {
-                    keyframe = 1;
-                    if (stss_index + 1 < sc->keyframe_count)
-                        stss_index++;
-                } else if (sc->stps_count && current_sample+key_off == sc->stps_data[stps_index]) {
-                    keyframe = 1;
-                    if (stps_index + 1 < sc->stps_count)
-                        stps_index++;
-                }
-                if (rap_group_present && rap_group_index < sc->rap_group_count) {
-                    if (sc->rap_group[rap_group_index].index > 0)
-                        keyframe = 1;
-                    if (++rap_group_sample == sc->rap_group[rap_group_index].count) {
-                        rap_group_sample = 0;
-                        rap_group_index++;
-                    }
-                }
-                if (sc->keyframe_absent
-                    && !sc->stps_count
-                    && !rap_group_present
-                    && (st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO || (i==0 && j==0)))
-                     keyframe = 1;
-                if (keyframe)
-                    distance = 0;
-                sample_size = sc->stsz_sample_size > 0 ? sc->stsz_sample_size : sc->sample_sizes[current_sample];
-                if (current_offset > INT64_MAX - sample_size) {
-                    av_log(mov->fc, AV_LOG_ERROR, "Current offset %"PRId64" or sample size %u is too large\n",
-                           current_offset,
-                           sample_size);
-                    return;
-                }
+        if (!sc->keyframe_absent && (!sc->keyframe_count || b->sample+b->key_off == sc->keyframes[b->stss_index])) {
+            keyframe = 1;
+            if (b->stss_index + 1 < sc->keyframe_count)
+                b->stss_index++;
+        } else if (sc->stps_count && b->sample+b->key_off == sc->stps_data[b->stps_index]) {
+            keyframe = 1;
+            if (b->stps_index + 1 < sc->stps_count)
+                b->stps_index++;
+        }
+        if (rap_group_present && b->rap_group_index < sc->rap_group_count) {
+            if (sc->rap_group[b->rap_group_index].index > 0)
+                keyframe = 1;
+            if (++b->rap_group_sample == sc->rap_group[b->rap_group_index].count) {
+                b->rap_group_sample = 0;
+                b->rap_group_index++;
+            }
+        }
+        if (sc->keyframe_absent
+            && !sc->stps_count
+            && !rap_group_present
+            && (st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO || (b->chunk==0 && b->chunk_sample==0)))
+             keyframe = 1;
+        if (keyframe)
+            b->distance = 0;
+        sample_size = sc->stsz_sample_size > 0 ? sc->stsz_sample_size : sc->sample_sizes[b->sample];
+        if (b->offset > INT64_MAX - sample_size) {
+            av_log(mov->fc, AV_LOG_ERROR, "Current offset %"PRId64" or sample size %u is too large\n",
+                   b->offset,
+                   sample_size);
+            b->done = 1;
+            return AVERROR_INVALIDDATA;
+        }
 
-                if (sc->pseudo_stream_id == -1 ||
-                   sc->stsc_data[stsc_index].id - 1 == sc->pseudo_stream_id) {
-                    AVIndexEntry *e;
-                    if (sample_size > 0x3FFFFFFF) {
-                        av_log(mov->fc, AV_LOG_ERROR, "Sample size %u is too large\n", sample_size);
-                        return;
-                    }
-                    e = &sti->index_entries[sti->nb_index_entries++];
-                    e->pos = current_offset;
-                    e->timestamp = current_dts;
-                    e->size = sample_size;
-                    e->min_distance = distance;
-                    e->flags = keyframe ? AVINDEX_KEYFRAME : 0;
-                    av_log(mov->fc, AV_LOG_TRACE, "AVIndex stream %d, sample %u, offset %"PRIx64", dts %"PRId64", "
-                            "size %u, distance %u, keyframe %d\n", st->index, current_sample,
-                            current_offset, current_dts, sample_size, distance, keyframe);
-                    if (st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO && sti->nb_index_entries < 100)
-                        ff_rfps_add_frame(mov->fc, st, current_dts);
+        if (sc->pseudo_stream_id == -1 ||
+           sc->stsc_data[b->stsc_index].id - 1 == sc->pseudo_stream_id) {
+            AVIndexEntry *e;
+            if (sample_size > 0x3FFFFFFF) {
+                av_log(mov->fc, AV_LOG_ERROR, "Sample size %u is too large\n", sample_size);
+                b->done = 1;
+                return AVERROR_INVALIDDATA;
+            }
+            // entries are allocated as they are needed for a deferred index
+            if (sti->nb_index_entries >= sti->index_entries_allocated_size / sizeof(*sti->index_entries)) {
+                unsigned int size = FFMIN(FFMAX(2U * sti->nb_index_entries, 1024), sc->sample_count);
+                if (av_reallocp_array(&sti->index_entries, size, sizeof(*sti->index_entries)) < 0) {
+                    sti->nb_index_entries = 0;
+                    sti->index_entries_allocated_size = 0;
+                    b->done = 1;
+                    return AVERROR(ENOMEM);
                 }
+                sti->index_entries_allocated_size = size * sizeof(*sti->index_entries);
+            }
+            e = &sti->index_entries[sti->nb_index_entries++];
+            e->pos = b->offset;
+            e->timestamp = b->dts;
+            e->size = sample_size;
+            e->min_distance = b->distance;
+            e->flags = keyframe ? AVINDEX_KEYFRAME : 0;
+            if (keyframe)
+                b->last_key_dts = b->dts;
+            av_log(mov->fc, AV_LOG_TRACE, "AVIndex stream %d, sample %u, offset %"PRIx64", dts %"PRId64", "
+                    "size %u, distance %u, keyframe %d\n", st->index, b->sample,
+                    b->offset, b->dts, sample_size, b->distance, keyframe);
+            if (st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO && sti->nb_index_entries < 100 &&
+                sti->info && !sc->index_pending)
+                ff_rfps_add_frame(mov->fc, st, b->dts);
+        }
 
-                current_offset += sample_size;
-                stream_size += sample_size;
+        b->offset += sample_size;
+        b->stream_size += sample_size;
 
-                current_dts += sc->stts_data[stts_index].duration;
+        b->dts += sc->stts_data[b->stts_index].duration;
 
-                distance++;
-                stts_sample++;
-                current_sample++;
-                if (stts_index + 1 < sc->stts_count && stts_sample == sc->stts_data[stts_index].count) {
-                    stts_sample = 0;
-                    stts_index++;
-                }
-            }
+        b->distance++;
+        b->stts_sample++;
+        b->sample++;
+        b->chunk_sample++;
+        if (b->stts_index + 1 < sc->stts_count && b->stts_sample == sc->stts_data[b->stts_index].count) {
+            b->stts_sample = 0;
+            b->stts_index++;
         }
-        if (st->duration > 0)
-            st->codecpar->bit_rate = stream_size*8*sc->time_scale/st->duration;
+    }
+
+    return 0;
+}
+
+static void mov_build_index(MOVContext *mov, AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+    FFStream *const sti = ffstream(st);
+    int64_t current_offset;
+    int64_t current_dts = 0;
+    unsigned int stsc_index = 0;
+    unsigned int i;
+
+    if (!sc->index_build.started) {
+        int ret = build_open_gop_key_points(st);
+        if (ret < 0)
+            return;
+
+        // already done while reading the header for a deferred index
+        if (sc->elst_count && !sc->index_pending)
+            mov_set_edit_list_offset(mov, st);
+    }
+
+    /* only use old uncompressed audio chunk demuxing when stts specifies it */
+    if (!(st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO &&
+          sc->stts_count == 1 && sc->stts_data[0].duration == 1)) {
+        if (!sc->index_build.started) {
+            if (!sc->sample_count || sti->nb_index_entries)
+                return;
+            if (mov_init_index_build(mov, st, sc->sample_count) < 0)
+                return;
+        }
+        if (mov_build_index_samples(mov, st, INT64_MAX, AV_NOPTS_VALUE) < 0)
+            return;
+        // a deferred index keeps the bit rate computed with the header
+        if (st->duration > 0 && !sc->index_pending)
+            st->codecpar->bit_rate = sc->index_build.stream_size*8*sc->time_scale/st->duration;
     } else {
         unsigned chunk_samples, total = 0;
 
         if (!sc->chunk_count)
             return;
 
+        if (!mov->advanced_editlist)
+            current_dts = -sc->time_offset;
+
         // compute total chunk count
         for (i = 0; i < sc->stsc_count; i++) {
             unsigned count, chunk_count;
@@ -4736,6 +4842,150 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
         }
     }
 
+    // done from the tables when the index was deferred
+    if (!sc->index_pending)
+        mov_estimate_video_delay(mov, st);
+}
+
+/**
+ * Check if mov_build_index() drops the samples of a track which use other
+ * sample descriptions than the one the stream was created from.
+ */
+static int mov_filters_samples(const MOVStreamContext *sc)
+{
+    if (sc->pseudo_stream_id == -1)
+        return 0;
+    for (unsigned int i = 0; i < sc->stsc_count; i++)
+        if (sc->stsc_data[i].id - 1 != sc->pseudo_stream_id)
+            return 1;
+    return 0;
+}
+
+/**
+ * Check if the index of a track with an edit list can be deferred by
+ * lazy_index, i.e. if the stream properties mov_fix_index() sets while the
+ * header is read can be derived from the edit list and the sample tables.
+ *
+ * Only the video delay estimated for H.264 depends on which samples the
+ * edit list keeps. It is only derived from the tables when a single edit
+ * starts in the first GOP and the index keeps all samples up to the last.
+ */
+static int mov_can_defer_edit_list(MOVContext *mov, AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+    int64_t edit_media_time = -1, edit_duration = 0;
+    int64_t media_time, duration, dts = 0;
+    unsigned int stts_index = 0, stts_sample = 0;
+    unsigned int ctts_index = 0, ctts_sample = 0;
+    unsigned int stss_index = 0, key_off, edit_index = 0;
+    int found_keyframe_after_edit = 0;
+
+    if (!sc->elst_count || !mov->advanced_editlist)
+        return 1;
+    if (st->codecpar->codec_type != AVMEDIA_TYPE_VIDEO || !sc->ctts_data ||
+        st->codecpar->codec_id != AV_CODEC_ID_H264 || st->codecpar->video_delay > 0)
+        return 1;
+
+    while (get_edit_list_entry(mov, sc, edit_index++, &media_time, &duration, mov->time_scale)) {
+        if (media_time == -1 && edit_media_time == -1)
+            continue;
+        if (edit_media_time != -1)
+            return 0;
+        edit_media_time = media_time;
+        edit_duration   = duration;
+    }
+    if (edit_media_time == -1 || sc->keyframe_absent || sc->stps_count || sc->rap_group_count)
+        return 0;
+
+    /* The edit starts from the first sample if it is a keyframe and the next
+     * keyframe comes after the start of the edit. */
+    key_off = sc->keyframe_count && sc->keyframes[0] > 0;
+    if (sc->keyframe_count) {
+        if (sc->keyframes[0] != key_off)
+            return 0;
+        stss_index = sc->keyframe_count > 1;
+    }
+
+    /* mov_fix_index() drops the samples after the second keyframe that ends
+     * after the edit, see there. */
+    for (unsigned int i = 0; i < sc->sample_count; i++) {
+        int keyframe = !sc->keyframe_count || i + key_off == sc->keyframes[stss_index];
+        int64_t frame_duration = i + 1 < sc->sample_count ? sc->stts_data[stts_index].duration : edit_duration;
+        int64_t cts = dts + (ctts_index < sc->ctts_count ? sc->ctts_data[ctts_index].duration : 0);
+
+        if (keyframe && i) {
+            if (dts <= edit_media_time)
+                return 0;
+            if (stss_index + 1 < sc->keyframe_count)
+                stss_index++;
+        }
+        if (keyframe && cts + frame_duration >= edit_duration + edit_media_time &&
+            found_keyframe_after_edit++ && i + 1 < sc->sample_count)
+            return 0;
+
+        dts += sc->stts_data[stts_index].duration;
+        if (stts_index + 1 < sc->stts_count && ++stts_sample == sc->stts_data[stts_index].count) {
+            stts_sample = 0;
+            stts_index++;
+        }
+        if (ctts_index < sc->ctts_count && ++ctts_sample == sc->ctts_data[ctts_index].count) {
+            ctts_sample = 0;
+            ctts_index++;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * Set the stream properties mov_build_index() derives from the samples of a
+ * track whose index is deferred by lazy_index, using its edit list and its
+ * sample tables.
+ */
+static void mov_init_pending_index(MOVContext *mov, AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+    FFStream *const sti = ffstream(st);
+    int64_t dts = (mov->advanced_editlist ? 0 : -sc->time_offset) - sc->dts_shift;
+    unsigned int stts_index = 0, stts_sample = 0;
+
+    if (!sc->sample_count)
+        return;
+
+    if (sc->elst_count && mov->advanced_editlist) {
+        int64_t media_time, duration, start_time = 0, end = 0;
+        int found_non_empty_edit = 0;
+
+        /* as in mov_fix_index() */
+        for (unsigned int i = 0; get_edit_list_entry(mov, sc, i, &media_time, &duration, mov->time_scale); i++) {
+            end += duration;
+            if (!found_non_empty_edit && media_time == -1)
+                start_time += duration;
+            else
+                found_non_empty_edit = 1;
+        }
+        st->start_time = start_time;
+        st->duration   = FFMIN(st->duration, end);
+    }
+
+    if (st->codecpar->codec_type != AVMEDIA_TYPE_VIDEO)
+        return;
+
+    if (st->start_time == AV_NOPTS_VALUE) {
+        st->start_time = dts + sc->dts_shift;
+        if (sc->ctts_data)
+            st->start_time += sc->ctts_data[0].duration;
+    }
+
+    for (unsigned int i = 0; sti->info && i < FFMIN(sc->sample_count, 99); i++) {
+        ff_rfps_add_frame(mov->fc, st, dts);
+        dts += sc->stts_data[stts_index].duration;
+        if (stts_index + 1 < sc->stts_count && ++stts_sample == sc->stts_data[stts_index].count) {
+            stts_sample = 0;
+            stts_index++;
+        }
+    }
+
     mov_estimate_video_delay(mov, st);
 }
 
@@ -4894,6 +5144,81 @@ static int mov_update_iamf_streams(MOVContext *c, const AVStream *st)
     return 0;
 }
 
+/* The tables mov_build_index() converts into the AVIndex */
+static void mov_free_sample_tables(MOVStreamContext *sc)
+{
+    av_freep(&sc->chunk_offsets);
+    av_freep(&sc->sample_sizes);
+    av_freep(&sc->keyframes);
+    av_freep(&sc->stts_data);
+    av_freep(&sc->stps_data);
+    av_freep(&sc->elst_data);
+    av_freep(&sc->rap_group);
+    av_freep(&sc->sync_group);
+    av_freep(&sc->sgpd_sync);
+}
+
+/**
+ * Free the sample tables of a track once its deferred index is complete.
+ */
+static void mov_finish_pending_index(MOVContext *mov, AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+
+    sc->index_pending = 0;
+    mov->nb_pending_indexes--;
+    mov_free_sample_tables(sc);
+}
+
+/**
+ * Build the index of a track whose sample tables were kept by lazy_index,
+ * finishing what mov_read_trak() and mov_read_header() do after building it.
+ */
+static void mov_build_pending_index(MOVContext *mov, AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+    int started;
+
+    if (!sc->index_pending)
+        return;
+
+    started = sc->index_build.started;
+    mov_build_index(mov, st);
+    mov_finish_pending_index(mov, st);
+    /* an index built as it is read starts without skipping */
+    if (!started &&
+        st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO &&
+        st->codecpar->codec_id   == AV_CODEC_ID_AAC)
+        ffstream(st)->skip_samples = sc->start_pad;
+}
+
+/**
+ * Add the entries of a deferred index up to the one of sample
+ * nb_entries - 1 and up to a keyframe after timestamp, see
+ * mov_build_index_samples(). Indexes which mov_fix_index() rewrites for the
+ * edit list are built entirely.
+ */
+static void mov_extend_pending_index(MOVContext *mov, AVStream *st,
+                                     int64_t nb_entries, int64_t timestamp)
+{
+    MOVStreamContext *sc = st->priv_data;
+
+    if (!sc->index_pending)
+        return;
+    if (!sc->index_build.incremental) {
+        mov_build_pending_index(mov, st);
+        return;
+    }
+
+    if (!sc->index_build.started &&
+        (build_open_gop_key_points(st) < 0 ||
+         mov_init_index_build(mov, st, FFMIN(sc->sample_count, 1024)) < 0))
+        sc->index_build.done = 1;
+    if (mov_build_index_samples(mov, st, nb_entries, timestamp) < 0 ||
+        sc->index_build.done)
+        mov_finish_pending_index(mov, st);
+}
+
 static int mov_read_trak(MOVContext *c, AVIOContext *pb, MOVAtom atom)
 {
     AVStream *st;
@@ -4955,7 +5280,30 @@ static int mov_read_trak(MOVContext *c, AVIOContext *pb, MOVAtom atom)
         c->advanced_editlist_autodisabled = 1;
     }
 
-    mov_build_index(c, st);
+    /* Defer building the index of audio and video tracks, except for
+     * uncompressed audio, which is indexed per chunk, and for tracks whose
+     * sample descriptions filter the samples of the index. Without an edit
+     * list for mov_fix_index() to apply, the index is built as the track
+     * is read or seeked in. */
+    if (c->lazy_index && sc->stts_count && !sc->iamf &&
+        !mov_filters_samples(sc) && mov_can_defer_edit_list(c, st) &&
+        (st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO ||
+         (st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO &&
+          !(sc->stts_count == 1 && sc->stts_data[0].duration == 1)))) {
+        uint64_t stream_size = sc->stsz_sample_size > 0 ?
+                               (uint64_t)sc->stsz_sample_size * sc->sample_count :
+                               sc->data_size;
+        sc->index_pending = 1;
+        sc->index_build.incremental = !sc->elst_count || !c->advanced_editlist;
+        c->nb_pending_indexes++;
+        if (st->duration > 0)
+            st->codecpar->bit_rate = stream_size*8*sc->time_scale/st->duration;
+        if (sc->elst_count)
+            mov_set_edit_list_offset(c, st);
+        mov_init_pending_index(c, st);
+    } else {
+        mov_build_index(c, st);
+    }
 
     if (sc->iamf) {
         ret = mov_update_iamf_streams(c, st);
@@ -5032,15 +5380,8 @@ static int mov_read_trak(MOVContext *c, AVIOContext *pb, MOVAtom atom)
             ffstream(st)->need_parsing = AVSTREAM_PARSE_FULL;
     }
     /* Do not need those anymore. */
-    av_freep(&sc->chunk_offsets);
-    av_freep(&sc->sample_sizes);
-    av_freep(&sc->keyframes);
-    av_freep(&sc->stts_data);
-    av_freep(&sc->stps_data);
-    av_freep(&sc->elst_data);
-    av_freep(&sc->rap_group);
-    av_freep(&sc->sync_group);
-    av_freep(&sc->sgpd_sync);
+    if (!sc->index_pending)
+        mov_free_sample_tables(sc);
 
     return 0;
 }
@@ -5502,6 +5843,61 @@ static int mov_read_tfdt(MOVContext *c, AVIOContext *pb, MOVAtom atom)
     return 0;
 }
 
+/**
+ * Get the end time of the track in the last fragment before the current one
+ * which has samples of it, where reading the fragments in order would
+ * continue. lazy_frag_index reads them in any order, so this is unknown if a
+ * fragment in between has not been read.
+ */
+static int64_t get_prev_frag_track_end(MOVContext *c, MOVStreamContext *sc)
+{
+    MOVFragmentIndex *frag_index = &c->frag_index;
+    int index = frag_index->current;
+
+    if (index < 0 || index >= frag_index->nb_items)
+        return AV_NOPTS_VALUE;
+    /* the first fragment is read with the header */
+    if (!index)
+        return sc->moov_track_end;
+    while (--index >= 0) {
+        MOVFragmentStreamInfo *info = get_frag_stream_info(frag_index, index, sc->id);
+
+        if (!frag_index->item[index].headers_read)
+            return AV_NOPTS_VALUE;
+        if (info && info->next_trun_dts != AV_NOPTS_VALUE)
+            return info->next_trun_dts;
+    }
+    return sc->moov_track_end;
+}
+
+/**
+ * Get the mfra time of the current fragment from another track, in the time
+ * scale of sc.
+ */
+static int64_t get_frag_tfra_time(MOVContext *c, MOVStreamContext *sc)
+{
+    MOVFragmentIndex *frag_index = &c->frag_index;
+    MOVFragmentIndexItem *item;
+
+    if (frag_index->current < 0 || frag_index->current >= frag_index->nb_items)
+        return AV_NOPTS_VALUE;
+    item = &frag_index->item[frag_index->current];
+
+    for (int i = 0; i < item->nb_stream_info; i++) {
+        const MOVFragmentStreamInfo *info = &item->stream_info[i];
+
+        if (info->first_tfra_pts == AV_NOPTS_VALUE)
+            continue;
+        for (int j = 0; j < c->fc->nb_streams; j++) {
+            MOVStreamContext *ref_sc = c->fc->streams[j]->priv_data;
+            if (ref_sc->id == info->id && ref_sc->time_scale > 0)
+                return av_rescale(info->first_tfra_pts, sc->time_scale,
+                                  ref_sc->time_scale);
+        }
+    }
+    return AV_NOPTS_VALUE;
+}
+
 static int mov_read_trun(MOVContext *c, AVIOContext *pb, MOVAtom atom)
 {
     MOVFragment *frag = &c->fragment;
@@ -5588,6 +5984,14 @@ static int mov_read_trun(MOVContext *c, AVIOContext *pb, MOVAtom atom)
             int has_sidx = frag_stream_info->sidx_pts != AV_NOPTS_VALUE;
             int fallback_tfdt = !c->use_tfdt && !has_sidx && has_tfdt;
             int fallback_sidx =  c->use_tfdt && !has_tfdt && has_sidx;
+            int64_t prev_track_end = AV_NOPTS_VALUE, other_tfra_time = AV_NOPTS_VALUE;
+
+            if (c->lazy_frag_index) {
+                prev_track_end = get_prev_frag_track_end(c, sc);
+                if (prev_track_end == AV_NOPTS_VALUE &&
+                    frag_stream_info->first_tfra_pts == AV_NOPTS_VALUE)
+                    other_tfra_time = get_frag_tfra_time(c, sc);
+            }
 
             if (fallback_sidx) {
                 av_log(c->fc, AV_LOG_DEBUG, "use_tfdt set but no tfdt found, using sidx instead\n");
@@ -5606,6 +6010,22 @@ static int mov_read_trun(MOVContext *c, AVIOContext *pb, MOVAtom atom)
                 dts = frag_stream_info->sidx_pts - sc->time_offset;
                 av_log(c->fc, AV_LOG_DEBUG, "found sidx time %"PRId64
                         ", using it for dts\n", frag_stream_info->sidx_pts);
+            } else if (prev_track_end != AV_NOPTS_VALUE) {
+                // where reading the fragments in order would have continued
+                dts = prev_track_end - sc->time_offset;
+                av_log(c->fc, AV_LOG_DEBUG, "found previous fragment end time %"PRId64
+                        ", using it for dts\n", dts);
+            } else if (frag_stream_info->first_tfra_pts != AV_NOPTS_VALUE &&
+                       c->lazy_frag_index) {
+                // fragments are not read in order, so track_end is unusable
+                dts = frag_stream_info->first_tfra_pts - sc->time_offset;
+                av_log(c->fc, AV_LOG_DEBUG, "found mfra time %"PRId64
+                        ", using it for dts\n", dts);
+            } else if (other_tfra_time != AV_NOPTS_VALUE) {
+                // the track is not in the mfra, take the time of another one
+                dts = other_tfra_time - sc->time_offset;
+                av_log(c->fc, AV_LOG_DEBUG, "found mfra time %"PRId64
+                        " of another track, using it for dts\n", dts);
             } else {
                 dts = sc->track_end - sc->time_offset;
                 av_log(c->fc, AV_LOG_DEBUG, "found track end time %"PRId64
@@ -8886,6 +9306,7 @@ static void mov_read_chapters(AVFormatContext *s)
             av_log(s, AV_LOG_ERROR, "Referenced QT chapter track not found\n");
             continue;
         }
+        mov_build_pending_index(mov, st);
         sti = ffstream(st);
 
         sc = st->priv_data;
@@ -9536,6 +9957,43 @@ static int mov_parse_tiles(AVFormatContext *s)
     return 0;
 }
 
+/**
+ * Read the last fragment of a file indexed by its mfra, for the durations
+ * which reading all the fragments would have given.
+ */
+static void mov_read_last_fragment(AVFormatContext *s)
+{
+    MOVContext *mov = s->priv_data;
+    MOVFragmentIndex *frag_index = &mov->frag_index;
+    MOVFragment fragment   = mov->fragment;
+    int64_t pos            = avio_tell(s->pb);
+    int64_t next_root_atom = mov->next_root_atom;
+    int found_mdat         = mov->found_mdat;
+    int current            = frag_index->current;
+    int ret;
+
+    for (int i = 0; i < s->nb_streams; i++) {
+        MOVStreamContext *sc = s->streams[i]->priv_data;
+        /* the sidx already gave the durations */
+        if (sc->has_sidx)
+            return;
+    }
+    if (frag_index->nb_items < 2 ||
+        frag_index->item[frag_index->nb_items - 1].headers_read)
+        return;
+
+    ret = mov_switch_root(s, -1, frag_index->nb_items - 1);
+    if (ret < 0 && ret != AVERROR_EOF)
+        av_log(s, AV_LOG_WARNING, "Could not read the last fragment: %s\n",
+               av_err2str(ret));
+
+    mov->fragment        = fragment;
+    mov->next_root_atom  = next_root_atom;
+    mov->found_mdat      = found_mdat;
+    frag_index->current  = current;
+    avio_seek(s->pb, pos, SEEK_SET);
+}
+
 static int mov_read_header(AVFormatContext *s)
 {
     MOVContext *mov = s->priv_data;
@@ -9692,10 +10150,23 @@ static int mov_read_header(AVFormatContext *s)
     }
 
     if (mov->trex_data) {
+        int unread_frags = 0;
+
+        /* fragments append to the index, so it must exist first */
+        for (i = 0; i < s->nb_streams && mov->nb_pending_indexes; i++)
+            mov_build_pending_index(mov, s->streams[i]);
+        if (mov->lazy_frag_index && mov->frag_index.complete &&
+            (pb->seekable & AVIO_SEEKABLE_NORMAL))
+            mov_read_last_fragment(s);
+        /* the samples of unread fragments are missing from data_size */
+        for (i = 0; i < mov->frag_index.nb_items && mov->lazy_frag_index; i++)
+            if (!mov->frag_index.item[i].headers_read &&
+                mov->frag_index.item[i].moof_offset > mov->fragment.moof_offset)
+                unread_frags = 1;
         for (i = 0; i < s->nb_streams; i++) {
             AVStream *st = s->streams[i];
             MOVStreamContext *sc = st->priv_data;
-            if (st->duration > 0) {
+            if (st->duration > 0 && !unread_frags) {
                 /* Akin to sc->data_size * 8 * sc->time_scale / st->duration but accounting for overflows. */
                 st->codecpar->bit_rate = av_rescale(sc->data_size, ((int64_t) sc->time_scale) * 8, st->duration);
                 if (st->codecpar->bit_rate == INT64_MIN) {
@@ -9836,6 +10307,60 @@ static AVIndexEntry *mov_find_next_sample(AVFormatContext *s, AVStream **st)
     return sample;
 }
 
+/**
+ * Extend the pending indexes of the streams which are not discarded and of
+ * force, if not NULL, past the sample each stream reads next. Streams which
+ * were already being read continue from the sample they were at, the others
+ * are seeked to it.
+ */
+static void mov_build_pending_indexes(AVFormatContext *s, AVStream *force)
+{
+    MOVContext *mov = s->priv_data;
+    int64_t resume_ts = AV_NOPTS_VALUE;
+    AVRational resume_tb;
+    int start = 0;
+
+    for (int i = 0; i < s->nb_streams; i++) {
+        AVStream *st = s->streams[i];
+        MOVStreamContext *sc = st->priv_data;
+
+        if (!sc->index_pending)
+            continue;
+        if (sc->index_build.started)
+            mov_extend_pending_index(mov, st, sc->current_sample + 2, AV_NOPTS_VALUE);
+        else if (st == force || st->discard != AVDISCARD_ALL)
+            start = 1;
+    }
+    if (!start) {
+        mov->lazy_index_started = 1;
+        return;
+    }
+
+    if (mov->lazy_index_started) {
+        AVStream *st = NULL;
+        AVIndexEntry *sample = mov_find_next_sample(s, &st);
+        if (sample) {
+            resume_ts = sample->timestamp;
+            resume_tb = st->time_base;
+        }
+    }
+
+    for (int i = 0; i < s->nb_streams; i++) {
+        AVStream *st = s->streams[i];
+        MOVStreamContext *sc = st->priv_data;
+
+        if (!sc->index_pending || sc->index_build.started ||
+            (st != force && st->discard == AVDISCARD_ALL))
+            continue;
+        mov_extend_pending_index(mov, st, 2, AV_NOPTS_VALUE);
+        if (resume_ts != AV_NOPTS_VALUE) {
+            mov_seek_stream(s, st, av_rescale_q(resume_ts, resume_tb, st->time_base), 0);
+            mov_extend_pending_index(mov, st, sc->current_sample + 2, AV_NOPTS_VALUE);
+        }
+    }
+    mov->lazy_index_started = 1;
+}
+
 static int should_retry(AVIOContext *pb, int error_code) {
     if (error_code == AVERROR_EOF || avio_feof(pb))
         return 0;
@@ -9992,6 +10517,8 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
     int ret;
     mov->fc = s;
  retry:
+    if (mov->nb_pending_indexes)
+        mov_build_pending_indexes(s, NULL);
     sample = mov_find_next_sample(s, &st);
     if (!sample || (mov->next_root_atom && sample->pos > mov->next_root_atom)) {
         if (!mov->next_root_atom)
@@ -10109,7 +10636,9 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
 static int mov_seek_fragment(AVFormatContext *s, AVStream *st, int64_t timestamp)
 {
     MOVContext *mov = s->priv_data;
-    int index;
+    MOVStreamContext *sc = st->priv_data;
+    MOVFragmentStreamInfo *frag_stream_info;
+    int index, ret;
 
     if (!mov->frag_index.complete)
         return 0;
@@ -10117,10 +10646,60 @@ static int mov_seek_fragment(AVFormatContext *s, AVStream *st, int64_t timestamp
     index = search_frag_timestamp(s, &mov->frag_index, st, timestamp);
     if (index < 0)
         index = 0;
-    if (!mov->frag_index.item[index].headers_read)
-        return mov_switch_root(s, -1, index);
-    if (index + 1 < mov->frag_index.nb_items)
+    if (mov->lazy_frag_index) {
+        /* Without a sidx, the fragment is found from the times of any
+         * track, so take the last one before it listing this track. */
+        for (int i = index; i >= 0; i--) {
+            frag_stream_info = get_frag_stream_info(&mov->frag_index, i, sc->id);
+            if (frag_stream_info &&
+                get_stream_info_time(frag_stream_info) != AV_NOPTS_VALUE) {
+                index = i;
+                break;
+            }
+        }
+    }
+    if (!mov->frag_index.item[index].headers_read) {
+        ret = mov_switch_root(s, -1, index);
+        if (ret < 0 || !mov->lazy_frag_index)
+            return ret;
+    } else if (index + 1 < mov->frag_index.nb_items) {
         mov->next_root_atom = mov->frag_index.item[index + 1].moof_offset;
+    }
+
+    if (!mov->lazy_frag_index)
+        return 0;
+
+    /* The fragment was found from the times of another track, so the
+     * samples of this one up to timestamp may be in the previous fragment,
+     * which lazy_frag_index has not necessarily read. */
+    if (index > 0 && !mov->frag_index.item[index - 1].headers_read) {
+        frag_stream_info = get_frag_stream_info(&mov->frag_index, index, sc->id);
+        if (frag_stream_info && frag_stream_info->index_entry >= 0 &&
+            frag_stream_info->index_entry < ffstream(st)->nb_index_entries &&
+            ffstream(st)->index_entries[frag_stream_info->index_entry].timestamp > timestamp) {
+            ret = mov_switch_root(s, -1, index - 1);
+            if (ret < 0)
+                return ret;
+        }
+    }
+
+    /* A forward seek can end in the next fragment of this track, so read it
+     * too, but keep reading in order from the one after index. */
+    for (int i = index + 1; i < mov->frag_index.nb_items; i++) {
+        int64_t next_root_atom = mov->next_root_atom;
+
+        frag_stream_info = get_frag_stream_info(&mov->frag_index, i, sc->id);
+        if (!frag_stream_info ||
+            get_stream_info_time(frag_stream_info) == AV_NOPTS_VALUE)
+            continue;
+        if (!mov->frag_index.item[i].headers_read) {
+            ret = mov_switch_root(s, -1, i);
+            mov->next_root_atom = next_root_atom;
+            if (ret < 0 && ret != AVERROR_EOF)
+                return ret;
+        }
+        break;
+    }
 
     return 0;
 }
@@ -10183,6 +10762,10 @@ static int mov_seek_stream(AVFormatContext *s, AVStream *st, int64_t timestamp,
     if (ret < 0)
         return ret;
 
+    // a deferred index is extended only once the stream was read or seeked
+    if (sc->index_pending && sc->index_build.started)
+        mov_extend_pending_index(s->priv_data, st, 0, timestamp);
+
     for (;;) {
         sample = av_index_search_timestamp(st, timestamp, flags);
         av_log(s, AV_LOG_TRACE, "stream %d, timestamp %"PRId64", sample %d\n", st->index, timestamp, sample);
@@ -10247,6 +10830,45 @@ static int64_t mov_get_skip_samples(AVStream *st, int sample)
     return FFMAX(sc->start_pad - off, 0);
 }
 
+/**
+ * Read the fragments that seeking all the streams to sample_time needs with
+ * lazy_frag_index. A fragment read for one stream can insert samples before
+ * the sample found for another one, so they must all be read before the
+ * samples are looked for.
+ */
+static int mov_seek_read_fragments(AVFormatContext *s, AVStream *st, int64_t sample_time, int flags)
+{
+    MOVContext *mc = s->priv_data;
+    MOVStreamContext *sc = st->priv_data;
+    FFStream *const sti = ffstream(st);
+    int64_t timestamp = sample_time - (sc->min_corrected_pts + sc->dts_shift);
+    int64_t seek_timestamp;
+    int sample, ret;
+
+    ret = mov_seek_fragment(s, st, timestamp);
+    if (ret < 0 || !mc->seek_individually)
+        return ret;
+
+    sample = av_index_search_timestamp(st, timestamp, flags);
+    if (sample < 0)
+        return 0;
+    seek_timestamp = sti->index_entries[sample].timestamp;
+
+    for (int i = 0; i < s->nb_streams; i++) {
+        AVStream *const st2 = s->streams[i];
+        MOVStreamContext *sc2 = st2->priv_data;
+
+        if (st2 == st)
+            continue;
+
+        timestamp = av_rescale_q(seek_timestamp, st->time_base, st2->time_base);
+        ret = mov_seek_fragment(s, st2, timestamp - (sc2->min_corrected_pts + sc2->dts_shift));
+        if (ret < 0)
+            return ret;
+    }
+    return 0;
+}
+
 static int mov_read_seek(AVFormatContext *s, int stream_index, int64_t sample_time, int flags)
 {
     MOVContext *mc = s->priv_data;
@@ -10260,6 +10882,13 @@ static int mov_read_seek(AVFormatContext *s, int stream_index, int64_t sample_ti
 
     st = s->streams[stream_index];
     sti = ffstream(st);
+    if (mc->nb_pending_indexes)
+        mov_build_pending_indexes(s, st);
+    if (mc->lazy_frag_index && mc->frag_index.complete) {
+        int ret = mov_seek_read_fragments(s, st, sample_time, flags);
+        if (ret < 0)
+            return ret;
+    }
     sample = mov_seek_stream(s, st, sample_time, flags);
     if (sample < 0)
         return sample;
@@ -10291,7 +10920,10 @@ static int mov_read_seek(AVFormatContext *s, int stream_index, int64_t sample_ti
         }
         while (1) {
             MOVStreamContext *sc;
-            AVIndexEntry *entry = mov_find_next_sample(s, &st);
+            AVIndexEntry *entry;
+            if (mc->nb_pending_indexes)
+                mov_build_pending_indexes(s, NULL);
+            entry = mov_find_next_sample(s, &st);
             if (!entry)
                 return AVERROR_INVALIDDATA;
             sc = st->priv_data;
@@ -10335,6 +10967,8 @@ static const AVOption mov_options[] = {
         FLAGS, .unit = "use_mfra_for" },
     {"use_tfdt", "use tfdt for fragment timestamps", OFFSET(use_tfdt), AV_OPT_TYPE_BOOL, {.i64 = 1},
         0, 1, FLAGS},
+    {"lazy_frag_index", "Index fragments only from sidx and mfra and read them when reached",
+        OFFSET(lazy_frag_index), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, FLAGS},
     { "export_all", "Export unrecognized metadata entries", OFFSET(export_all),
         AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, .flags = FLAGS },
     { "export_xmp", "Export full XMP metadata", OFFSET(export_xmp),
@@ -10354,6 +10988,8 @@ static const AVOption mov_options[] = {
         {.i64 = 0}, 0, 1, FLAGS },
     { "max_stts_delta", "treat offsets above this value as invalid", OFFSET(max_stts_delta), AV_OPT_TYPE_INT, {.i64 = UINT_MAX-48000*10 }, 0, UINT_MAX, .flags = AV_OPT_FLAG_DECODING_PARAM },
     { "interleaved_read", "Interleave packets from multiple tracks at demuxer level", OFFSET(interleaved_read), AV_OPT_TYPE_BOOL, {.i64 = 1 }, 0, 1, .flags = AV_OPT_FLAG_DECODING_PARAM },
+    { "lazy_index", "Build the index of audio and video tracks when they are first read or seeked",
+        OFFSET(lazy_index), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, FLAGS },
 
     { NULL },
 };
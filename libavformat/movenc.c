@@ -101,6 +101,7 @@ static const AVOption options[] = {
       { "global_sidx", "Write a global sidx index at the start of the file", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_GLOBAL_SIDX}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, .unit = "movflags" },
       { "isml", "Create a live smooth streaming feed (for pushing to a publishing point)", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_ISML}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, .unit = "movflags" },
       { "moov_size", "maximum moov size so it can be placed at the begin", offsetof(MOVMuxContext, reserved_moov_size), AV_OPT_TYPE_INT, {.i64 = 0}, 0, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, .unit = 0 },
+      { "faststart_reserve", "Reserve space for the moov atom from the stream durations so faststart can write it in place", offsetof(MOVMuxContext, faststart_reserve), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, AV_OPT_FLAG_ENCODING_PARAM},
       { "negative_cts_offsets", "Use negative CTS offsets (reducing the need for edit lists)", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_NEGATIVE_CTS_OFFSETS}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, .unit = "movflags" },
       { "omit_tfhd_offset", "Omit the base data offset in tfhd atoms", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_OMIT_TFHD_OFFSET}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, .unit = "movflags" },
       { "prefer_icc", "If writing colr atom prioritise usage of ICC profile if it exists in stream packet side data", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_PREFER_ICC}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, .unit = "movflags" },
@@ -7212,6 +7213,51 @@ static int mov_init_iamf_track(AVFormatContext *s)
     return 0;
 }
 
+/* Upper bounds of the bytes a sample adds to the moov atom: stsz and co64
+ * entries, plus stts, ctts, stss and sdtp entries for video. */
+#define MOV_RESERVE_SAMPLE_SIZE       12
+#define MOV_RESERVE_VIDEO_SAMPLE_SIZE 33
+/* Size of the trak atom of a track without its sample tables and extradata */
+#define MOV_RESERVE_TRACK_SIZE        1024
+#define MOV_RESERVE_CHAPTER_SIZE      64
+/* Smallest amount the mdat is moved by when the reserved space is too small */
+#define MOV_RESERVE_MIN_SHIFT         (1 << 20)
+
+/*
+ * Estimate the size of the sample tables of a stream from its duration
+ * hint, which must be in the time base set by the caller. Returns a
+ * negative value if it cannot be estimated.
+ */
+static int64_t estimate_sample_tables_size(const AVStream *st)
+{
+    const AVCodecParameters *par = st->codecpar;
+    double duration, nb_samples;
+
+    if (st->duration <= 0 || st->time_base.num <= 0 || st->time_base.den <= 0)
+        return -1;
+    duration = st->duration * av_q2d(st->time_base);
+
+    switch (par->codec_type) {
+    case AVMEDIA_TYPE_VIDEO:
+        if (st->avg_frame_rate.num > 0 && st->avg_frame_rate.den > 0)
+            nb_samples = duration * av_q2d(st->avg_frame_rate);
+        else if (st->r_frame_rate.num > 0 && st->r_frame_rate.den > 0)
+            nb_samples = duration * av_q2d(st->r_frame_rate);
+        else
+            return -1;
+        return llrint(nb_samples) * MOV_RESERVE_VIDEO_SAMPLE_SIZE;
+    case AVMEDIA_TYPE_AUDIO:
+        if (par->sample_rate <= 0)
+            return -1;
+        nb_samples = duration * par->sample_rate /
+                     (par->frame_size > 0 ? par->frame_size : 1024);
+        return llrint(nb_samples) * MOV_RESERVE_SAMPLE_SIZE;
+    default:
+        /* subtitles and data: assume at most one sample per second */
+        return llrint(duration + 1) * MOV_RESERVE_SAMPLE_SIZE;
+    }
+}
+
 static int mov_init(AVFormatContext *s)
 {
     MOVMuxContext *mov = s->priv_data;
@@ -7270,7 +7316,12 @@ static int mov_init(AVFormatContext *s)
         mov->flags &= ~FF_MOV_FLAG_SKIP_SIDX;
     }
 
-    if (mov->flags & FF_MOV_FLAG_FASTSTART) {
+    if (!(mov->flags & FF_MOV_FLAG_FASTSTART) ||
+        mov->flags & (FF_MOV_FLAG_FRAGMENT | FF_MOV_FLAG_RTP_HINT))
+        mov->faststart_reserve = 0;
+    /* With faststart_reserve, an explicit moov_size replaces the estimate. */
+    if (mov->flags & FF_MOV_FLAG_FASTSTART &&
+        !(mov->faststart_reserve && mov->reserved_moov_size > 0)) {
         mov->reserved_moov_size = -1;
     }
 
@@ -7652,6 +7703,12 @@ static int mov_init(AVFormatContext *s)
              track->timescale = 10000000;
         }
 
+        if (mov->faststart_reserve && mov->sample_tables_estimate >= 0) {
+            int64_t size = estimate_sample_tables_size(st);
+            mov->sample_tables_estimate = size < 0 ? -1 :
+                                          mov->sample_tables_estimate + size;
+        }
+
         avpriv_set_pts_info(st, 64, 1, track->timescale);
 
         if (mov->encryption_scheme == MOV_ENC_CENC_AES_CTR) {
@@ -7668,6 +7725,47 @@ static int mov_init(AVFormatContext *s)
     return 0;
 }
 
+/*
+ * Reserve space for the moov atom after the ftyp atom, so that faststart
+ * does not need to move the whole mdat when finishing the file.
+ */
+static int reserve_moov(AVFormatContext *s)
+{
+    MOVMuxContext *mov = s->priv_data;
+    int64_t size;
+    int ret;
+
+    if (mov->sample_tables_estimate < 0) {
+        av_log(s, AV_LOG_WARNING, "Unknown stream duration or rate, "
+               "not reserving space for the moov atom\n");
+        return 0;
+    }
+
+    /* The tracks do not have any sample yet, so this only accounts for the
+     * movie header and the metadata. */
+    ret = get_moov_size(s);
+    if (ret < 0)
+        return ret;
+    size = ret + mov->sample_tables_estimate +
+           s->nb_chapters * MOV_RESERVE_CHAPTER_SIZE;
+    for (int i = 0; i < mov->nb_tracks; i++) {
+        size += MOV_RESERVE_TRACK_SIZE;
+        if (i < mov->nb_streams)
+            size += mov->tracks[i].par->extradata_size;
+    }
+    size += size / 16;
+    if (size > INT_MAX) {
+        av_log(s, AV_LOG_WARNING, "Estimated moov size %"PRId64" too large, "
+               "not reserving space for it\n", size);
+        return 0;
+    }
+
+    av_log(s, AV_LOG_VERBOSE, "Reserving %"PRId64" bytes for the moov atom\n", size);
+    mov->reserved_moov_size = size;
+    avio_skip(s->pb, size);
+    return 0;
+}
+
 static int mov_write_header(AVFormatContext *s)
 {
     AVIOContext *pb = s->pb;
@@ -7762,8 +7860,11 @@ static int mov_write_header(AVFormatContext *s)
             !mov->max_fragment_duration && !mov->max_fragment_size)
             mov->flags |= FF_MOV_FLAG_FRAG_KEYFRAME;
     } else if (mov->mode != MODE_AVIF) {
-        if (mov->flags & FF_MOV_FLAG_FASTSTART)
+        if (mov->flags & FF_MOV_FLAG_FASTSTART && mov->reserved_moov_size < 0) {
             mov->reserved_header_pos = avio_tell(pb);
+            if (mov->faststart_reserve && (ret = reserve_moov(s)) < 0)
+                return ret;
+        }
         mov_write_mdat_tag(pb, mov);
     }
 
@@ -7911,6 +8012,61 @@ static int shift_data(AVFormatContext *s)
     return ff_format_shift_data(s, mov->reserved_header_pos, moov_size);
 }
 
+/*
+ * Write the moov atom into the space reserved for it. If the reservation
+ * was too small, the mdat is moved to make room for it.
+ */
+static int write_reserved_moov(AVFormatContext *s, int64_t moov_pos)
+{
+    MOVMuxContext *mov = s->priv_data;
+    AVIOContext *pb = s->pb;
+    int reserved = mov->reserved_moov_size;
+    int moov_size, shift = 0, ret;
+    int64_t size;
+
+    /* Moving the mdat can switch the chunk offset tables from stco to co64
+     * and grow the moov again, so iterate until it fits. */
+    for (;;) {
+        int space, new_shift;
+
+        moov_size = get_moov_size(s);
+        if (moov_size < 0)
+            return moov_size;
+        space = reserved + shift;
+        if (moov_size == space || moov_size + 8 <= space)
+            break;
+        /* The data is moved in chunks of the shift size, so a shift of a few
+         * bytes would take as many I/Os as the mdat has chunks. Make room for
+         * at least 1 MiB and let the free atom absorb the excess. */
+        new_shift = FFMAX(moov_size + 8 - reserved, MOV_RESERVE_MIN_SHIFT);
+        for (int i = 0; i < mov->nb_tracks; i++)
+            mov->tracks[i].data_offset += new_shift - shift;
+        shift = new_shift;
+    }
+
+    if (shift) {
+        av_log(s, AV_LOG_WARNING, "Reserved moov space too small by %d bytes, "
+               "moving the mdat\n", shift);
+        avio_seek(pb, moov_pos, SEEK_SET);
+        ret = ff_format_shift_data(s, mov->reserved_header_pos + reserved, shift);
+        if (ret < 0)
+            return ret;
+        moov_pos += shift;
+    }
+
+    avio_seek(pb, mov->reserved_header_pos, SEEK_SET);
+    if ((ret = mov_write_moov_tag(pb, mov, s)) < 0)
+        return ret;
+    size = reserved + shift - (avio_tell(pb) - mov->reserved_header_pos);
+    if (size >= 8) {
+        avio_wb32(pb, size);
+        ffio_wfourcc(pb, "free");
+        ffio_fill(pb, 0, size - 8);
+    }
+    avio_seek(pb, moov_pos, SEEK_SET);
+    return 0;
+}
+
 static int mov_write_trailer(AVFormatContext *s)
 {
     MOVMuxContext *mov = s->priv_data;
@@ -7982,7 +8138,10 @@ static int mov_write_trailer(AVFormatContext *s)
         }
         avio_seek(pb, mov->reserved_moov_size > 0 ? mov->reserved_header_pos : moov_pos, SEEK_SET);
 
-        if (mov->flags & FF_MOV_FLAG_FASTSTART) {
+        if (mov->flags & FF_MOV_FLAG_FASTSTART && mov->reserved_moov_size > 0) {
+            if ((res = write_reserved_moov(s, moov_pos)) < 0)
+                return res;
+        } else if (mov->flags & FF_MOV_FLAG_FASTSTART) {
             av_log(s, AV_LOG_INFO, "Starting second pass: moving the moov atom to the beginning of the file\n");
             res = shift_data(s);
             if (res < 0)
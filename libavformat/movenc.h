@@ -221,6 +221,8 @@ typedef struct MOVMuxContext {
 
     int reserved_moov_size; ///< 0 for disabled, -1 for automatic, size otherwise
     int64_t reserved_header_pos;
+    int faststart_reserve;
+    int64_t sample_tables_estimate; ///< estimated size of all sample tables, negative if unknown
 
     char *major_brand;
 
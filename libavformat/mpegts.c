@@ -179,6 +179,9 @@ struct MpegTSContext {
     int8_t crc_validity[NB_PID_MAX];
     /** filters for various streams specified by PMT + for the PAT and PMT */
     MpegTSFilter *pids[NB_PID_MAX];
+    /** bitmap of the pids which have a filter, to skip the other packets
+     *  without loading their pids[] entries */
+    uint64_t pid_has_filter[NB_PID_MAX / 64];
     int current_pid;
 
     AVStream *epg_stream;
@@ -502,6 +505,7 @@ static MpegTSFilter *mpegts_open_filter(MpegTSContext *ts, unsigned int pid,
     if (!filter)
         return NULL;
     ts->pids[pid] = filter;
+    ts->pid_has_filter[pid >> 6] |= 1ULL << (pid & 63);
 
     filter->type    = type;
     filter->pid     = pid;
@@ -579,6 +583,7 @@ static void mpegts_close_filter(MpegTSContext *ts, MpegTSFilter *filter)
 
     av_free(filter);
     ts->pids[pid] = NULL;
+    ts->pid_has_filter[pid >> 6] &= ~(1ULL << (pid & 63));
 }
 
 static int analyze(const uint8_t *buf, int size, int packet_size,
@@ -2973,13 +2978,49 @@ static void finished_reading_packet(AVFormatContext *s, int raw_packet_size)
         avio_skip(pb, skip);
 }
 
+/**
+ * Skip the packets already in the I/O buffer which handle_packet() would
+ * ignore, i.e. those of pids without filter or of discarded pids, in one
+ * go. Only the 4 byte headers are read.
+ *
+ * @return the number of packets skipped, at most max_packets
+ */
+static int skip_ignored_packets(MpegTSContext *ts, int64_t max_packets)
+{
+    AVIOContext *pb = ts->stream->pb;
+    const int packet_size = ts->raw_packet_size;
+    const uint8_t *p = pb->buf_ptr;
+    int64_t nb_packets = (pb->buf_end - p) / packet_size;
+    int i;
+
+    nb_packets = FFMIN(nb_packets, max_packets);
+    for (i = 0; i < nb_packets; i++, p += packet_size) {
+        uint32_t header = AV_RB32(p);
+        int pid         = (header >> 8) & 0x1fff;
+        int is_start    = header & 0x400000;
+
+        if (header >> 24 != 0x47)
+            break;
+        if (ts->pid_has_filter[pid >> 6] & (1ULL << (pid & 63))) {
+            /* the discard state is only updated on unit starts */
+            if (is_start || !ts->pids[pid]->discard)
+                break;
+        } else if (ts->auto_guess && is_start) {
+            break;
+        }
+    }
+    if (i)
+        avio_skip(pb, (int64_t)i * packet_size);
+    return i;
+}
+
 static int handle_packets(MpegTSContext *ts, int64_t nb_packets)
 {
     AVFormatContext *s = ts->stream;
     uint8_t packet[TS_PACKET_SIZE + AV_INPUT_BUFFER_PADDING_SIZE];
     const uint8_t *data;
     int64_t packet_num;
-    int ret = 0;
+    int skipped, ret = 0;
 
     if (avio_tell(s->pb) != ts->last_pos) {
         int i;
@@ -3014,6 +3055,12 @@ static int handle_packets(MpegTSContext *ts, int64_t nb_packets)
         if (ts->stop_parse > 0)
             break;
 
+        skipped = skip_ignored_packets(ts, nb_packets ? nb_packets - packet_num : INT64_MAX);
+        if (skipped > 0) {
+            packet_num += skipped - 1;
+            continue;
+        }
+
         ret = read_packet(s, packet, ts->raw_packet_size, &data);
         if (ret != 0)
             break;
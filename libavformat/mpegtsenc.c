@@ -130,8 +130,17 @@ typedef struct MpegTSWrite {
     uint8_t provider_name[256];
 
     int omit_video_pes_length;
+
+    /* TS packets are built in this buffer and handed to the AVIOContext
+     * in one write per muxed packet */
+    uint8_t *out_buf;
+    int out_size;
 } MpegTSWrite;
 
+/* number of TS packets buffered before they are written out */
+#define OUT_BUF_PACKETS 128
+#define OUT_BUF_SIZE    (OUT_BUF_PACKETS * (TS_PACKET_SIZE + 4))
+
 /* a PES packet header is generated every DEFAULT_PES_HEADER_FREQ packets */
 #define DEFAULT_PES_HEADER_FREQ  16
 #define DEFAULT_PES_PAYLOAD_SIZE ((DEFAULT_PES_HEADER_FREQ - 1) * 184 + 170)
@@ -965,20 +974,43 @@ static int64_t get_pcr(const MpegTSWrite *ts)
            ts->first_pcr;
 }
 
-static void write_packet(AVFormatContext *s, const uint8_t *packet)
+static void flush_packets(AVFormatContext *s)
+{
+    MpegTSWrite *ts = s->priv_data;
+    if (ts->out_size) {
+        avio_write(s->pb, ts->out_buf, ts->out_size);
+        ts->out_size = 0;
+    }
+}
+
+/* Return the location of the next TS packet in the output buffer. Nothing
+ * may be written before it is committed with commit_packet(). */
+static uint8_t *get_packet_buf(AVFormatContext *s)
+{
+    MpegTSWrite *ts = s->priv_data;
+    if (ts->out_size > OUT_BUF_SIZE - TS_PACKET_SIZE - 4)
+        flush_packets(s);
+    return ts->out_buf + ts->out_size + (ts->m2ts_mode ? 4 : 0);
+}
+
+static void commit_packet(AVFormatContext *s)
 {
     MpegTSWrite *ts = s->priv_data;
     if (ts->m2ts_mode) {
         int64_t pcr = get_pcr(s->priv_data);
-        uint32_t tp_extra_header = pcr % 0x3fffffff;
-        tp_extra_header = AV_RB32(&tp_extra_header);
-        avio_write(s->pb, (unsigned char *) &tp_extra_header,
-                   sizeof(tp_extra_header));
+        AV_WB32(ts->out_buf + ts->out_size, pcr % 0x3fffffff);
+        ts->out_size += 4;
     }
-    avio_write(s->pb, packet, TS_PACKET_SIZE);
+    ts->out_size   += TS_PACKET_SIZE;
     ts->total_size += TS_PACKET_SIZE;
 }
 
+static void write_packet(AVFormatContext *s, const uint8_t *packet)
+{
+    memcpy(get_packet_buf(s), packet, TS_PACKET_SIZE);
+    commit_packet(s);
+}
+
 static void section_write_packet(MpegTSSection *s, const uint8_t *packet)
 {
     AVFormatContext *ctx = s->opaque;
@@ -1159,6 +1191,10 @@ static int mpegts_init(AVFormatContext *s)
 
     ts->pkt = ffformatcontext(s)->pkt;
 
+    ts->out_buf = av_malloc(OUT_BUF_SIZE);
+    if (!ts->out_buf)
+        return AVERROR(ENOMEM);
+
     /* assign pids to each stream */
     for (i = 0; i < s->nb_streams; i++) {
         AVStream *st = s->streams[i];
@@ -1484,8 +1520,7 @@ static void mpegts_write_pes(AVFormatContext *s, AVStream *st,
 {
     MpegTSWriteStream *ts_st = st->priv_data;
     MpegTSWrite *ts = s->priv_data;
-    uint8_t buf[TS_PACKET_SIZE];
-    uint8_t *q;
+    uint8_t *buf, *q;
     int val, is_start, len, header_len, write_pcr, flags;
     int afc_len, stuffing_len;
     int is_dvb_subtitle = (st->codecpar->codec_id == AV_CODEC_ID_DVB_SUBTITLE);
@@ -1495,7 +1530,6 @@ static void mpegts_write_pes(AVFormatContext *s, AVStream *st,
     int force_sdt = 0;
     int force_nit = 0;
 
-    av_assert0(ts_st->payload != buf || st->codecpar->codec_type != AVMEDIA_TYPE_VIDEO);
     if (ts->flags & MPEGTS_FLAG_PAT_PMT_AT_FRAMES && st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
         force_pat = 1;
     }
@@ -1563,7 +1597,8 @@ static void mpegts_write_pes(AVFormatContext *s, AVStream *st,
             }
         }
 
-        /* prepare packet header */
+        /* prepare packet header, in place in the output buffer */
+        buf  = get_packet_buf(s);
         q    = buf;
         *q++ = 0x47;
         val  = ts_st->pid >> 8;
@@ -1759,7 +1794,7 @@ static void mpegts_write_pes(AVFormatContext *s, AVStream *st,
 
         payload      += len;
         payload_size -= len;
-        write_packet(s, buf);
+        commit_packet(s);
     }
     ts_st->prev_payload_key = key;
 }
@@ -2249,7 +2284,9 @@ static void mpegts_write_flush(AVFormatContext *s)
     }
 
     if (ts->m2ts_mode) {
-        int packets = (avio_tell(s->pb) / (TS_PACKET_SIZE + 4)) % 32;
+        int packets;
+        flush_packets(s);
+        packets = (avio_tell(s->pb) / (TS_PACKET_SIZE + 4)) % 32;
         while (packets++ < 32)
             mpegts_insert_null_packet(s);
     }
@@ -2257,18 +2294,24 @@ static void mpegts_write_flush(AVFormatContext *s)
 
 static int mpegts_write_packet(AVFormatContext *s, AVPacket *pkt)
 {
+    int ret;
+
     if (!pkt) {
         mpegts_write_flush(s);
-        return 1;
+        ret = 1;
     } else {
-        return mpegts_write_packet_internal(s, pkt);
+        ret = mpegts_write_packet_internal(s, pkt);
     }
+    flush_packets(s);
+    return ret;
 }
 
 static int mpegts_write_end(AVFormatContext *s)
 {
-    if (s->pb)
+    if (s->pb) {
         mpegts_write_flush(s);
+        flush_packets(s);
+    }
 
     return 0;
 }
@@ -2297,6 +2340,7 @@ static void mpegts_deinit(AVFormatContext *s)
         av_freep(&service);
     }
     av_freep(&ts->services);
+    av_freep(&ts->out_buf);
 }
 
 static int mpegts_check_bitstream(AVFormatContext *s, AVStream *st,
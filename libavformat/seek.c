@@ -49,14 +49,34 @@ void ff_reduce_index(AVFormatContext *s, int stream_index)
 {
     AVStream *const st  = s->streams[stream_index];
     FFStream *const sti = ffstream(st);
+    AVIndexEntry *const entries = sti->index_entries;
     unsigned int max_entries = s->max_index_size / sizeof(AVIndexEntry);
+    int n = sti->nb_index_entries;
 
-    if ((unsigned) sti->nb_index_entries >= max_entries) {
+    if ((unsigned) n < max_entries)
+        return;
+
+    /* Keep entries at least span / (max_entries / 2) apart instead of
+     * every other one: otherwise each reduction halves the part indexed
+     * before again, and the start of long inputs ends up barely indexed. */
+    if (n > 2 && max_entries >= 4) {
+        uint64_t span = entries[n - 1].timestamp - entries[0].timestamp;
+        int64_t gap   = span / (max_entries / 2) + 1;
+        int j = 1;
+
+        for (int i = 1; i < n - 1; i++)
+            if (entries[i].timestamp - entries[j - 1].timestamp >= gap)
+                entries[j++] = entries[i];
+        entries[j++] = entries[n - 1];
+        n = j;
+    }
+    if ((unsigned) n >= max_entries) {
         int i;
-        for (i = 0; 2 * i < sti->nb_index_entries; i++)
-            sti->index_entries[i] = sti->index_entries[2 * i];
-        sti->nb_index_entries = i;
+        for (i = 0; 2 * i < n; i++)
+            entries[i] = entries[2 * i];
+        n = i;
     }
+    sti->nb_index_entries = n;
 }
 
 int ff_add_index_entry(AVIndexEntry **index_entries,
@@ -0,0 +1,492 @@
+/*
+ * Persistent cache for avformat_find_stream_info() results
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Each cache entry is a file named after a SHA-256 of the input identity
+ * (size, modification time, first bytes, demuxer and analysis limits).
+ * Its first line holds the format level values and each following line
+ * the values of one stream, as serialized AVDictionaries.
+ */
+
+#include <stddef.h>
+#include <sys/stat.h>
+
+#include "libavutil/avstring.h"
+#include "libavutil/bprint.h"
+#include "libavutil/channel_layout.h"
+#include "libavutil/dict.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
+#include "libavutil/random_seed.h"
+#include "libavutil/sha.h"
+#include "avformat.h"
+#include "avio_internal.h"
+#include "demux.h"
+#include "internal.h"
+#include "os_support.h"
+#include "url.h"
+
+#define HEADER_HASH_SIZE (64 * 1024)
+#define MAX_ENTRY_SIZE   (16 * 1024 * 1024)
+
+static const struct {
+    const char *name;
+    size_t offset;
+    size_t size;
+} par_fields[] = {
+#define PAR_FIELD(x) { #x, offsetof(AVCodecParameters, x), sizeof(((AVCodecParameters *)0)->x) }
+    PAR_FIELD(codec_type),
+    PAR_FIELD(codec_id),
+    PAR_FIELD(codec_tag),
+    PAR_FIELD(format),
+    PAR_FIELD(bit_rate),
+    PAR_FIELD(bits_per_coded_sample),
+    PAR_FIELD(bits_per_raw_sample),
+    PAR_FIELD(profile),
+    PAR_FIELD(level),
+    PAR_FIELD(width),
+    PAR_FIELD(height),
+    PAR_FIELD(field_order),
+    PAR_FIELD(color_range),
+    PAR_FIELD(color_primaries),
+    PAR_FIELD(color_trc),
+    PAR_FIELD(color_space),
+    PAR_FIELD(chroma_location),
+    PAR_FIELD(video_delay),
+    PAR_FIELD(sample_rate),
+    PAR_FIELD(block_align),
+    PAR_FIELD(frame_size),
+    PAR_FIELD(initial_padding),
+    PAR_FIELD(trailing_padding),
+    PAR_FIELD(seek_preroll),
+#undef PAR_FIELD
+};
+
+static int64_t get_field(const void *base, size_t offset, size_t size)
+{
+    const uint8_t *p = (const uint8_t *)base + offset;
+    if (size == sizeof(int64_t))
+        return *(const int64_t *)p;
+    return *(const int32_t *)p;
+}
+
+static void set_field(void *base, size_t offset, size_t size, int64_t val)
+{
+    uint8_t *p = (uint8_t *)base + offset;
+    if (size == sizeof(int64_t))
+        *(int64_t *)p = val;
+    else
+        *(int32_t *)p = val;
+}
+
+static void set_rational(AVDictionary **d, const char *key, AVRational q)
+{
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%d/%d", q.num, q.den);
+    av_dict_set(d, key, buf, 0);
+}
+
+static int get_rational(const AVDictionary *d, const char *key, AVRational *q)
+{
+    const AVDictionaryEntry *e = av_dict_get(d, key, NULL, 0);
+    if (!e || sscanf(e->value, "%d/%d", &q->num, &q->den) != 2)
+        return AVERROR_INVALIDDATA;
+    return 0;
+}
+
+static int get_side_data_type(const AVDictionaryEntry *e)
+{
+    const char *p = e->key + strlen("side_data.");
+    char *end;
+    long type = strtol(p, &end, 10);
+
+    if (end == p || *end || type < 0 || type >= AV_PKT_DATA_NB ||
+        strlen(e->value) & 1 || strspn(e->value, "0123456789abcdef") != strlen(e->value))
+        return AVERROR_INVALIDDATA;
+    return type;
+}
+
+static int get_hex(const AVDictionaryEntry *e, uint8_t **data, size_t *size)
+{
+    *size = strlen(e->value) / 2;
+    *data = av_malloc(*size + !*size);
+    if (!*data)
+        return AVERROR(ENOMEM);
+    ff_hex_to_data(*data, e->value);
+    return 0;
+}
+
+static int get_int(const AVDictionary *d, const char *key, int64_t *val)
+{
+    const AVDictionaryEntry *e = av_dict_get(d, key, NULL, 0);
+    char *end;
+    if (!e)
+        return AVERROR_INVALIDDATA;
+    *val = strtoll(e->value, &end, 10);
+    return *end ? AVERROR_INVALIDDATA : 0;
+}
+
+int ff_stream_info_cache_key(AVFormatContext *s, char *key)
+{
+    const char *filename = s->url;
+    const char *proto = filename ? avio_find_protocol_name(filename) : NULL;
+    struct AVSHA *sha;
+    struct stat st;
+    uint8_t digest[32], *buf;
+    int64_t size, pos;
+    int len, ret = 0;
+
+    if (!s->pb || !(s->pb->seekable & AVIO_SEEKABLE_NORMAL) ||
+        s->ctx_flags & AVFMTCTX_NOHEADER)
+        return AVERROR(ENOSYS);
+
+    size = avio_size(s->pb);
+    pos  = avio_tell(s->pb);
+    if (size <= 0 || pos < 0)
+        return AVERROR(ENOSYS);
+
+    /* without a modification time, a rewritten input of the same size and
+     * start would get the entry of the old one */
+    if (!proto || strcmp(proto, "file"))
+        return AVERROR(ENOSYS);
+    av_strstart(filename, "file:", &filename);
+    if (stat(filename, &st) < 0)
+        return AVERROR(ENOSYS);
+
+    buf = av_malloc(HEADER_HASH_SIZE);
+    sha = av_sha_alloc();
+    if (!buf || !sha) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    if ((ret = avio_seek(s->pb, 0, SEEK_SET)) < 0)
+        goto end;
+    len = avio_read(s->pb, buf, HEADER_HASH_SIZE);
+    if ((ret = avio_seek(s->pb, pos, SEEK_SET)) < 0)
+        goto end;
+    if (len <= 0) {
+        ret = len < 0 ? len : AVERROR_INVALIDDATA;
+        goto end;
+    }
+
+    av_sha_init(sha, 256);
+    av_sha_update(sha, s->iformat->name, strlen(s->iformat->name) + 1);
+    AV_WL64(digest,      size);
+    AV_WL64(digest +  8, st.st_mtime);
+    AV_WL64(digest + 16, s->probesize);
+    AV_WL64(digest + 24, s->max_analyze_duration);
+    av_sha_update(sha, digest, 32);
+    AV_WL32(digest, s->fps_probe_size);
+    AV_WL32(digest + 4, s->nb_streams);
+    av_sha_update(sha, digest, 8);
+    av_sha_update(sha, buf, len);
+    av_sha_final(sha, digest);
+    ff_data_to_hex(key, digest, sizeof(digest), 1);
+    key[2 * sizeof(digest)] = 0;
+    ret = 0;
+
+end:
+    av_free(sha);
+    av_free(buf);
+    return ret;
+}
+
+/* Check the entry of a stream against the demuxer's view of it, and
+ * apply it if requested. */
+static int apply_stream(AVStream *st, const AVDictionary *d, int apply)
+{
+    AVCodecParameters *par = st->codecpar;
+    const AVDictionaryEntry *e;
+    AVChannelLayout ch_layout = { 0 };
+    AVRational time_base, r_frame_rate, avg_frame_rate, framerate, sar;
+    int64_t val, start_time, duration;
+    int ret;
+
+    /* Reject entries that do not match what the demuxer found in the header. */
+    if (get_int(d, "codec_type", &val) < 0 || val != par->codec_type)
+        return AVERROR_INVALIDDATA;
+    if (get_int(d, "codec_id", &val) < 0 ||
+        (par->codec_id != AV_CODEC_ID_NONE && val != par->codec_id))
+        return AVERROR_INVALIDDATA;
+    if (get_rational(d, "time_base", &time_base) < 0 ||
+        av_cmp_q(time_base, st->time_base))
+        return AVERROR_INVALIDDATA;
+
+    if (get_rational(d, "r_frame_rate",        &r_frame_rate)   < 0 ||
+        get_rational(d, "avg_frame_rate",      &avg_frame_rate) < 0 ||
+        get_rational(d, "framerate",           &framerate)      < 0 ||
+        get_rational(d, "sample_aspect_ratio", &sar)            < 0 ||
+        get_int(d, "start_time", &start_time) < 0 ||
+        get_int(d, "duration",   &duration)   < 0)
+        return AVERROR_INVALIDDATA;
+
+    e = NULL;
+    while ((e = av_dict_get(d, "side_data.", e, AV_DICT_IGNORE_SUFFIX)))
+        if (get_side_data_type(e) < 0)
+            return AVERROR_INVALIDDATA;
+
+    e = av_dict_get(d, "ch_layout", NULL, 0);
+    if (e && av_channel_layout_from_string(&ch_layout, e->value) < 0)
+        return AVERROR_INVALIDDATA;
+    if (!apply) {
+        av_channel_layout_uninit(&ch_layout);
+        return 0;
+    }
+
+    e = av_dict_get(d, "extradata", NULL, 0);
+    if (e && !par->extradata_size) {
+        int size = strlen(e->value) / 2;
+        if ((ret = ff_alloc_extradata(par, size)) < 0) {
+            av_channel_layout_uninit(&ch_layout);
+            return ret;
+        }
+        ff_hex_to_data(par->extradata, e->value);
+    }
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(par_fields); i++) {
+        if (get_int(d, par_fields[i].name, &val) >= 0)
+            set_field(par, par_fields[i].offset, par_fields[i].size, val);
+    }
+
+    /* side data found by the decoders, e.g. CPB properties; entries
+     * exported by the demuxer from the header are already there */
+    e = NULL;
+    while ((e = av_dict_get(d, "side_data.", e, AV_DICT_IGNORE_SUFFIX))) {
+        int type = get_side_data_type(e);
+        uint8_t *data;
+        size_t size;
+
+        if (av_packet_side_data_get(par->coded_side_data,
+                                    par->nb_coded_side_data, type))
+            continue;
+        if ((ret = get_hex(e, &data, &size)) < 0) {
+            av_channel_layout_uninit(&ch_layout);
+            return ret;
+        }
+        if (!av_packet_side_data_add(&par->coded_side_data,
+                                     &par->nb_coded_side_data,
+                                     type, data, size, 0)) {
+            av_free(data);
+            av_channel_layout_uninit(&ch_layout);
+            return AVERROR(ENOMEM);
+        }
+    }
+    if (ch_layout.nb_channels) {
+        av_channel_layout_uninit(&par->ch_layout);
+        par->ch_layout = ch_layout;
+    }
+    par->framerate           = framerate;
+    par->sample_aspect_ratio = sar;
+    st->sample_aspect_ratio  = sar;
+    st->r_frame_rate         = r_frame_rate;
+    st->avg_frame_rate       = avg_frame_rate;
+    st->start_time           = start_time;
+    st->duration             = duration;
+
+    if (par->codec_id != AV_CODEC_ID_NONE)
+        ffstream(st)->request_probe = 0;
+    ffstream(st)->need_context_update = 1;
+    return 0;
+}
+
+int ff_stream_info_cache_load(AVFormatContext *s, const char *key)
+{
+    AVDictionary **dicts = NULL;
+    AVIOContext *pb = NULL;
+    AVBPrint bp;
+    char *path, *line, *next;
+    int64_t start_time, duration, bit_rate;
+    int nb_lines = 0, ret;
+
+    path = av_asprintf("%s/%s", s->stream_info_cache, key);
+    if (!path)
+        return AVERROR(ENOMEM);
+    av_bprint_init(&bp, 0, AV_BPRINT_SIZE_UNLIMITED);
+
+    ret = avio_open2(&pb, path, AVIO_FLAG_READ, &s->interrupt_callback, NULL);
+    if (ret < 0) {
+        /* a missing entry is not an error */
+        ret = 0;
+        goto end;
+    }
+    ret = avio_read_to_bprint(pb, &bp, MAX_ENTRY_SIZE);
+    if (ret < 0)
+        goto end;
+    if (!av_bprint_is_complete(&bp)) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    dicts = av_calloc(s->nb_streams + 1, sizeof(*dicts));
+    if (!dicts) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    for (line = bp.str; line && *line; line = next) {
+        next = strchr(line, '\n');
+        if (next)
+            *next++ = 0;
+        if (nb_lines > (int)s->nb_streams) {
+            nb_lines++;
+            break;
+        }
+        ret = av_dict_parse_string(&dicts[nb_lines++], line, "=", ";", 0);
+        if (ret < 0)
+            goto invalid;
+    }
+    if (nb_lines != s->nb_streams + 1)
+        goto invalid;
+
+    if (get_int(dicts[0], "start_time", &start_time) < 0 ||
+        get_int(dicts[0], "duration",   &duration)   < 0 ||
+        get_int(dicts[0], "bit_rate",   &bit_rate)   < 0)
+        goto invalid;
+
+    /* Check every stream before modifying any of them. */
+    for (unsigned i = 0; i < s->nb_streams; i++) {
+        if (apply_stream(s->streams[i], dicts[i + 1], 0) < 0)
+            goto invalid;
+    }
+    for (unsigned i = 0; i < s->nb_streams; i++) {
+        ret = apply_stream(s->streams[i], dicts[i + 1], 1);
+        if (ret < 0)
+            goto end;
+    }
+    s->start_time = start_time;
+    s->duration   = duration;
+    s->bit_rate   = bit_rate;
+
+    av_log(s, AV_LOG_VERBOSE, "Stream information loaded from %s\n", path);
+    ret = 1;
+    goto end;
+
+invalid:
+    av_log(s, AV_LOG_WARNING, "Ignoring invalid stream info cache entry %s\n", path);
+    ret = 0;
+end:
+    if (dicts) {
+        for (unsigned i = 0; i <= s->nb_streams; i++)
+            av_dict_free(&dicts[i]);
+        av_free(dicts);
+    }
+    av_bprint_finalize(&bp, NULL);
+    avio_closep(&pb);
+    av_free(path);
+    return ret;
+}
+
+static int write_dict(AVIOContext *pb, const AVDictionary *d)
+{
+    char *buf;
+    int ret = av_dict_get_string(d, &buf, '=', ';');
+    if (ret < 0)
+        return ret;
+    avio_printf(pb, "%s\n", buf);
+    av_free(buf);
+    return 0;
+}
+
+static int serialize_stream(AVDictionary **d, const AVStream *st)
+{
+    const AVCodecParameters *par = st->codecpar;
+    char buf[256];
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(par_fields); i++)
+        av_dict_set_int(d, par_fields[i].name,
+                        get_field(par, par_fields[i].offset, par_fields[i].size), 0);
+    if (par->ch_layout.nb_channels &&
+        av_channel_layout_describe(&par->ch_layout, buf, sizeof(buf)) > 0)
+        av_dict_set(d, "ch_layout", buf, 0);
+    if (par->extradata_size) {
+        char *hex = av_malloc(2 * par->extradata_size + 1);
+        if (!hex)
+            return AVERROR(ENOMEM);
+        ff_data_to_hex(hex, par->extradata, par->extradata_size, 1);
+        hex[2 * par->extradata_size] = 0;
+        av_dict_set(d, "extradata", hex, AV_DICT_DONT_STRDUP_VAL);
+    }
+    for (int i = 0; i < par->nb_coded_side_data; i++) {
+        const AVPacketSideData *sd = &par->coded_side_data[i];
+        char *hex = av_malloc(2 * sd->size + 1);
+        if (!hex)
+            return AVERROR(ENOMEM);
+        ff_data_to_hex(hex, sd->data, sd->size, 1);
+        hex[2 * sd->size] = 0;
+        snprintf(buf, sizeof(buf), "side_data.%d", sd->type);
+        av_dict_set(d, buf, hex, AV_DICT_DONT_STRDUP_VAL);
+    }
+    set_rational(d, "time_base",           st->time_base);
+    set_rational(d, "r_frame_rate",        st->r_frame_rate);
+    set_rational(d, "avg_frame_rate",      st->avg_frame_rate);
+    set_rational(d, "framerate",           par->framerate);
+    set_rational(d, "sample_aspect_ratio", st->sample_aspect_ratio);
+    av_dict_set_int(d, "start_time", st->start_time, 0);
+    av_dict_set_int(d, "duration",   st->duration,   0);
+    return 0;
+}
+
+int ff_stream_info_cache_store(AVFormatContext *s, const char *key)
+{
+    AVDictionary *d = NULL;
+    AVIOContext *pb = NULL;
+    char *path, *tmp;
+    int ret;
+
+    path = av_asprintf("%s/%s", s->stream_info_cache, key);
+    tmp  = av_asprintf("%s/%s.%08x.tmp", s->stream_info_cache, key, av_get_random_seed());
+    if (!path || !tmp) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    ret = avio_open2(&pb, tmp, AVIO_FLAG_WRITE, &s->interrupt_callback, NULL);
+    if (ret < 0)
+        goto end;
+
+    av_dict_set_int(&d, "start_time", s->start_time, 0);
+    av_dict_set_int(&d, "duration",   s->duration,   0);
+    av_dict_set_int(&d, "bit_rate",   s->bit_rate,   0);
+    ret = write_dict(pb, d);
+    av_dict_free(&d);
+    for (unsigned i = 0; ret >= 0 && i < s->nb_streams; i++) {
+        ret = serialize_stream(&d, s->streams[i]);
+        if (ret >= 0)
+            ret = write_dict(pb, d);
+        av_dict_free(&d);
+    }
+    if (ret >= 0)
+        ret = pb->error;
+    avio_closep(&pb);
+
+    /* publish the entry atomically, concurrent readers never see a partial one */
+    if (ret >= 0)
+        ret = ff_rename(tmp, path, s);
+    if (ret < 0) {
+        av_log(s, AV_LOG_WARNING, "Could not write stream info cache entry %s: %s\n",
+               path, av_err2str(ret));
+        ffurl_delete(tmp);
+    }
+
+end:
+    av_free(path);
+    av_free(tmp);
+    return ret;
+}
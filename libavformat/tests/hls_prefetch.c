@@ -0,0 +1,244 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Read a HLS stream with segment prefetching from a local HTTP server, and
+ * print the cookies sent with each request. The response to the prefetched
+ * segment 1 sets a cookie, which the requests for the next segments must
+ * send. The server holds back segment 0 until segment 1 is requested, so
+ * that segment 1 is always downloaded by a prefetch thread.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavformat/avformat.h"
+#include "libavformat/network.h"
+#include "libavformat/os_support.h"
+#include "libavutil/avstring.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/thread.h"
+#include "libavutil/time.h"
+
+#define NB_SEGMENTS    4
+#define SEGMENT_SIZE   4096
+#define MAX_REQUESTS   32
+
+typedef struct Server {
+    int fd;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    int seg1_requested;
+    char cookies[NB_SEGMENTS][256];
+    pthread_t threads[MAX_REQUESTS];
+    int nb_threads;
+} Server;
+
+typedef struct Request {
+    Server *server;
+    int fd;
+} Request;
+
+static int send_all(int fd, const void *buf, int size)
+{
+    const uint8_t *p = buf;
+
+    while (size > 0) {
+        int ret = send(fd, p, size, 0);
+        if (ret <= 0)
+            return -1;
+        p    += ret;
+        size -= ret;
+    }
+    return 0;
+}
+
+static void send_response(int fd, const char *headers, const uint8_t *body, int size)
+{
+    char buf[512];
+
+    snprintf(buf, sizeof(buf), "HTTP/1.1 200 OK\r\n"
+             "Content-Length: %d\r\n"
+             "Connection: close\r\n"
+             "%s\r\n", size, headers);
+    if (!send_all(fd, buf, strlen(buf)))
+        send_all(fd, body, size);
+}
+
+static void *serve_request(void *arg)
+{
+    Request *req = arg;
+    Server *server = req->server;
+    char buf[2048], cookie[256] = "";
+    const char *p;
+    int len = 0, seg;
+
+    while (len < sizeof(buf) - 1 && !strstr(buf, "\r\n\r\n")) {
+        int ret = recv(req->fd, buf + len, sizeof(buf) - 1 - len, 0);
+        if (ret <= 0)
+            break;
+        len += ret;
+        buf[len] = 0;
+    }
+    buf[len] = 0;
+
+    if ((p = strstr(buf, "\r\nCookie: ")))
+        av_strlcpy(cookie, p + 10, FFMIN(sizeof(cookie), strcspn(p + 10, "\r\n") + 1));
+
+    if (av_strstart(buf, "GET /index.m3u8 ", NULL)) {
+        char playlist[512] = "#EXTM3U\n#EXT-X-TARGETDURATION:1\n#EXT-X-MEDIA-SEQUENCE:0\n";
+
+        for (int i = 0; i < NB_SEGMENTS; i++)
+            av_strlcatf(playlist, sizeof(playlist), "#EXTINF:1.0,\nseg%d.wav\n", i);
+        av_strlcat(playlist, "#EXT-X-ENDLIST\n", sizeof(playlist));
+        send_response(req->fd, "", playlist, strlen(playlist));
+    } else if (sscanf(buf, "GET /seg%d.wav ", &seg) == 1 && seg >= 0 && seg < NB_SEGMENTS) {
+        uint8_t data[SEGMENT_SIZE] = { 0 };
+
+        /* a WAV header for 8 kHz mono 8 bit PCM, the other segments are
+         * just more samples */
+        if (!seg) {
+            memcpy(data, "RIFF", 4);
+            AV_WL32(data + 4, NB_SEGMENTS * SEGMENT_SIZE - 8);
+            memcpy(data + 8, "WAVEfmt ", 8);
+            AV_WL32(data + 16, 16);
+            AV_WL16(data + 20, 1);
+            AV_WL16(data + 22, 1);
+            AV_WL32(data + 24, 8000);
+            AV_WL32(data + 28, 8000);
+            AV_WL16(data + 32, 1);
+            AV_WL16(data + 34, 8);
+            memcpy(data + 36, "data", 4);
+            AV_WL32(data + 40, NB_SEGMENTS * SEGMENT_SIZE - 44);
+        }
+
+        pthread_mutex_lock(&server->lock);
+        av_strlcpy(server->cookies[seg], *cookie ? cookie : "none", sizeof(server->cookies[seg]));
+        if (seg == 1) {
+            server->seg1_requested = 1;
+            pthread_cond_broadcast(&server->cond);
+        }
+        if (!seg) {
+            int64_t timeout = av_gettime() + 10000000;
+            struct timespec ts = { timeout / 1000000, timeout % 1000000 * 1000 };
+            while (!server->seg1_requested &&
+                   !pthread_cond_timedwait(&server->cond, &server->lock, &ts));
+        }
+        pthread_mutex_unlock(&server->lock);
+
+        send_response(req->fd, seg == 1 ? "Set-Cookie: seg1=1; path=/\r\n" : "",
+                      data, sizeof(data));
+    }
+
+    closesocket(req->fd);
+    av_free(req);
+    return NULL;
+}
+
+static void *serve(void *arg)
+{
+    Server *server = arg;
+
+    while (server->nb_threads < MAX_REQUESTS) {
+        Request *req;
+        int fd = accept(server->fd, NULL, NULL);
+
+        if (fd < 0)
+            break;
+        req = av_mallocz(sizeof(*req));
+        if (!req) {
+            closesocket(fd);
+            break;
+        }
+        req->server = server;
+        req->fd     = fd;
+        if (pthread_create(&server->threads[server->nb_threads], NULL, serve_request, req)) {
+            closesocket(fd);
+            av_free(req);
+            break;
+        }
+        server->nb_threads++;
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    Server server = { .fd = -1 };
+    struct sockaddr_in addr = { 0 };
+    socklen_t addr_len = sizeof(addr);
+    AVFormatContext *ic = NULL;
+    AVDictionary *opts = NULL;
+    AVPacket *pkt = NULL;
+    pthread_t thread;
+    char url[64];
+    int ret = 1;
+
+    ff_network_init();
+    pthread_mutex_init(&server.lock, NULL);
+    pthread_cond_init(&server.cond, NULL);
+
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    server.fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (server.fd < 0 ||
+        bind(server.fd, (struct sockaddr *)&addr, sizeof(addr)) ||
+        listen(server.fd, MAX_REQUESTS) ||
+        getsockname(server.fd, (struct sockaddr *)&addr, &addr_len)) {
+        fprintf(stderr, "Failed to start the server\n");
+        goto end;
+    }
+    if (pthread_create(&thread, NULL, serve, &server)) {
+        fprintf(stderr, "Failed to start the server thread\n");
+        goto end;
+    }
+
+    snprintf(url, sizeof(url), "http://127.0.0.1:%d/index.m3u8", ntohs(addr.sin_port));
+    av_dict_set(&opts, "prefetch_segments", "1", 0);
+    av_dict_set(&opts, "http_persistent", "0", 0);
+    av_dict_set(&opts, "http_multiple", "0", 0);
+    if (avformat_open_input(&ic, url, NULL, &opts) < 0) {
+        fprintf(stderr, "Failed to open %s\n", url);
+    } else if ((pkt = av_packet_alloc())) {
+        while (av_read_frame(ic, pkt) >= 0)
+            av_packet_unref(pkt);
+        ret = 0;
+    }
+    av_packet_free(&pkt);
+    avformat_close_input(&ic);
+    av_dict_free(&opts);
+
+    /* stop accepting connections */
+    shutdown(server.fd, SHUT_RDWR);
+    closesocket(server.fd);
+    server.fd = -1;
+    pthread_join(thread, NULL);
+    for (int i = 0; i < server.nb_threads; i++)
+        pthread_join(server.threads[i], NULL);
+
+    for (int i = 0; i < NB_SEGMENTS; i++)
+        printf("seg%d.wav: %s\n", i, *server.cookies[i] ? server.cookies[i] : "not requested");
+
+end:
+    if (server.fd >= 0)
+        closesocket(server.fd);
+    pthread_cond_destroy(&server.cond);
+    pthread_mutex_destroy(&server.lock);
+    ff_network_close();
+    return ret;
+}
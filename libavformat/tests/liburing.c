@@ -0,0 +1,135 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "libavutil/dict.h"
+#include "libavutil/error.h"
+#include "libavformat/avformat.h"
+#include "libavformat/url.h"
+
+#define BLOCK_SIZE  4096
+#define FILE_SIZE   (10 * BLOCK_SIZE + 123)
+
+static uint8_t pattern(int64_t pos)
+{
+    return pos * 7 + (pos >> 12);
+}
+
+static int open_uring(URLContext **h, const char *url, int flags)
+{
+    AVDictionary *opts = NULL;
+    int ret;
+
+    av_dict_set_int(&opts, "block_size",  BLOCK_SIZE, 0);
+    av_dict_set_int(&opts, "queue_depth", 4, 0);
+    ret = ffurl_open_whitelist(h, url, flags, NULL, &opts, NULL, NULL, NULL);
+    av_dict_free(&opts);
+    return ret;
+}
+
+static int write_file(const char *url)
+{
+    URLContext *h;
+    uint8_t buf[1000];
+    int64_t pos = 0;
+    int ret;
+
+    if ((ret = open_uring(&h, url, AVIO_FLAG_WRITE)) < 0)
+        return ret;
+    while (pos < FILE_SIZE) {
+        int size = FFMIN(sizeof(buf), FILE_SIZE - pos);
+        for (int i = 0; i < size; i++)
+            buf[i] = pattern(pos + i);
+        ret = ffurl_write(h, buf, size);
+        if (ret < 0)
+            break;
+        pos += ret;
+    }
+    if (ret >= 0)
+        ret = ffurl_closep(&h);
+    else
+        ffurl_closep(&h);
+    return ret;
+}
+
+static void test_read(URLContext *h, int64_t pos, int size)
+{
+    uint8_t buf[3 * BLOCK_SIZE];
+    int64_t ret;
+    int i;
+
+    if (pos < 0)
+        pos = ffurl_seek(h, 0, SEEK_CUR);
+    printf("read %6"PRId64" +%5d: ", pos, size);
+    if ((ret = ffurl_seek(h, pos, SEEK_SET)) < 0) {
+        printf("seek error %s\n", av_err2str(ret));
+        return;
+    }
+    ret = ffurl_read_complete(h, buf, size);
+    if (ret < 0) {
+        printf("%s\n", av_err2str(ret));
+        return;
+    }
+    for (i = 0; i < ret; i++)
+        if (buf[i] != pattern(pos + i))
+            break;
+    printf("%5"PRId64" bytes, %s\n", ret, i == ret ? "ok" : "mismatch");
+}
+
+int main(int argc, char **argv)
+{
+    URLContext *h;
+    char url[1024];
+    int ret;
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <temporary file>\n", argv[0]);
+        return 1;
+    }
+    snprintf(url, sizeof(url), "uring:%s", argv[1]);
+
+    if ((ret = write_file(url)) < 0) {
+        fprintf(stderr, "Writing failed: %s\n", av_err2str(ret));
+        return 1;
+    }
+    if ((ret = open_uring(&h, url, AVIO_FLAG_READ)) < 0) {
+        fprintf(stderr, "Opening failed: %s\n", av_err2str(ret));
+        unlink(argv[1]);
+        return 1;
+    }
+
+    printf("size %"PRId64"\n", ffurl_seek(h, 0, AVSEEK_SIZE));
+    test_read(h, 0,     100);
+    /* skip blocks inside the read-ahead window, then finish the block so
+     * that the window moves on over the skipped ones */
+    test_read(h, 2 * BLOCK_SIZE + 10, 50);
+    test_read(h, 2 * BLOCK_SIZE + 60, BLOCK_SIZE - 60);
+    test_read(h, -1, 3 * BLOCK_SIZE);
+    test_read(h, 6 * BLOCK_SIZE - 1, 2);
+    test_read(h, 5000,  200);
+    test_read(h, 9 * BLOCK_SIZE + 100, 2 * BLOCK_SIZE);
+    test_read(h, 1,     BLOCK_SIZE);
+    test_read(h, FILE_SIZE, 10);
+
+    ffurl_closep(&h);
+    unlink(argv[1]);
+    return 0;
+}
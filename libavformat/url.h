@@ -83,6 +83,11 @@ typedef struct URLProtocol {
     int (*url_get_multi_file_handle)(URLContext *h, int **handles,
                                      int *numhandles);
     int (*url_get_short_seek)(URLContext *h);
+    /**
+     * Return a pointer to size bytes at pos in a read-only mapping of the
+     * resource, valid until the URLContext is closed.
+     */
+    int (*url_get_mapping)(URLContext *h, int64_t pos, int size, const uint8_t **data);
     int (*url_shutdown)(URLContext *h, int flags);
     const AVClass *priv_data_class;
     int priv_data_size;
@@ -263,6 +268,16 @@ int ffurl_get_multi_file_handle(URLContext *h, int **handles, int *numhandles);
  */
 int ffurl_get_short_seek(void *urlcontext);
 
+/**
+ * Return a pointer to size bytes at pos in a read-only memory mapping of the
+ * resource, if the protocol has one. The pointer stays valid until the
+ * URLContext is closed.
+ *
+ * @return 0 on success, AVERROR_EOF if the range is not entirely in the
+ *         resource, or another error <0.
+ */
+int ffurl_get_mapping(void *urlcontext, int64_t pos, int size, const uint8_t **data);
+
 /**
  * Signal the URLContext that we are done reading or writing the stream.
  *
@@ -17,11 +17,13 @@
  */
 
 #include <stdatomic.h>
+#include "buffer.h"
 #include "cpu.h"
 #include "internal.h"
 #include "slicethread.h"
 #include "mem.h"
 #include "thread.h"
+#include "threadpool.h"
 #include "avassert.h"
 
 #define MAX_AUTO_THREADS 16
@@ -36,6 +38,19 @@ typedef struct WorkerContext {
     int             done;
 } WorkerContext;
 
+typedef struct ThreadPool {
+    pthread_t       *threads;
+    int             nb_threads;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    int             finished;
+
+    /* slice threading contexts with jobs left to claim, served round-robin */
+    AVSliceThread   *queue_head;
+    AVSliceThread   *queue_tail;
+} ThreadPool;
+
 struct AVSliceThread {
     WorkerContext   *workers;
     int             nb_threads;
@@ -52,6 +67,14 @@ struct AVSliceThread {
     void            *priv;
     void            (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads);
     void            (*main_func)(void *priv);
+
+    /* shared pool mode, see avpriv_slicethread_create_shared() */
+    AVBufferRef     *pool_ref;
+    ThreadPool      *pool;
+    AVSliceThread   *queue_next;
+    int             queued;
+    atomic_uint     jobs_done;
+    atomic_uint     pool_users;
 };
 
 static int run_jobs(AVSliceThread *ctx)
@@ -68,6 +91,263 @@ static int run_jobs(AVSliceThread *ctx)
     return current_job == nb_jobs + nb_active_threads - 1;
 }
 
+/**
+ * Run jobs of a context in shared pool mode. Any number of threads may call
+ * this concurrently, each one claims a thread slot and then takes jobs until
+ * none are left; slot numbers are passed as threadnr, so they stay unique
+ * among the threads running the context's jobs at any time.
+ */
+static void run_shared_jobs(AVSliceThread *ctx)
+{
+    unsigned nb_jobs           = ctx->nb_jobs;
+    unsigned nb_active_threads = ctx->nb_active_threads;
+    unsigned nb_done = 0, slot;
+
+    while ((slot = atomic_fetch_add_explicit(&ctx->first_job, 1, memory_order_acq_rel)) < nb_active_threads) {
+        unsigned current_job = slot;
+
+        do {
+            ctx->worker_func(ctx->priv, current_job, slot, nb_jobs, nb_active_threads);
+            nb_done++;
+        } while ((current_job = atomic_fetch_add_explicit(&ctx->current_job, 1, memory_order_acq_rel)) < nb_jobs);
+    }
+
+    if (nb_done &&
+        atomic_fetch_add_explicit(&ctx->jobs_done, nb_done, memory_order_acq_rel) + nb_done == nb_jobs) {
+        pthread_mutex_lock(&ctx->done_mutex);
+        ctx->done = 1;
+        pthread_cond_signal(&ctx->done_cond);
+        pthread_mutex_unlock(&ctx->done_mutex);
+    }
+}
+
+/* must be called with pool->mutex held */
+static void pool_dequeue(ThreadPool *pool, AVSliceThread *ctx)
+{
+    AVSliceThread **prev = &pool->queue_head, *last = NULL;
+
+    if (!ctx->queued)
+        return;
+
+    while (*prev != ctx) {
+        last = *prev;
+        prev = &(*prev)->queue_next;
+    }
+    *prev = ctx->queue_next;
+    if (pool->queue_tail == ctx)
+        pool->queue_tail = last;
+
+    ctx->queue_next = NULL;
+    ctx->queued     = 0;
+}
+
+/* must be called with pool->mutex held */
+static void pool_enqueue(ThreadPool *pool, AVSliceThread *ctx)
+{
+    ctx->queue_next = NULL;
+    ctx->queued     = 1;
+    if (pool->queue_tail)
+        pool->queue_tail->queue_next = ctx;
+    else
+        pool->queue_head = ctx;
+    pool->queue_tail = ctx;
+}
+
+static void *attribute_align_arg pool_worker(void *v)
+{
+    ThreadPool *pool = v;
+
+    pthread_mutex_lock(&pool->mutex);
+
+    while (!pool->finished) {
+        AVSliceThread *ctx = pool->queue_head;
+
+        if (!ctx) {
+            pthread_cond_wait(&pool->cond, &pool->mutex);
+            continue;
+        }
+
+        /* move the context to the back of the queue if other threads may
+         * still help with it, so that all the contexts sharing the pool
+         * get a fair share of the workers */
+        atomic_fetch_add_explicit(&ctx->pool_users, 1, memory_order_relaxed);
+        pool_dequeue(pool, ctx);
+        if (atomic_load_explicit(&ctx->first_job, memory_order_relaxed) + 1 < ctx->nb_active_threads)
+            pool_enqueue(pool, ctx);
+
+        pthread_mutex_unlock(&pool->mutex);
+
+        run_shared_jobs(ctx);
+
+        pthread_mutex_lock(&ctx->done_mutex);
+        atomic_fetch_sub_explicit(&ctx->pool_users, 1, memory_order_relaxed);
+        pthread_cond_signal(&ctx->done_cond);
+        pthread_mutex_unlock(&ctx->done_mutex);
+
+        pthread_mutex_lock(&pool->mutex);
+    }
+
+    pthread_mutex_unlock(&pool->mutex);
+
+    return NULL;
+}
+
+static void pool_free(void *opaque, uint8_t *data)
+{
+    ThreadPool *pool = (ThreadPool*)data;
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->finished = 1;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (int i = 0; i < pool->nb_threads; i++)
+        pthread_join(pool->threads[i], NULL);
+
+    pthread_cond_destroy(&pool->cond);
+    pthread_mutex_destroy(&pool->mutex);
+    av_freep(&pool->threads);
+    av_freep(&pool);
+}
+
+AVBufferRef *av_thread_pool_alloc(int nb_threads)
+{
+    AVBufferRef *buf;
+    ThreadPool *pool;
+    int ret;
+
+    if (nb_threads < 0)
+        return NULL;
+    if (!nb_threads)
+        nb_threads = av_cpu_count();
+
+    pool = av_mallocz(sizeof(*pool));
+    if (!pool)
+        return NULL;
+
+    pool->threads = av_calloc(nb_threads, sizeof(*pool->threads));
+    if (!pool->threads)
+        goto fail;
+
+    ret = pthread_mutex_init(&pool->mutex, NULL);
+    if (ret)
+        goto fail;
+    ret = pthread_cond_init(&pool->cond, NULL);
+    if (ret) {
+        pthread_mutex_destroy(&pool->mutex);
+        goto fail;
+    }
+
+    for (; pool->nb_threads < nb_threads; pool->nb_threads++) {
+        ret = pthread_create(&pool->threads[pool->nb_threads], NULL, pool_worker, pool);
+        if (ret) {
+            pool_free(NULL, (uint8_t*)pool);
+            return NULL;
+        }
+    }
+
+    buf = av_buffer_create((uint8_t*)pool, sizeof(*pool), pool_free, NULL, 0);
+    if (!buf)
+        pool_free(NULL, (uint8_t*)pool);
+    return buf;
+fail:
+    av_freep(&pool->threads);
+    av_freep(&pool);
+    return NULL;
+}
+
+int avpriv_slicethread_create_shared(AVSliceThread **pctx, AVBufferRef *pool_ref,
+                                     void *priv,
+                                     void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                                     void (*main_func)(void *priv),
+                                     int nb_threads)
+{
+    AVSliceThread *ctx;
+    ThreadPool *pool;
+    int ret;
+
+    /* the main function may wait for the workers' progress, which is not
+     * guaranteed when the workers are shared */
+    if (!pool_ref || main_func)
+        return avpriv_slicethread_create(pctx, priv, worker_func, main_func, nb_threads);
+
+    av_assert0(nb_threads >= 0);
+    pool = (ThreadPool*)pool_ref->data;
+    if (!nb_threads)
+        nb_threads = pool->nb_threads + 1;
+
+    *pctx = ctx = av_mallocz(sizeof(*ctx));
+    if (!ctx)
+        return AVERROR(ENOMEM);
+
+    ctx->pool_ref = av_buffer_ref(pool_ref);
+    if (!ctx->pool_ref) {
+        av_freep(pctx);
+        return AVERROR(ENOMEM);
+    }
+    ctx->pool = pool;
+
+    ctx->priv        = priv;
+    ctx->worker_func = worker_func;
+    ctx->nb_threads  = nb_threads;
+
+    atomic_init(&ctx->first_job,   0);
+    atomic_init(&ctx->current_job, 0);
+    atomic_init(&ctx->jobs_done,   0);
+    atomic_init(&ctx->pool_users,  0);
+
+    ret = pthread_mutex_init(&ctx->done_mutex, NULL);
+    if (ret) {
+        av_buffer_unref(&ctx->pool_ref);
+        av_freep(pctx);
+        return AVERROR(ret);
+    }
+    ret = pthread_cond_init(&ctx->done_cond, NULL);
+    if (ret) {
+        pthread_mutex_destroy(&ctx->done_mutex);
+        av_buffer_unref(&ctx->pool_ref);
+        av_freep(pctx);
+        return AVERROR(ret);
+    }
+
+    return nb_threads;
+}
+
+static void shared_execute(AVSliceThread *ctx, int nb_jobs)
+{
+    ThreadPool *pool = ctx->pool;
+
+    ctx->nb_jobs           = nb_jobs;
+    ctx->nb_active_threads = FFMIN(nb_jobs, ctx->nb_threads);
+    ctx->done              = 0;
+    atomic_store_explicit(&ctx->first_job, 0, memory_order_relaxed);
+    atomic_store_explicit(&ctx->current_job, ctx->nb_active_threads, memory_order_relaxed);
+    atomic_store_explicit(&ctx->jobs_done, 0, memory_order_relaxed);
+
+    if (ctx->nb_active_threads > 1) {
+        pthread_mutex_lock(&pool->mutex);
+        pool_enqueue(pool, ctx);
+        pthread_cond_broadcast(&pool->cond);
+        pthread_mutex_unlock(&pool->mutex);
+    }
+
+    /* the calling thread takes part as well, so all the jobs get done even
+     * when all the pool workers are busy with other contexts */
+    run_shared_jobs(ctx);
+
+    if (ctx->nb_active_threads > 1) {
+        pthread_mutex_lock(&pool->mutex);
+        pool_dequeue(pool, ctx);
+        pthread_mutex_unlock(&pool->mutex);
+    }
+
+    pthread_mutex_lock(&ctx->done_mutex);
+    while (!ctx->done || atomic_load_explicit(&ctx->pool_users, memory_order_relaxed))
+        pthread_cond_wait(&ctx->done_cond, &ctx->done_mutex);
+    ctx->done = 0;
+    pthread_mutex_unlock(&ctx->done_mutex);
+}
+
 static void *attribute_align_arg thread_worker(void *v)
 {
     WorkerContext *w = v;
@@ -192,6 +472,12 @@ void avpriv_slicethread_execute(AVSliceThread *ctx, int nb_jobs, int execute_mai
     int nb_workers, i, is_last = 0;
 
     av_assert0(nb_jobs > 0);
+
+    if (ctx->pool) {
+        shared_execute(ctx, nb_jobs);
+        return;
+    }
+
     ctx->nb_jobs           = nb_jobs;
     ctx->nb_active_threads = FFMIN(nb_jobs, ctx->nb_threads);
     atomic_store_explicit(&ctx->first_job, 0, memory_order_relaxed);
@@ -231,6 +517,15 @@ void avpriv_slicethread_free(AVSliceThread **pctx)
         return;
 
     ctx = *pctx;
+
+    if (ctx->pool) {
+        pthread_cond_destroy(&ctx->done_cond);
+        pthread_mutex_destroy(&ctx->done_mutex);
+        av_buffer_unref(&ctx->pool_ref);
+        av_freep(pctx);
+        return;
+    }
+
     nb_workers = ctx->nb_threads;
     if (!ctx->main_func)
         nb_workers--;
@@ -268,6 +563,21 @@ int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
     return AVERROR(ENOSYS);
 }
 
+int avpriv_slicethread_create_shared(AVSliceThread **pctx, AVBufferRef *pool_ref,
+                                     void *priv,
+                                     void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                                     void (*main_func)(void *priv),
+                                     int nb_threads)
+{
+    *pctx = NULL;
+    return AVERROR(ENOSYS);
+}
+
+AVBufferRef *av_thread_pool_alloc(int nb_threads)
+{
+    return NULL;
+}
+
 void avpriv_slicethread_execute(AVSliceThread *ctx, int nb_jobs, int execute_main)
 {
     av_assert0(0);
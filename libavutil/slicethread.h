@@ -19,6 +19,8 @@
 #ifndef AVUTIL_SLICETHREAD_H
 #define AVUTIL_SLICETHREAD_H
 
+#include "buffer.h"
+
 typedef struct AVSliceThread AVSliceThread;
 
 /**
@@ -35,6 +37,23 @@ int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
                               void (*main_func)(void *priv),
                               int nb_threads);
 
+/**
+ * Create slice threading context running its jobs on a shared pool of
+ * threads, see av_thread_pool_alloc().
+ * The calling thread of avpriv_slicethread_execute() always takes part in
+ * running the jobs. If pool_ref is NULL or main_func is set, this is the
+ * same as avpriv_slicethread_create().
+ * @param pool_ref reference to the thread pool, a new reference is created
+ * @param nb_threads maximum number of threads running jobs at the same time,
+ *                   0 for the size of the pool, must be >= 0
+ * @return return number of threads or negative AVERROR on failure
+ */
+int avpriv_slicethread_create_shared(AVSliceThread **pctx, AVBufferRef *pool_ref,
+                                     void *priv,
+                                     void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                                     void (*main_func)(void *priv),
+                                     int nb_threads);
+
 /**
  * Execute slice threading.
  * @param ctx slice threading context
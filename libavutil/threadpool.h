@@ -0,0 +1,59 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * @ingroup lavu_thread_pool
+ * Thread pool shared between several contexts.
+ */
+
+#ifndef AVUTIL_THREADPOOL_H
+#define AVUTIL_THREADPOOL_H
+
+#include "buffer.h"
+
+/**
+ * @defgroup lavu_thread_pool Thread pool
+ * @ingroup lavu_data
+ *
+ * A set of worker threads that slice threading in several libavcodec,
+ * libavfilter and libswscale contexts can share, instead of each of them
+ * creating its own threads. The pool is reference counted through
+ * AVBufferRef, it is freed when the last reference to it is released.
+ *
+ * Pending work from the contexts sharing a pool is served round-robin. The
+ * thread requesting the work always takes part in it, so a context is never
+ * starved when all the pool's threads are busy.
+ *
+ * @{
+ */
+
+/**
+ * Allocate a thread pool.
+ *
+ * @param nb_threads number of worker threads, 0 for one per CPU core
+ * @return a reference to the new pool, or NULL on failure or if threading
+ *         is not supported
+ */
+AVBufferRef *av_thread_pool_alloc(int nb_threads);
+
+/**
+ * @}
+ */
+
+#endif /* AVUTIL_THREADPOOL_H */
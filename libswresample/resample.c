@@ -173,17 +173,67 @@ fail:
     return ret;
 }
 
+/* channels resampled by one call of multiple_resample(), one slice thread
+ * job per channel */
+typedef struct ResampleJob {
+    ResampleContext ctx;                        ///< state before the call, for all channels but the last
+    AudioData *dst, *src;
+    int n;
+    int64_t index2, incr;                       ///< for resample_one
+    int (*resample_func)(struct ResampleContext *c, void *dst,
+                         const void *src, int n, int update_ctx);
+    int consumed;
+} ResampleJob;
+
+static void resample_worker(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
+{
+    ResampleContext *c = priv;
+    ResampleJob *job = c->job;
+    void *dst = job->dst->ch[jobnr];
+    const void *src = job->src->ch[jobnr];
+
+    if (!job->resample_func) {
+        job->ctx.dsp.resample_one(dst, src, job->n, job->index2, job->incr);
+    } else if (jobnr + 1 < nb_jobs) {
+        job->resample_func(&job->ctx, dst, src, job->n, 0);
+    } else {
+        /* only the last channel updates the context, the others use the copy */
+        job->consumed = job->resample_func(c, dst, src, job->n, 1);
+    }
+}
+
+static int init_threads(ResampleContext *c, int nb_threads)
+{
+    int ret;
+
+    if (c->nb_threads == nb_threads)
+        return 0;
+    avpriv_slicethread_free(&c->slicethread);
+    c->nb_threads = nb_threads;
+
+    if (nb_threads == 1)
+        return 0;
+    ret = avpriv_slicethread_create(&c->slicethread, c, resample_worker, NULL, nb_threads);
+    if (ret == AVERROR(ENOSYS) || ret == 1) {
+        /* resample in the calling thread */
+        avpriv_slicethread_free(&c->slicethread);
+        return 0;
+    }
+    return FFMIN(ret, 0);
+}
+
 static void resample_free(ResampleContext **cc){
     ResampleContext *c = *cc;
     if(!c)
         return;
+    avpriv_slicethread_free(&c->slicethread);
     av_freep(&c->filter_bank);
     av_freep(cc);
 }
 
 static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_rate, int filter_size, int phase_shift, int linear,
                                     double cutoff0, enum AVSampleFormat format, enum SwrFilterType filter_type, double kaiser_beta,
-                                    double precision, int cheby, int exact_rational)
+                                    double precision, int cheby, int exact_rational, int nb_threads)
 {
     double cutoff = cutoff0? cutoff0 : 0.97;
     double factor= FFMIN(out_rate * cutoff / in_rate, 1.0);
@@ -213,6 +263,7 @@ static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_r
             return NULL;
 
         c->format= format;
+        c->nb_threads = 1;
 
         c->felem_size= av_get_bytes_per_sample(c->format);
 
@@ -270,8 +321,12 @@ static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_r
 
     swri_resample_dsp_init(c);
 
+    if (init_threads(c, nb_threads) < 0)
+        goto error;
+
     return c;
 error:
+    avpriv_slicethread_free(&c->slicethread);
     av_freep(&c->filter_bank);
     av_free(c);
     return NULL;
@@ -363,17 +418,25 @@ static int multiple_resample(ResampleContext *c, AudioData *dst, int dst_size, A
 
         dst_size = FFMAX(FFMIN(dst_size, new_size), 0);
         if (dst_size > 0) {
-            for (i = 0; i < dst->ch_count; i++) {
-                c->dsp.resample_one(dst->ch[i], src->ch[i], dst_size, index2, incr);
-                if (i+1 == dst->ch_count) {
-                    c->index += dst_size * c->dst_incr_div;
-                    c->index += (c->frac + dst_size * (int64_t)c->dst_incr_mod) / c->src_incr;
-                    av_assert2(c->index >= 0);
-                    *consumed = c->index;
-                    c->frac   = (c->frac + dst_size * (int64_t)c->dst_incr_mod) % c->src_incr;
-                    c->index = 0;
-                }
+            if (c->slicethread && dst->ch_count > 1) {
+                ResampleJob job = {
+                    .dst = dst, .src = src, .n = dst_size,
+                    .index2 = index2, .incr = incr,
+                };
+                job.ctx.dsp = c->dsp;
+                c->job = &job;
+                avpriv_slicethread_execute(c->slicethread, dst->ch_count, 0);
+                c->job = NULL;
+            } else {
+                for (i = 0; i < dst->ch_count; i++)
+                    c->dsp.resample_one(dst->ch[i], src->ch[i], dst_size, index2, incr);
             }
+            c->index += dst_size * c->dst_incr_div;
+            c->index += (c->frac + dst_size * (int64_t)c->dst_incr_mod) / c->src_incr;
+            av_assert2(c->index >= 0);
+            *consumed = c->index;
+            c->frac   = (c->frac + dst_size * (int64_t)c->dst_incr_mod) % c->src_incr;
+            c->index = 0;
         }
     } else {
         int64_t end_index = (1LL + src_size - c->filter_length) * c->phase_count;
@@ -388,8 +451,19 @@ static int multiple_resample(ResampleContext *c, AudioData *dst, int dst_size, A
              * when frac and dst_incr_mod are zero */
             resample_func = (c->linear && (c->frac || c->dst_incr_mod)) ?
                             c->dsp.resample_linear : c->dsp.resample_common;
-            for (i = 0; i < dst->ch_count; i++)
-                *consumed = resample_func(c, dst->ch[i], src->ch[i], dst_size, i+1 == dst->ch_count);
+            if (c->slicethread && dst->ch_count > 1) {
+                ResampleJob job = {
+                    .ctx = *c, .dst = dst, .src = src, .n = dst_size,
+                    .resample_func = resample_func,
+                };
+                c->job = &job;
+                avpriv_slicethread_execute(c->slicethread, dst->ch_count, 0);
+                c->job = NULL;
+                *consumed = job.consumed;
+            } else {
+                for (i = 0; i < dst->ch_count; i++)
+                    *consumed = resample_func(c, dst->ch[i], src->ch[i], dst_size, i+1 == dst->ch_count);
+            }
         }
     }
 
@@ -24,6 +24,7 @@
 
 #include "libavutil/log.h"
 #include "libavutil/samplefmt.h"
+#include "libavutil/slicethread.h"
 
 #include "swresample_internal.h"
 
@@ -58,6 +59,12 @@ typedef struct ResampleContext {
         int (*resample_linear)(struct ResampleContext *c, void *dst,
                                const void *src, int n, int update_ctx);
     } dsp;
+
+    /* the x86 asm only knows about the fields up to phase_count, the ones
+     * below can be moved freely */
+    AVSliceThread *slicethread;
+    int nb_threads;
+    struct ResampleJob *job;                    ///< job run by the slice threads
 } ResampleContext;
 
 void swri_resample_dsp_init(ResampleContext *c);
@@ -0,0 +1,166 @@
+/*
+ * Single pass box filter for integer downscaling
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * With the area filter, downscaling by exactly 2 or 4 in both directions
+ * averages blocks of 2x2 or 4x4 source pixels. Doing so directly, with the
+ * range conversion applied to the result, reads every source line once
+ * and writes every destination line once, instead of going through the
+ * horizontal scaler, the ring buffers of intermediate lines and the
+ * vertical scaler.
+ */
+
+#include <math.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libavutil/pixdesc.h"
+#include "swscale.h"
+#include "swscale_internal.h"
+
+#define SCALER_FLAGS (SWS_FAST_BILINEAR | SWS_BILINEAR | SWS_BICUBIC | SWS_X | \
+                      SWS_POINT | SWS_AREA | SWS_BICUBLIN | SWS_GAUSS |        \
+                      SWS_SINC | SWS_LANCZOS | SWS_SPLINE)
+
+static av_always_inline void box_line(uint8_t *dst, const uint8_t *src,
+                                      ptrdiff_t stride, int w, int f,
+                                      const uint8_t *lut)
+{
+    for (int x = 0; x < w; x++) {
+        unsigned sum = 0, v;
+
+        for (int j = 0; j < f; j++)
+            for (int i = 0; i < f; i++)
+                sum += src[j * stride + f * x + i];
+        v = (sum + f * f / 2) / (f * f);
+        dst[x] = lut ? lut[v] : v;
+    }
+}
+
+static void box_plane(uint8_t *dst, ptrdiff_t dst_stride,
+                      const uint8_t *src, ptrdiff_t src_stride,
+                      int w, int h, int f, const uint8_t *lut)
+{
+    for (int y = 0; y < h; y++) {
+        /* separate calls, so that the loops get unrolled and vectorized */
+        if (f == 2) {
+            if (lut)
+                box_line(dst, src, src_stride, w, 2, lut);
+            else
+                box_line(dst, src, src_stride, w, 2, NULL);
+        } else {
+            if (lut)
+                box_line(dst, src, src_stride, w, 4, lut);
+            else
+                box_line(dst, src, src_stride, w, 4, NULL);
+        }
+        dst += dst_stride;
+        src += f * src_stride;
+    }
+}
+
+int ff_sws_box_downscale(SwsContext *c, const uint8_t *src[], int srcStride[],
+                         int dstSliceY, int dstSliceH,
+                         uint8_t *dst[], int dstStride[])
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(c->dstFormat);
+    const int f = c->box_factor;
+
+    for (int i = 0; i < desc->nb_components; i++) {
+        const int plane = desc->comp[i].plane;
+        const int chroma = plane == 1 || plane == 2;
+        const int hsub  = chroma ? c->chrDstHSubSample : 0;
+        const int vsub  = chroma ? c->chrDstVSubSample : 0;
+        const int start = dstSliceY >> vsub;
+        const int end   = AV_CEIL_RSHIFT(dstSliceY + dstSliceH, vsub);
+        const uint8_t *lut = NULL;
+
+        if (c->srcRange != c->dstRange && plane < 3)
+            lut = c->box_range_lut[c->dstRange][chroma];
+
+        box_plane(dst[plane], dstStride[plane],
+                  src[plane] + (ptrdiff_t)f * start * srcStride[plane],
+                  srcStride[plane], AV_CEIL_RSHIFT(c->dstW, hsub),
+                  end - start, f, lut);
+    }
+
+    return dstSliceH;
+}
+
+static av_cold void init_range_lut(uint8_t *lut, int chroma, int to_full)
+{
+    const double scale = chroma ? 255.0 / 224.0 : 255.0 / 219.0;
+    const int    base  = chroma ? 128 : 16;
+    const int    ref   = chroma ? 128 : 0;
+
+    for (int v = 0; v < 256; v++) {
+        if (to_full)
+            lut[v] = av_clip_uint8(lrint((v - base) * scale + ref));
+        else
+            lut[v] = av_clip_uint8(lrint((v - ref) / scale + base));
+    }
+}
+
+static av_cold int chroma_centered(int pos, int chr_subsample)
+{
+    return pos == -1 || pos <= -513 || pos == (128 << chr_subsample) - 128;
+}
+
+av_cold int ff_sws_init_box_downscale(SwsContext *c)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(c->srcFormat);
+    int f;
+
+    c->box_factor = 0;
+
+    if (!c->box_downscale || c->srcFormat != c->dstFormat ||
+        (c->flags & (SCALER_FLAGS | SWS_BITEXACT)) != SWS_AREA ||
+        !(isPlanarYUV(c->srcFormat) || c->srcFormat == AV_PIX_FMT_GRAY8) ||
+        desc->flags & (AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_BITSTREAM |
+                       AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_FLOAT))
+        return 0;
+    for (int i = 0; i < desc->nb_components; i++)
+        if (desc->comp[i].depth != 8 || desc->comp[i].step != 1 ||
+            desc->comp[i].shift || desc->comp[i].offset)
+            return 0;
+
+    /* the box filter matches the area filter only for centered chroma */
+    if (!chroma_centered(c->src_h_chr_pos, c->chrSrcHSubSample) ||
+        !chroma_centered(c->src_v_chr_pos, c->chrSrcVSubSample) ||
+        !chroma_centered(c->dst_h_chr_pos, c->chrDstHSubSample) ||
+        !chroma_centered(c->dst_v_chr_pos, c->chrDstVSubSample))
+        return 0;
+
+    for (f = 2; f <= 4; f *= 2)
+        if (c->srcW    == f * c->dstW    && c->srcH    == f * c->dstH &&
+            c->chrSrcW == f * c->chrDstW && c->chrSrcH == f * c->chrDstH)
+            break;
+    if (f > 4)
+        return 0;
+
+    /* the ranges may still be changed with sws_setColorspaceDetails() */
+    for (int to_full = 0; to_full < 2; to_full++) {
+        init_range_lut(c->box_range_lut[to_full][0], 0, to_full);
+        init_range_lut(c->box_range_lut[to_full][1], 1, to_full);
+    }
+    c->box_factor = f;
+
+    return 1;
+}
@@ -1043,6 +1043,9 @@ static int scale_internal(SwsContext *c,
                                   dst2, dstStride2);
         if (scale_dst)
             dst2[0] += dstSliceY * dstStride2[0];
+    } else if (c->box_factor && srcSliceY_internal == 0 && srcSliceH == c->srcH) {
+        ret = ff_sws_box_downscale(c, src2, srcStride2, dstSliceY, dstSliceH,
+                                   dst2, dstStride2);
     } else {
         ret = swscale(c, src2, srcStride2, srcSliceY_internal, srcSliceH,
                       dst2, dstStride2, dstSliceY, dstSliceH);
@@ -163,6 +163,20 @@ struct SwsContext *sws_alloc_context(void);
 av_warn_unused_result
 int sws_init_context(struct SwsContext *sws_context, SwsFilter *srcFilter, SwsFilter *dstFilter);
 
+/**
+ * Make the context run its slice threads on a thread pool created with
+ * av_thread_pool_alloc(), instead of creating its own threads. The "threads"
+ * option then limits the number of the pool's threads working for this
+ * context at the same time.
+ *
+ * Must be called before sws_init_context().
+ *
+ * @param pool a reference to the pool, a new reference is created; NULL to
+ *             go back to private threads
+ * @return zero on success, a negative AVERROR code on failure
+ */
+int sws_set_thread_pool(struct SwsContext *sws_context, AVBufferRef *pool);
+
 /**
  * Free the swscaler context swsContext.
  * If swsContext is NULL, then does nothing.
@@ -682,6 +682,13 @@ typedef struct SwsContext {
     atomic_int   data_unaligned_warned;
 
     Half2FloatTables *h2f_tables;
+
+    // kept after the fields whose offsets are hardcoded in the asm
+    AVBufferRef *thread_pool;     ///< Thread pool shared with other contexts, set with sws_set_thread_pool().
+    int box_downscale;            ///< User option: allow ff_sws_box_downscale() for 2x and 4x area downscaling.
+    int box_factor;               ///< 2 or 4 if ff_sws_box_downscale() replaces the scaler for whole frames, 0 otherwise.
+    uint8_t box_range_lut[2][2][256]; ///< Range conversion tables for ff_sws_box_downscale(), [to full range][chroma].
+    AVBufferRef *filter_ref[4];   ///< Cache entries holding the hLum, hChr, vLum and vChr filters if they are shared, which must not be modified then.
 } SwsContext;
 //FIXME check init (where 0)
 
@@ -967,6 +974,7 @@ void ff_get_unscaled_swscale(SwsContext *c);
 void ff_get_unscaled_swscale_ppc(SwsContext *c);
 void ff_get_unscaled_swscale_arm(SwsContext *c);
 void ff_get_unscaled_swscale_aarch64(SwsContext *c);
+void ff_get_unscaled_swscale_x86(SwsContext *c);
 
 void ff_sws_init_scale(SwsContext *c);
 
@@ -1016,6 +1024,23 @@ int ff_sws_alphablendaway(SwsContext *c, const uint8_t *src[],
                           int srcStride[], int srcSliceY, int srcSliceH,
                           uint8_t *dst[], int dstStride[]);
 
+/**
+ * Check whether the destination can be computed by averaging blocks of
+ * source pixels, and set up box_factor if so. Only done if the
+ * box_downscale option is set.
+ *
+ * @return 1 if ff_sws_box_downscale() can be used, 0 otherwise
+ */
+int ff_sws_init_box_downscale(SwsContext *c);
+
+/**
+ * Scale the destination lines dstSliceY to dstSliceY + dstSliceH - 1
+ * from the whole source picture, with range conversion.
+ */
+int ff_sws_box_downscale(SwsContext *c, const uint8_t *src[], int srcStride[],
+                         int dstSliceY, int dstSliceH,
+                         uint8_t *dst[], int dstStride[]);
+
 static inline void fillPlane16(uint8_t *plane, int stride, int width, int height, int y,
                                int alpha, int bits, const int big_endian)
 {
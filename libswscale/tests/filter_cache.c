@@ -0,0 +1,123 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Check that contexts with the same scaling parameters share their filters
+ * and produce the same output, and that contexts with other parameters do
+ * not share them.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/imgutils.h"
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+#include "libswscale/swscale.h"
+#include "libswscale/swscale_internal.h"
+
+#define SRC_W 96
+#define SRC_H 72
+
+static SwsContext *alloc_context(int dst_w, int dst_h)
+{
+    return sws_getContext(SRC_W, SRC_H, AV_PIX_FMT_YUV420P,
+                          dst_w, dst_h, AV_PIX_FMT_YUV420P,
+                          SWS_BICUBIC | SWS_ACCURATE_RND | SWS_BITEXACT,
+                          NULL, NULL, NULL);
+}
+
+static int shares_filters(const SwsContext *a, const SwsContext *b)
+{
+    return a->hLumFilter == b->hLumFilter && a->hChrFilter == b->hChrFilter &&
+           a->vLumFilter == b->vLumFilter && a->vChrFilter == b->vChrFilter;
+}
+
+int main(void)
+{
+    uint8_t *src[4], *dst[2][4];
+    int src_stride[4], dst_stride[2][4];
+    SwsContext *c[3] = { NULL };
+    AVLFG lfg;
+    int dst_size, ret = 1;
+
+    src[0] = dst[0][0] = dst[1][0] = NULL;
+
+    if (av_image_alloc(src, src_stride, SRC_W, SRC_H, AV_PIX_FMT_YUV420P, 16) < 0 ||
+        (dst_size = av_image_alloc(dst[0], dst_stride[0], 64, 48, AV_PIX_FMT_YUV420P, 16)) < 0 ||
+        av_image_alloc(dst[1], dst_stride[1], 64, 48, AV_PIX_FMT_YUV420P, 16) < 0) {
+        fprintf(stderr, "Failed to allocate the images\n");
+        goto end;
+    }
+
+    av_lfg_init(&lfg, 1);
+    for (int p = 0; p < 3; p++) {
+        int h = p ? SRC_H / 2 : SRC_H;
+        for (int y = 0; y < h; y++)
+            for (int x = 0; x < src_stride[p]; x++)
+                src[p][y * src_stride[p] + x] = av_lfg_get(&lfg);
+    }
+
+    c[0] = alloc_context(64, 48);
+    c[1] = alloc_context(64, 48);
+    c[2] = alloc_context(48, 36);
+    if (!c[0] || !c[1] || !c[2]) {
+        fprintf(stderr, "Failed to allocate the contexts\n");
+        goto end;
+    }
+
+    if (!shares_filters(c[0], c[1])) {
+        fprintf(stderr, "Contexts with the same parameters do not share their filters\n");
+        goto end;
+    }
+    if (c[0]->hLumFilter == c[2]->hLumFilter || c[0]->vLumFilter == c[2]->vLumFilter) {
+        fprintf(stderr, "Contexts with different parameters share their filters\n");
+        goto end;
+    }
+
+    for (int i = 0; i < 2; i++) {
+        memset(dst[i][0], 0, dst_size);
+        sws_scale(c[i], (const uint8_t * const *)src, src_stride, 0, SRC_H,
+                  dst[i], dst_stride[i]);
+    }
+    if (memcmp(dst[0][0], dst[1][0], dst_size)) {
+        fprintf(stderr, "Contexts sharing their filters give different output\n");
+        goto end;
+    }
+
+    /* the filters of the first context must stay valid for the second one */
+    sws_freeContext(c[0]);
+    c[0] = NULL;
+    memset(dst[1][0], 0, dst_size);
+    sws_scale(c[1], (const uint8_t * const *)src, src_stride, 0, SRC_H,
+              dst[1], dst_stride[1]);
+    if (memcmp(dst[0][0], dst[1][0], dst_size)) {
+        fprintf(stderr, "Output changed after freeing the other context\n");
+        goto end;
+    }
+
+    ret = 0;
+
+end:
+    for (int i = 0; i < 3; i++)
+        sws_freeContext(c[i]);
+    av_freep(&src[0]);
+    av_freep(&dst[0][0]);
+    av_freep(&dst[1][0]);
+    return ret;
+}
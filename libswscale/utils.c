@@ -795,6 +795,185 @@ done:
     return ret;
 }
 
+/*
+ * Filters without source/destination vectors only depend on the scaling
+ * parameters, so they are shared between the contexts using them. The
+ * cache only lists the filters in use: a filter is freed and dropped from
+ * it when its last user releases it. Shared filters are never modified.
+ */
+typedef struct FilterKey {
+    int xInc, srcW, dstW, filterAlign, one, flags, cpu_flags;
+    double param[2];
+    int srcPos, dstPos;
+    /* coefficient shuffling of horizontal filters, 0 for vertical ones */
+    int srcBpc, dstBpc;
+} FilterKey;
+
+typedef struct CachedFilter {
+    FilterKey key;
+    int16_t *filter;
+    int32_t *filterPos;
+    int filterSize;
+    /* number of contexts using the filter, protected by filter_cache_lock */
+    unsigned nb_users;
+    struct CachedFilter *next;
+} CachedFilter;
+
+static AVMutex filter_cache_lock = AV_MUTEX_INITIALIZER;
+static CachedFilter *filter_cache;
+
+static void free_cached_filter(CachedFilter *f)
+{
+    av_free(f->filter);
+    av_free(f->filterPos);
+    av_free(f);
+}
+
+static void filter_cache_release(void *opaque, uint8_t *data)
+{
+    CachedFilter *f = opaque;
+
+    ff_mutex_lock(&filter_cache_lock);
+    if (--f->nb_users) {
+        f = NULL;
+    } else {
+        CachedFilter **p = &filter_cache;
+        while (*p != f)
+            p = &(*p)->next;
+        *p = f->next;
+    }
+    ff_mutex_unlock(&filter_cache_lock);
+
+    if (f)
+        free_cached_filter(f);
+}
+
+/**
+ * Create a reference to a cached filter, adding it to the cache if it is
+ * not listed yet. Must be called with filter_cache_lock held.
+ */
+static AVBufferRef *filter_cache_ref(CachedFilter *f)
+{
+    AVBufferRef *ref = av_buffer_create((uint8_t *)f, sizeof(*f), filter_cache_release,
+                                        f, AV_BUFFER_FLAG_READONLY);
+    if (!ref)
+        return NULL;
+
+    if (!f->nb_users++) {
+        f->next      = filter_cache;
+        filter_cache = f;
+    }
+    return ref;
+}
+
+static CachedFilter *filter_cache_find(const FilterKey *key)
+{
+    for (CachedFilter *f = filter_cache; f; f = f->next)
+        if (!memcmp(&f->key, key, sizeof(*key)))
+            return f;
+    return NULL;
+}
+
+/**
+ * initFilter() with the coefficients of horizontal filters shuffled for
+ * the scaler, taking the result from the filter cache if possible.
+ *
+ * @param ref set to the cache entry the filter belongs to, or NULL if the
+ *            filter is owned by the context
+ */
+static av_cold int init_shared_filter(SwsContext *c, AVBufferRef **ref,
+                                      int16_t **outFilter, int32_t **filterPos,
+                                      int *outFilterSize, int xInc, int srcW,
+                                      int dstW, int filterAlign, int one,
+                                      int flags, int cpu_flags,
+                                      SwsVector *srcFilter, SwsVector *dstFilter,
+                                      double param[2], int srcPos, int dstPos,
+                                      int horizontal)
+{
+    FilterKey key;
+    CachedFilter *f;
+    int ret;
+
+    *ref = NULL;
+
+    if (srcFilter || dstFilter) {
+        ret = initFilter(outFilter, filterPos, outFilterSize, xInc, srcW, dstW,
+                         filterAlign, one, flags, cpu_flags, srcFilter, dstFilter,
+                         param, srcPos, dstPos);
+        if (ret < 0 || !horizontal)
+            return ret;
+        return ff_shuffle_filter_coefficients(c, *filterPos, *outFilterSize,
+                                              *outFilter, dstW);
+    }
+
+    /* padding would make memcmp() unreliable */
+    memset(&key, 0, sizeof(key));
+    key.xInc        = xInc;
+    key.srcW        = srcW;
+    key.dstW        = dstW;
+    key.filterAlign = filterAlign;
+    key.one         = one;
+    key.flags       = flags;
+    key.cpu_flags   = cpu_flags;
+    key.param[0]    = param[0];
+    key.param[1]    = param[1];
+    key.srcPos      = srcPos;
+    key.dstPos      = dstPos;
+    if (horizontal) {
+        key.srcBpc  = c->srcBpc;
+        key.dstBpc  = c->dstBpc;
+    }
+
+    ff_mutex_lock(&filter_cache_lock);
+    f = filter_cache_find(&key);
+    if (f)
+        *ref = filter_cache_ref(f);
+    ff_mutex_unlock(&filter_cache_lock);
+    if (f && !*ref)
+        return AVERROR(ENOMEM);
+
+    if (!f) {
+        CachedFilter *cached;
+
+        f = av_mallocz(sizeof(*f));
+        if (!f)
+            return AVERROR(ENOMEM);
+        f->key = key;
+
+        ret = initFilter(&f->filter, &f->filterPos, &f->filterSize, xInc, srcW,
+                         dstW, filterAlign, one, flags, cpu_flags, NULL, NULL,
+                         param, srcPos, dstPos);
+        if (ret >= 0 && horizontal)
+            ret = ff_shuffle_filter_coefficients(c, f->filterPos, f->filterSize,
+                                                 f->filter, dstW);
+        if (ret < 0) {
+            free_cached_filter(f);
+            return ret;
+        }
+
+        /* another context may have added the same filter meanwhile */
+        ff_mutex_lock(&filter_cache_lock);
+        cached = filter_cache_find(&key);
+        if (cached) {
+            free_cached_filter(f);
+            f = cached;
+        }
+        *ref = filter_cache_ref(f);
+        ff_mutex_unlock(&filter_cache_lock);
+        if (!*ref) {
+            if (!cached)
+                free_cached_filter(f);
+            return AVERROR(ENOMEM);
+        }
+    }
+
+    *outFilter     = f->filter;
+    *filterPos     = f->filterPos;
+    *outFilterSize = f->filterSize;
+
+    return 0;
+}
+
 static void fill_rgb2yuv_table(SwsContext *c, const int table[4], int dstRange)
 {
     int64_t W, V, Z, Cy, Cu, Cv;
@@ -1741,6 +1920,12 @@ static av_cold int sws_init_single_context(SwsContext *c, SwsFilter *srcFilter,
         }
     }
 
+    /* the filters are still needed for scaling slices */
+    if (!unscaled && !usesHFilter && !usesVFilter &&
+        ff_sws_init_box_downscale(c) && (flags & SWS_PRINT_INFO))
+        av_log(c, AV_LOG_INFO, "using %dx box downscaler for %s\n",
+               c->box_factor, av_get_pix_fmt_name(srcFormat));
+
 #if HAVE_MMAP && HAVE_MPROTECT && defined(MAP_ANONYMOUS)
 #define USE_MMAP 1
 #else
@@ -1818,28 +2003,26 @@ static av_cold int sws_init_single_context(SwsContext *c, SwsFilter *srcFilter,
                                     have_lsx(cpu_flags)    ? 8 :
                                     have_lasx(cpu_flags)   ? 8 : 1;
 
-            if ((ret = initFilter(&c->hLumFilter, &c->hLumFilterPos,
+            if ((ret = init_shared_filter(c, &c->filter_ref[0],
+                           &c->hLumFilter, &c->hLumFilterPos,
                            &c->hLumFilterSize, c->lumXInc,
                            srcW, dstW, filterAlign, 1 << 14,
                            (flags & SWS_BICUBLIN) ? (flags | SWS_BICUBIC) : flags,
                            cpu_flags, srcFilter->lumH, dstFilter->lumH,
                            c->param,
                            get_local_pos(c, 0, 0, 0),
-                           get_local_pos(c, 0, 0, 0))) < 0)
+                           get_local_pos(c, 0, 0, 0), 1)) < 0)
                 goto fail;
-            if (ff_shuffle_filter_coefficients(c, c->hLumFilterPos, c->hLumFilterSize, c->hLumFilter, dstW) < 0)
-                goto nomem;
-            if ((ret = initFilter(&c->hChrFilter, &c->hChrFilterPos,
+            if ((ret = init_shared_filter(c, &c->filter_ref[1],
+                           &c->hChrFilter, &c->hChrFilterPos,
                            &c->hChrFilterSize, c->chrXInc,
                            c->chrSrcW, c->chrDstW, filterAlign, 1 << 14,
                            (flags & SWS_BICUBLIN) ? (flags | SWS_BILINEAR) : flags,
                            cpu_flags, srcFilter->chrH, dstFilter->chrH,
                            c->param,
                            get_local_pos(c, c->chrSrcHSubSample, c->src_h_chr_pos, 0),
-                           get_local_pos(c, c->chrDstHSubSample, c->dst_h_chr_pos, 0))) < 0)
+                           get_local_pos(c, c->chrDstHSubSample, c->dst_h_chr_pos, 0), 1)) < 0)
                 goto fail;
-            if (ff_shuffle_filter_coefficients(c, c->hChrFilterPos, c->hChrFilterSize, c->hChrFilter, c->chrDstW) < 0)
-                goto nomem;
         }
     } // initialize horizontal stuff
 
@@ -1849,22 +2032,24 @@ static av_cold int sws_init_single_context(SwsContext *c, SwsFilter *srcFilter,
                                 PPC_ALTIVEC(cpu_flags) ? 8 :
                                 have_neon(cpu_flags)   ? 2 : 1;
 
-        if ((ret = initFilter(&c->vLumFilter, &c->vLumFilterPos, &c->vLumFilterSize,
+        if ((ret = init_shared_filter(c, &c->filter_ref[2],
+                       &c->vLumFilter, &c->vLumFilterPos, &c->vLumFilterSize,
                        c->lumYInc, srcH, dstH, filterAlign, (1 << 12),
                        (flags & SWS_BICUBLIN) ? (flags | SWS_BICUBIC) : flags,
                        cpu_flags, srcFilter->lumV, dstFilter->lumV,
                        c->param,
                        get_local_pos(c, 0, 0, 1),
-                       get_local_pos(c, 0, 0, 1))) < 0)
+                       get_local_pos(c, 0, 0, 1), 0)) < 0)
             goto fail;
-        if ((ret = initFilter(&c->vChrFilter, &c->vChrFilterPos, &c->vChrFilterSize,
+        if ((ret = init_shared_filter(c, &c->filter_ref[3],
+                       &c->vChrFilter, &c->vChrFilterPos, &c->vChrFilterSize,
                        c->chrYInc, c->chrSrcH, c->chrDstH,
                        filterAlign, (1 << 12),
                        (flags & SWS_BICUBLIN) ? (flags | SWS_BILINEAR) : flags,
                        cpu_flags, srcFilter->chrV, dstFilter->chrV,
                        c->param,
                        get_local_pos(c, c->chrSrcVSubSample, c->src_v_chr_pos, 1),
-                       get_local_pos(c, c->chrDstVSubSample, c->dst_v_chr_pos, 1))) < 0)
+                       get_local_pos(c, c->chrDstVSubSample, c->dst_v_chr_pos, 1), 0)) < 0)
 
             goto fail;
 
@@ -1984,13 +2169,23 @@ fail: // FIXME replace things by appropriate error codes
     return ret;
 }
 
+int sws_set_thread_pool(SwsContext *c, AVBufferRef *pool)
+{
+    av_buffer_unref(&c->thread_pool);
+    if (!pool)
+        return 0;
+
+    c->thread_pool = av_buffer_ref(pool);
+    return c->thread_pool ? 0 : AVERROR(ENOMEM);
+}
+
 static int context_init_threaded(SwsContext *c,
                                  SwsFilter *src_filter, SwsFilter *dst_filter)
 {
     int ret;
 
-    ret = avpriv_slicethread_create(&c->slicethread, (void*)c,
-                                    ff_sws_slice_worker, NULL, c->nb_threads);
+    ret = avpriv_slicethread_create_shared(&c->slicethread, c->thread_pool, (void*)c,
+                                           ff_sws_slice_worker, NULL, c->nb_threads);
     if (ret == AVERROR(ENOSYS)) {
         c->nb_threads = 1;
         return 0;
@@ -2434,6 +2629,7 @@ void sws_freeContext(SwsContext *c)
     av_freep(&c->slice_err);
 
     avpriv_slicethread_free(&c->slicethread);
+    av_buffer_unref(&c->thread_pool);
 
     for (i = 0; i < 4; i++)
         av_freep(&c->dither_error[i]);
@@ -2443,6 +2639,26 @@ void sws_freeContext(SwsContext *c)
 
     av_freep(&c->src_ranges.ranges);
 
+    /* shared filters are freed with their last reference */
+    if (c->filter_ref[0]) {
+        c->hLumFilter    = NULL;
+        c->hLumFilterPos = NULL;
+    }
+    if (c->filter_ref[1]) {
+        c->hChrFilter    = NULL;
+        c->hChrFilterPos = NULL;
+    }
+    if (c->filter_ref[2]) {
+        c->vLumFilter    = NULL;
+        c->vLumFilterPos = NULL;
+    }
+    if (c->filter_ref[3]) {
+        c->vChrFilter    = NULL;
+        c->vChrFilterPos = NULL;
+    }
+    for (i = 0; i < FF_ARRAY_ELEMS(c->filter_ref); i++)
+        av_buffer_unref(&c->filter_ref[i]);
+
     av_freep(&c->vLumFilter);
     av_freep(&c->vChrFilter);
     av_freep(&c->hLumFilter);
@@ -0,0 +1,345 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdint.h>
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/avassert.h"
+#include "libavutil/cpu.h"
+#include "libavutil/pixdesc.h"
+#include "libavutil/x86/cpu.h"
+#include "libswscale/swscale.h"
+#include "libswscale/swscale_internal.h"
+
+/* The kernels convert a multiple of this many pixels per line. */
+#define SIMD_STEP 32
+
+typedef void (*shift_words_fn)(uint16_t *dst, const uint16_t *src, int shift, int w);
+typedef void (*interleave_words_fn)(uint16_t *dst, const uint16_t *u,
+                                    const uint16_t *v, int shift, int w);
+typedef void (*deinterleave_words_fn)(uint16_t *u, uint16_t *v,
+                                      const uint16_t *src, int shift, int w);
+typedef void (*planar_rgb_to_packed32_fn)(uint8_t *dst, const uint8_t *src0,
+                                          const uint8_t *src1,
+                                          const uint8_t *src2, int w);
+typedef void (*planar_rgba_to_packed32_fn)(uint8_t *dst, const uint8_t *src0,
+                                           const uint8_t *src1,
+                                           const uint8_t *src2,
+                                           const uint8_t *src3, int w);
+typedef void (*packed32_to_planar_rgb_fn)(uint8_t *dst0, uint8_t *dst1,
+                                          uint8_t *dst2, const uint8_t *src,
+                                          int w);
+
+#define DECLARE_FUNCS(opt)                                                             \
+void ff_p01x_luma_from_planar_##opt(uint16_t *dst, const uint16_t *src,                \
+                                    int shift, int w);                                 \
+void ff_p01x_luma_to_planar_##opt(uint16_t *dst, const uint16_t *src,                  \
+                                  int shift, int w);                                   \
+void ff_p01x_chroma_from_planar_##opt(uint16_t *dst, const uint16_t *u,                \
+                                      const uint16_t *v, int shift, int w);            \
+void ff_p01x_chroma_to_planar_##opt(uint16_t *u, uint16_t *v,                          \
+                                    const uint16_t *src, int shift, int w);            \
+void ff_planar_rgb_to_rgbx_##opt(uint8_t *dst, const uint8_t *src0,                    \
+                                 const uint8_t *src1, const uint8_t *src2, int w);     \
+void ff_planar_rgb_to_xrgb_##opt(uint8_t *dst, const uint8_t *src0,                    \
+                                 const uint8_t *src1, const uint8_t *src2, int w);     \
+void ff_planar_rgba_to_rgba_##opt(uint8_t *dst, const uint8_t *src0,                   \
+                                  const uint8_t *src1, const uint8_t *src2,            \
+                                  const uint8_t *src3, int w);                         \
+void ff_planar_rgba_to_argb_##opt(uint8_t *dst, const uint8_t *src0,                   \
+                                  const uint8_t *src1, const uint8_t *src2,            \
+                                  const uint8_t *src3, int w);                         \
+void ff_packed32_to_planar_rgbx_##opt(uint8_t *dst0, uint8_t *dst1, uint8_t *dst2,     \
+                                      const uint8_t *src, int w);                      \
+void ff_packed32_to_planar_xrgb_##opt(uint8_t *dst0, uint8_t *dst1, uint8_t *dst2,     \
+                                      const uint8_t *src, int w);
+
+DECLARE_FUNCS(sse2)
+DECLARE_FUNCS(avx2)
+
+static av_always_inline int
+planar_to_p01x(SwsContext *c, const uint8_t *src8[], int srcStride[],
+               int srcSliceY, int srcSliceH, uint8_t *dstParam8[],
+               int dstStride[], shift_words_fn shift_luma,
+               interleave_words_fn interleave_chroma)
+{
+    const AVPixFmtDescriptor *src_format = av_pix_fmt_desc_get(c->srcFormat);
+    const AVPixFmtDescriptor *dst_format = av_pix_fmt_desc_get(c->dstFormat);
+    const uint16_t *srcY = (const uint16_t*)src8[0];
+    const uint16_t *srcU = (const uint16_t*)src8[1];
+    const uint16_t *srcV = (const uint16_t*)src8[2];
+    uint16_t *dstY  = (uint16_t*)(dstParam8[0] + dstStride[0] * srcSliceY);
+    uint16_t *dstUV = (uint16_t*)(dstParam8[1] + dstStride[1] * srcSliceY / 2);
+    const int w       = c->srcW;
+    const int chrW    = c->srcW / 2;
+    const int wSimd   = w    & ~(SIMD_STEP - 1);
+    const int chrSimd = chrW & ~(SIMD_STEP - 1);
+    const int shift   = dst_format->comp[0].depth + dst_format->comp[0].shift -
+                        src_format->comp[0].depth - src_format->comp[0].shift;
+    int x, y;
+
+    av_assert0(!(srcStride[0] % 2 || srcStride[1] % 2 || srcStride[2] % 2 ||
+                 dstStride[0] % 2 || dstStride[1] % 2));
+
+    for (y = 0; y < srcSliceH; y++) {
+        if (wSimd)
+            shift_luma(dstY, srcY, shift, wSimd);
+        for (x = wSimd; x < w; x++)
+            dstY[x] = srcY[x] << shift;
+        srcY += srcStride[0] / 2;
+        dstY += dstStride[0] / 2;
+
+        if (!(y & 1)) {
+            if (chrSimd)
+                interleave_chroma(dstUV, srcU, srcV, shift, chrSimd);
+            for (x = chrSimd; x < chrW; x++) {
+                dstUV[2 * x]     = srcU[x] << shift;
+                dstUV[2 * x + 1] = srcV[x] << shift;
+            }
+            srcU  += srcStride[1] / 2;
+            srcV  += srcStride[2] / 2;
+            dstUV += dstStride[1] / 2;
+        }
+    }
+
+    return srcSliceH;
+}
+
+static av_always_inline int
+p01x_to_planar(SwsContext *c, const uint8_t *src8[], int srcStride[],
+               int srcSliceY, int srcSliceH, uint8_t *dstParam8[],
+               int dstStride[], shift_words_fn shift_luma,
+               deinterleave_words_fn deinterleave_chroma)
+{
+    const AVPixFmtDescriptor *src_format = av_pix_fmt_desc_get(c->srcFormat);
+    const AVPixFmtDescriptor *dst_format = av_pix_fmt_desc_get(c->dstFormat);
+    const uint16_t *srcY  = (const uint16_t*)src8[0];
+    const uint16_t *srcUV = (const uint16_t*)src8[1];
+    uint16_t *dstY = (uint16_t*)(dstParam8[0] + dstStride[0] * srcSliceY);
+    uint16_t *dstU = (uint16_t*)(dstParam8[1] + dstStride[1] * srcSliceY / 2);
+    uint16_t *dstV = (uint16_t*)(dstParam8[2] + dstStride[2] * srcSliceY / 2);
+    const int w       = c->srcW;
+    const int chrW    = AV_CEIL_RSHIFT(c->srcW, 1);
+    const int wSimd   = w    & ~(SIMD_STEP - 1);
+    const int chrSimd = chrW & ~(SIMD_STEP - 1);
+    const int shift   = src_format->comp[0].depth + src_format->comp[0].shift -
+                        dst_format->comp[0].depth - dst_format->comp[0].shift;
+    int x, y;
+
+    av_assert0(!(srcStride[0] % 2 || srcStride[1] % 2 ||
+                 dstStride[0] % 2 || dstStride[1] % 2 || dstStride[2] % 2));
+
+    for (y = 0; y < srcSliceH; y++) {
+        if (wSimd)
+            shift_luma(dstY, srcY, shift, wSimd);
+        for (x = wSimd; x < w; x++)
+            dstY[x] = srcY[x] >> shift;
+        srcY += srcStride[0] / 2;
+        dstY += dstStride[0] / 2;
+
+        if (!(y & 1)) {
+            if (chrSimd)
+                deinterleave_chroma(dstU, dstV, srcUV, shift, chrSimd);
+            for (x = chrSimd; x < chrW; x++) {
+                dstU[x] = srcUV[2 * x]     >> shift;
+                dstV[x] = srcUV[2 * x + 1] >> shift;
+            }
+            srcUV += srcStride[1] / 2;
+            dstU  += dstStride[1] / 2;
+            dstV  += dstStride[2] / 2;
+        }
+    }
+
+    return srcSliceH;
+}
+
+/* indices of the G, B, R planes in the order of the packed components */
+static const int order201[] = { 2, 0, 1 }, order102[] = { 1, 0, 2 };
+
+static av_always_inline int
+planar_rgb_to_packed32(SwsContext *c, const uint8_t *src[], int srcStride[],
+                       int srcSliceY, int srcSliceH, uint8_t *dst[],
+                       int dstStride[], planar_rgb_to_packed32_fn rgbx,
+                       planar_rgb_to_packed32_fn xrgb,
+                       planar_rgba_to_packed32_fn rgba,
+                       planar_rgba_to_packed32_fn argb)
+{
+    /* gray is expanded like planar RGB with the same plane three times */
+    const int gray  = c->srcFormat == AV_PIX_FMT_GRAY8;
+    const int alpha = c->srcFormat == AV_PIX_FMT_GBRAP;
+    const int *order = c->dstFormat == AV_PIX_FMT_RGBA ||
+                       c->dstFormat == AV_PIX_FMT_ARGB ? order201 : order102;
+    const int alpha_first = c->dstFormat == AV_PIX_FMT_ARGB ||
+                            c->dstFormat == AV_PIX_FMT_ABGR;
+    const uint8_t *src0 = src[gray ? 0 : order[0]];
+    const uint8_t *src1 = src[gray ? 0 : order[1]];
+    const uint8_t *src2 = src[gray ? 0 : order[2]];
+    const uint8_t *src3 = src[3];
+    const int stride0 = srcStride[gray ? 0 : order[0]];
+    const int stride1 = srcStride[gray ? 0 : order[1]];
+    const int stride2 = srcStride[gray ? 0 : order[2]];
+    uint8_t *dest = dst[0] + srcSliceY * dstStride[0];
+    const int w     = c->srcW;
+    const int wSimd = w & ~(SIMD_STEP - 1);
+    int x, y;
+
+    for (y = 0; y < srcSliceH; y++) {
+        uint8_t *d = dest + 4 * wSimd;
+
+        if (wSimd && alpha)
+            (alpha_first ? argb : rgba)(dest, src0, src1, src2, src3, wSimd);
+        else if (wSimd)
+            (alpha_first ? xrgb : rgbx)(dest, src0, src1, src2, wSimd);
+        for (x = wSimd; x < w; x++) {
+            if (alpha_first)
+                *d++ = alpha ? src3[x] : 0xff;
+            *d++ = src0[x];
+            *d++ = src1[x];
+            *d++ = src2[x];
+            if (!alpha_first)
+                *d++ = alpha ? src3[x] : 0xff;
+        }
+        src0 += stride0;
+        src1 += stride1;
+        src2 += stride2;
+        if (alpha)
+            src3 += srcStride[3];
+        dest += dstStride[0];
+    }
+
+    return srcSliceH;
+}
+
+static av_always_inline int
+packed32_to_planar_rgb(SwsContext *c, const uint8_t *src[], int srcStride[],
+                       int srcSliceY, int srcSliceH, uint8_t *dst[],
+                       int dstStride[], packed32_to_planar_rgb_fn rgbx,
+                       packed32_to_planar_rgb_fn xrgb)
+{
+    const int *order = c->srcFormat == AV_PIX_FMT_RGBA ||
+                       c->srcFormat == AV_PIX_FMT_ARGB ? order201 : order102;
+    const int alpha_first = c->srcFormat == AV_PIX_FMT_ARGB ||
+                            c->srcFormat == AV_PIX_FMT_ABGR;
+    uint8_t *dst0 = dst[order[0]] + srcSliceY * dstStride[order[0]];
+    uint8_t *dst1 = dst[order[1]] + srcSliceY * dstStride[order[1]];
+    uint8_t *dst2 = dst[order[2]] + srcSliceY * dstStride[order[2]];
+    const uint8_t *s = src[0];
+    const int w     = c->srcW;
+    const int wSimd = w & ~(SIMD_STEP - 1);
+    int x, y;
+
+    for (y = 0; y < srcSliceH; y++) {
+        const uint8_t *p = s + 4 * wSimd + alpha_first;
+
+        if (wSimd)
+            (alpha_first ? xrgb : rgbx)(dst0, dst1, dst2, s, wSimd);
+        for (x = wSimd; x < w; x++, p += 4) {
+            dst0[x] = p[0];
+            dst1[x] = p[1];
+            dst2[x] = p[2];
+        }
+        s    += srcStride[0];
+        dst0 += dstStride[order[0]];
+        dst1 += dstStride[order[1]];
+        dst2 += dstStride[order[2]];
+    }
+
+    return srcSliceH;
+}
+
+#define WRAPPERS(opt)                                                                  \
+static int planar_to_p01x_##opt(SwsContext *c, const uint8_t *src[],                   \
+                                int srcStride[], int srcSliceY, int srcSliceH,         \
+                                uint8_t *dst[], int dstStride[])                       \
+{                                                                                      \
+    return planar_to_p01x(c, src, srcStride, srcSliceY, srcSliceH, dst, dstStride,     \
+                          ff_p01x_luma_from_planar_##opt,                              \
+                          ff_p01x_chroma_from_planar_##opt);                           \
+}                                                                                      \
+                                                                                       \
+static int p01x_to_planar_##opt(SwsContext *c, const uint8_t *src[],                   \
+                                int srcStride[], int srcSliceY, int srcSliceH,         \
+                                uint8_t *dst[], int dstStride[])                       \
+{                                                                                      \
+    return p01x_to_planar(c, src, srcStride, srcSliceY, srcSliceH, dst, dstStride,     \
+                          ff_p01x_luma_to_planar_##opt,                                \
+                          ff_p01x_chroma_to_planar_##opt);                             \
+}                                                                                      \
+                                                                                       \
+static int planar_rgb_to_packed32_##opt(SwsContext *c, const uint8_t *src[],           \
+                                        int srcStride[], int srcSliceY,                \
+                                        int srcSliceH, uint8_t *dst[],                 \
+                                        int dstStride[])                               \
+{                                                                                      \
+    return planar_rgb_to_packed32(c, src, srcStride, srcSliceY, srcSliceH,             \
+                                  dst, dstStride, ff_planar_rgb_to_rgbx_##opt,         \
+                                  ff_planar_rgb_to_xrgb_##opt,                         \
+                                  ff_planar_rgba_to_rgba_##opt,                        \
+                                  ff_planar_rgba_to_argb_##opt);                       \
+}                                                                                      \
+                                                                                       \
+static int packed32_to_planar_rgb_##opt(SwsContext *c, const uint8_t *src[],           \
+                                        int srcStride[], int srcSliceY,                \
+                                        int srcSliceH, uint8_t *dst[],                 \
+                                        int dstStride[])                               \
+{                                                                                      \
+    return packed32_to_planar_rgb(c, src, srcStride, srcSliceY, srcSliceH,             \
+                                  dst, dstStride, ff_packed32_to_planar_rgbx_##opt,    \
+                                  ff_packed32_to_planar_xrgb_##opt);                   \
+}
+
+WRAPPERS(sse2)
+WRAPPERS(avx2)
+
+#define IS_PACKED32(f) ((f) == AV_PIX_FMT_RGBA || (f) == AV_PIX_FMT_ARGB ||             \
+                        (f) == AV_PIX_FMT_BGRA || (f) == AV_PIX_FMT_ABGR)
+
+#define ASSIGN_UNSCALED_FUNCS(opt) do {                                                \
+    if ((srcFormat == AV_PIX_FMT_YUV420P10 || srcFormat == AV_PIX_FMT_YUVA420P10 ||    \
+         srcFormat == AV_PIX_FMT_YUV420P12 ||                                          \
+         srcFormat == AV_PIX_FMT_YUV420P14 ||                                          \
+         srcFormat == AV_PIX_FMT_YUV420P16 || srcFormat == AV_PIX_FMT_YUVA420P16) &&   \
+        (dstFormat == AV_PIX_FMT_P010 || dstFormat == AV_PIX_FMT_P016))                \
+        c->convert_unscaled = planar_to_p01x_##opt;                                    \
+    if ((srcFormat == AV_PIX_FMT_P010 && dstFormat == AV_PIX_FMT_YUV420P10) ||         \
+        (srcFormat == AV_PIX_FMT_P012 && dstFormat == AV_PIX_FMT_YUV420P12) ||         \
+        (srcFormat == AV_PIX_FMT_P016 && dstFormat == AV_PIX_FMT_YUV420P16))           \
+        c->convert_unscaled = p01x_to_planar_##opt;                                    \
+    if ((srcFormat == AV_PIX_FMT_GBRP || srcFormat == AV_PIX_FMT_GBRAP ||              \
+         srcFormat == AV_PIX_FMT_GRAY8) && IS_PACKED32(dstFormat))                     \
+        c->convert_unscaled = planar_rgb_to_packed32_##opt;                            \
+    if (IS_PACKED32(srcFormat) && dstFormat == AV_PIX_FMT_GBRP)                        \
+        c->convert_unscaled = packed32_to_planar_rgb_##opt;                            \
+} while (0)
+
+av_cold void ff_get_unscaled_swscale_x86(SwsContext *c)
+{
+    const enum AVPixelFormat srcFormat = c->srcFormat;
+    const enum AVPixelFormat dstFormat = c->dstFormat;
+    int cpu_flags = av_get_cpu_flags();
+
+    /* only replace the C converters for the same pairs */
+    if (!c->convert_unscaled)
+        return;
+
+    if (EXTERNAL_SSE2(cpu_flags))
+        ASSIGN_UNSCALED_FUNCS(sse2);
+    if (EXTERNAL_AVX2_FAST(cpu_flags))
+        ASSIGN_UNSCALED_FUNCS(avx2);
+}
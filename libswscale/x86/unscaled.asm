@@ -0,0 +1,280 @@
+;******************************************************************************
+;* SIMD kernels for unscaled pixel format conversions
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+; dword order of the transposed components in the AVX2 lanes
+packed32_perm: dd 0, 4, 1, 5, 2, 6, 3, 7
+
+SECTION .text
+
+; All the functions below process a multiple of 32 elements, the callers
+; convert the rest of the line.
+
+;------------------------------------------------------------------------------
+; p01x_luma_from_planar(uint16_t *dst, const uint16_t *src, int shift, int w)
+; p01x_luma_to_planar(uint16_t *dst, const uint16_t *src, int shift, int w)
+;------------------------------------------------------------------------------
+%macro SHIFT_WORDS 2 ; name, shift instruction
+cglobal p01x_luma_%1, 4, 4, 3, dst, src, shift, w
+    movd            xm2, shiftd
+    movsxdifnidn      wq, wd
+    add               wq, wq
+    add             dstq, wq
+    add             srcq, wq
+    neg               wq
+.loop:
+    movu              m0, [srcq + wq]
+    movu              m1, [srcq + wq + mmsize]
+    %2                m0, xm2
+    %2                m1, xm2
+    movu   [dstq + wq], m0
+    movu   [dstq + wq + mmsize], m1
+    add               wq, 2 * mmsize
+    jl .loop
+    RET
+%endmacro
+
+;------------------------------------------------------------------------------
+; p01x_chroma_from_planar(uint16_t *dst, const uint16_t *u, const uint16_t *v,
+;                         int shift, int w)
+;------------------------------------------------------------------------------
+%macro P01X_CHROMA_FROM_PLANAR 0
+cglobal p01x_chroma_from_planar, 5, 5, 5, dst, u, v, shift, w
+    movd            xm4, shiftd
+    movsxdifnidn      wq, wd
+    add               wq, wq
+    add               uq, wq
+    add               vq, wq
+    lea             dstq, [dstq + 2 * wq]
+    neg               wq
+.loop:
+%if cpuflag(avx2)
+    ; reorder the quadwords so that the in-lane unpacks give pixels in order
+    vpermq            m0, [uq + wq], q3120
+    vpermq            m1, [vq + wq], q3120
+%else
+    movu              m0, [uq + wq]
+    movu              m1, [vq + wq]
+%endif
+    psllw             m0, xm4
+    psllw             m1, xm4
+    punpckhwd         m2, m0, m1
+    punpcklwd         m0, m1
+    movu   [dstq + 2 * wq], m0
+    movu   [dstq + 2 * wq + mmsize], m2
+    add               wq, mmsize
+    jl .loop
+    RET
+%endmacro
+
+;------------------------------------------------------------------------------
+; p01x_chroma_to_planar(uint16_t *u, uint16_t *v, const uint16_t *src,
+;                       int shift, int w)
+;------------------------------------------------------------------------------
+%macro P01X_CHROMA_TO_PLANAR 0
+cglobal p01x_chroma_to_planar, 5, 5, 4, u, v, src, shift, w
+    movd            xm3, shiftd
+    movsxdifnidn      wq, wd
+    add               wq, wq
+    add               uq, wq
+    add               vq, wq
+    lea             srcq, [srcq + 2 * wq]
+    neg               wq
+.loop:
+    movu              m0, [srcq + 2 * wq]
+    movu              m1, [srcq + 2 * wq + mmsize]
+    psrlw             m0, xm3
+    psrlw             m1, xm3
+    ; u0 v0 u1 v1 u2 v2 u3 v3 -> u0 u1 u2 u3 v0 v1 v2 v3
+    pshuflw           m0, m0, q3120
+    pshufhw           m0, m0, q3120
+    pshufd            m0, m0, q3120
+    pshuflw           m1, m1, q3120
+    pshufhw           m1, m1, q3120
+    pshufd            m1, m1, q3120
+    punpckhqdq        m2, m0, m1
+    punpcklqdq        m0, m1
+%if cpuflag(avx2)
+    vpermq            m0, m0, q3120
+    vpermq            m2, m2, q3120
+%endif
+    movu      [uq + wq], m0
+    movu      [vq + wq], m2
+    add               wq, mmsize
+    jl .loop
+    RET
+%endmacro
+
+;------------------------------------------------------------------------------
+; planar_rgb_to_rgbx(uint8_t *dst, const uint8_t *src0, const uint8_t *src1,
+;                    const uint8_t *src2, int w)
+; planar_rgb_to_xrgb(...)
+; planar_rgba_to_rgba(uint8_t *dst, const uint8_t *src0, const uint8_t *src1,
+;                     const uint8_t *src2, const uint8_t *src3, int w)
+; planar_rgba_to_argb(...)
+;
+; Interleave three planes into 32-bit pixels, with the fourth byte set to
+; 0xff, or taken from a fourth plane for rgba and argb. The fourth byte is
+; last for rgbx and rgba, and first for xrgb and argb.
+;------------------------------------------------------------------------------
+%macro PLANAR_RGB_TO_PACKED32 3 ; name, alpha first, alpha plane
+%if %3
+cglobal planar_rgba_to_%1, 6, 6, 8, dst, src0, src1, src2, src3, w
+%else
+cglobal planar_rgb_to_%1, 5, 5, 8, dst, src0, src1, src2, w
+    pcmpeqb           m7, m7
+%endif
+    movsxdifnidn      wq, wd
+    add            src0q, wq
+    add            src1q, wq
+    add            src2q, wq
+%if %3
+    add            src3q, wq
+%endif
+    lea             dstq, [dstq + 4 * wq]
+    neg               wq
+.loop:
+%if %3
+    movu              m7, [src3q + wq]
+%endif
+    movu              m0, [src0q + wq]
+    movu              m1, [src1q + wq]
+    movu              m2, [src2q + wq]
+%if %2
+    punpckhbw         m3, m7, m0
+    punpcklbw         m4, m7, m0
+    punpckhbw         m5, m1, m2
+    punpcklbw         m6, m1, m2
+%else
+    punpckhbw         m3, m0, m1
+    punpcklbw         m4, m0, m1
+    punpckhbw         m5, m2, m7
+    punpcklbw         m6, m2, m7
+%endif
+    punpckhwd         m0, m4, m6 ; pixels 4-7
+    punpcklwd         m4, m6     ; pixels 0-3
+    punpckhwd         m1, m3, m5 ; pixels 12-15
+    punpcklwd         m3, m5     ; pixels 8-11
+%if cpuflag(avx2)
+    ; the upper lanes hold pixels 16-31
+    vperm2i128        m2, m4, m0, 0x20
+    vperm2i128        m4, m4, m0, 0x31
+    vperm2i128        m0, m3, m1, 0x20
+    vperm2i128        m3, m3, m1, 0x31
+    movu   [dstq + 4 * wq], m2
+    movu   [dstq + 4 * wq + 32], m0
+    movu   [dstq + 4 * wq + 64], m4
+    movu   [dstq + 4 * wq + 96], m3
+%else
+    movu   [dstq + 4 * wq], m4
+    movu   [dstq + 4 * wq + 16], m0
+    movu   [dstq + 4 * wq + 32], m3
+    movu   [dstq + 4 * wq + 48], m1
+%endif
+    add               wq, mmsize
+    jl .loop
+    RET
+%endmacro
+
+;------------------------------------------------------------------------------
+; packed32_to_planar_rgbx(uint8_t *dst0, uint8_t *dst1, uint8_t *dst2,
+;                         const uint8_t *src, int w)
+; packed32_to_planar_xrgb(...)
+;
+; Split 32-bit pixels into three planes, dropping the fourth byte, which is
+; last for rgbx and first for xrgb.
+;------------------------------------------------------------------------------
+%macro PACKED32_TO_PLANAR_RGB 2 ; name, alpha first
+cglobal packed32_to_planar_%1, 5, 5, 7, dst0, dst1, dst2, src, w
+%if cpuflag(avx2)
+    mova              m6, [packed32_perm]
+%endif
+    movsxdifnidn      wq, wd
+    add            dst0q, wq
+    add            dst1q, wq
+    add            dst2q, wq
+    lea             srcq, [srcq + 4 * wq]
+    neg               wq
+.loop:
+    movu              m0, [srcq + 4 * wq]
+    movu              m1, [srcq + 4 * wq + mmsize]
+    movu              m2, [srcq + 4 * wq + 2 * mmsize]
+    movu              m3, [srcq + 4 * wq + 3 * mmsize]
+    ; transpose the 4x4 bytes of each group of four pixels, in three rounds
+    ; of byte interleaving, starting from pixels 0-3, 4-7, 8-11 and 12-15
+    punpckhbw         m4, m0, m1 ; 2 6 3 7
+    punpcklbw         m0, m1     ; 0 4 1 5
+    punpckhbw         m5, m2, m3 ; 10 14 11 15
+    punpcklbw         m2, m3     ; 8 12 9 13
+    punpckhbw         m1, m0, m4 ; 1 3 5 7
+    punpcklbw         m0, m4     ; 0 2 4 6
+    punpckhbw         m3, m2, m5 ; 9 11 13 15
+    punpcklbw         m2, m5     ; 8 10 12 14
+    punpckhbw         m4, m0, m1 ; components 2, 3 of pixels 0-7
+    punpcklbw         m0, m1     ; components 0, 1 of pixels 0-7
+    punpckhbw         m5, m2, m3 ; components 2, 3 of pixels 8-15
+    punpcklbw         m2, m3     ; components 0, 1 of pixels 8-15
+    ; gather the three kept components in m1, m3 and m4
+%if %2
+    punpckhqdq        m1, m0, m2
+    punpcklqdq        m3, m4, m5
+    punpckhqdq        m4, m5
+%else
+    punpcklqdq        m1, m0, m2
+    punpckhqdq        m3, m0, m2
+    punpcklqdq        m4, m5
+%endif
+%if cpuflag(avx2)
+    ; the lanes hold pixels 0-3 8-11 16-19 24-27 and 4-7 12-15 20-23 28-31
+    vpermd            m1, m6, m1
+    vpermd            m3, m6, m3
+    vpermd            m4, m6, m4
+%endif
+    movu     [dst0q + wq], m1
+    movu     [dst1q + wq], m3
+    movu     [dst2q + wq], m4
+    add               wq, mmsize
+    jl .loop
+    RET
+%endmacro
+
+%macro UNSCALED_FUNCS 0
+SHIFT_WORDS from_planar, psllw
+SHIFT_WORDS to_planar, psrlw
+P01X_CHROMA_FROM_PLANAR
+P01X_CHROMA_TO_PLANAR
+PLANAR_RGB_TO_PACKED32 rgbx, 0, 0
+PLANAR_RGB_TO_PACKED32 xrgb, 1, 0
+PLANAR_RGB_TO_PACKED32 rgba, 0, 1
+PLANAR_RGB_TO_PACKED32 argb, 1, 1
+PACKED32_TO_PLANAR_RGB rgbx, 0
+PACKED32_TO_PLANAR_RGB xrgb, 1
+%endmacro
+
+INIT_XMM sse2
+UNSCALED_FUNCS
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+UNSCALED_FUNCS
+%endif
@@ -63,6 +63,15 @@
 #define RENAME(a) a ## _ssse3
 #include "yuv2rgb_template.c"
 
+//AVX2 versions
+#if ARCH_X86_64
+#undef RENAME
+#define COMPILE_TEMPLATE_AVX2
+#define RENAME(a) a ## _avx2
+#include "yuv2rgb_template.c"
+#undef COMPILE_TEMPLATE_AVX2
+#endif /* ARCH_X86_64 */
+
 #endif /* HAVE_X86ASM */
 
 av_cold SwsFunc ff_yuv2rgb_init_x86(SwsContext *c)
@@ -70,6 +79,37 @@ av_cold SwsFunc ff_yuv2rgb_init_x86(SwsContext *c)
 #if HAVE_X86ASM
     int cpu_flags = av_get_cpu_flags();
 
+#if ARCH_X86_64
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        switch (c->dstFormat) {
+        case AV_PIX_FMT_RGB32:
+            if (c->srcFormat == AV_PIX_FMT_YUVA420P) {
+#if CONFIG_SWSCALE_ALPHA
+                return yuva420_rgb32_avx2;
+#endif
+                break;
+            } else
+                return yuv420_rgb32_avx2;
+        case AV_PIX_FMT_BGR32:
+            if (c->srcFormat == AV_PIX_FMT_YUVA420P) {
+#if CONFIG_SWSCALE_ALPHA
+                return yuva420_bgr32_avx2;
+#endif
+                break;
+            } else
+                return yuv420_bgr32_avx2;
+        case AV_PIX_FMT_RGB24:
+            return yuv420_rgb24_avx2;
+        case AV_PIX_FMT_BGR24:
+            return yuv420_bgr24_avx2;
+        case AV_PIX_FMT_RGB565:
+            return yuv420_rgb16_avx2;
+        case AV_PIX_FMT_RGB555:
+            return yuv420_rgb15_avx2;
+        }
+    }
+#endif /* ARCH_X86_64 */
+
     if (EXTERNAL_SSSE3(cpu_flags)) {
         switch (c->dstFormat) {
         case AV_PIX_FMT_RGB32:
@@ -40,6 +40,46 @@
         const uint8_t *pv = src[2] +   (y >> vshift) * srcStride[2]; \
         x86_reg index = -h_size / 2;                                 \
 
+#undef YUV2RGB_CALL
+#undef YUVA2RGB_CALL
+#ifdef COMPILE_TEMPLATE_AVX2
+/* The AVX2 functions convert 32 pixels per iteration, the SSSE3 ones
+ * convert the rest of the line. */
+#define YUV2RGB_CALL(fn, depth)                                                  \
+        if (h_size >= 32) {                                                      \
+            x86_reg n = -(h_size & ~31) / 2;                                     \
+            RENAME(fn)(n, image, pu - n, pv - n, &(c->redDither), py - 2 * n);   \
+            image -= 2 * depth * n;                                              \
+            pu    -= n;                                                          \
+            pv    -= n;                                                          \
+            py    -= 2 * n;                                                      \
+            index -= n;                                                          \
+        }                                                                        \
+        if (index)                                                               \
+            fn ## _ssse3(index, image, pu - index, pv - index, &(c->redDither),  \
+                         py - 2 * index);
+#define YUVA2RGB_CALL(fn)                                                        \
+        if (h_size >= 32) {                                                      \
+            x86_reg n = -(h_size & ~31) / 2;                                     \
+            RENAME(fn)(n, image, pu - n, pv - n, &(c->redDither), py - 2 * n,    \
+                       pa - 2 * n);                                              \
+            image -= 8 * n;                                                      \
+            pu    -= n;                                                          \
+            pv    -= n;                                                          \
+            py    -= 2 * n;                                                      \
+            pa    -= 2 * n;                                                      \
+            index -= n;                                                          \
+        }                                                                        \
+        if (index)                                                               \
+            fn ## _ssse3(index, image, pu - index, pv - index, &(c->redDither),  \
+                         py - 2 * index, pa - 2 * index);
+#else
+#define YUV2RGB_CALL(fn, depth)                                                  \
+        RENAME(fn)(index, image, pu - index, pv - index, &(c->redDither), py - 2 * index);
+#define YUVA2RGB_CALL(fn)                                                        \
+        RENAME(fn)(index, image, pu - index, pv - index, &(c->redDither), py - 2 * index, pa - 2 * index);
+#endif
+
 extern void RENAME(ff_yuv_420_rgb24)(x86_reg index, uint8_t *image, const uint8_t *pu_index,
                                      const uint8_t *pv_index, const uint64_t *pointer_c_dither,
                                      const uint8_t *py_2index);
@@ -82,7 +122,7 @@ static inline int RENAME(yuv420_rgb15)(SwsContext *c, const uint8_t *src[],
         c->redDither   = ff_dither8[(y + 1) & 1];
 #endif
 
-        RENAME(ff_yuv_420_rgb15)(index, image, pu - index, pv - index, &(c->redDither), py - 2 * index);
+        YUV2RGB_CALL(ff_yuv_420_rgb15, 2)
     }
     return srcSliceH;
 }
@@ -102,7 +142,7 @@ static inline int RENAME(yuv420_rgb16)(SwsContext *c, const uint8_t *src[],
         c->redDither   = ff_dither8[(y + 1) & 1];
 #endif
 
-        RENAME(ff_yuv_420_rgb16)(index, image, pu - index, pv - index, &(c->redDither), py - 2 * index);
+        YUV2RGB_CALL(ff_yuv_420_rgb16, 2)
     }
     return srcSliceH;
 }
@@ -116,7 +156,7 @@ static inline int RENAME(yuv420_rgb32)(SwsContext *c, const uint8_t *src[],
 
     YUV2RGB_LOOP(4)
 
-        RENAME(ff_yuv_420_rgb32)(index, image, pu - index, pv - index, &(c->redDither), py - 2 * index);
+        YUV2RGB_CALL(ff_yuv_420_rgb32, 4)
     }
     return srcSliceH;
 }
@@ -130,7 +170,7 @@ static inline int RENAME(yuv420_bgr32)(SwsContext *c, const uint8_t *src[],
 
     YUV2RGB_LOOP(4)
 
-        RENAME(ff_yuv_420_bgr32)(index, image, pu - index, pv - index, &(c->redDither), py - 2 * index);
+        YUV2RGB_CALL(ff_yuv_420_bgr32, 4)
     }
     return srcSliceH;
 }
@@ -144,7 +184,7 @@ static inline int RENAME(yuva420_rgb32)(SwsContext *c, const uint8_t *src[],
     YUV2RGB_LOOP(4)
 
         const uint8_t *pa = src[3] + y * srcStride[3];
-        RENAME(ff_yuva_420_rgb32)(index, image, pu - index, pv - index, &(c->redDither), py - 2 * index, pa - 2 * index);
+        YUVA2RGB_CALL(ff_yuva_420_rgb32)
     }
     return srcSliceH;
 }
@@ -159,7 +199,7 @@ static inline int RENAME(yuva420_bgr32)(SwsContext *c, const uint8_t *src[],
     YUV2RGB_LOOP(4)
 
         const uint8_t *pa = src[3] + y * srcStride[3];
-        RENAME(ff_yuva_420_bgr32)(index, image, pu - index, pv - index, &(c->redDither), py - 2 * index, pa - 2 * index);
+        YUVA2RGB_CALL(ff_yuva_420_bgr32)
     }
     return srcSliceH;
 }
@@ -175,7 +215,7 @@ static inline int RENAME(yuv420_rgb24)(SwsContext *c, const uint8_t *src[],
 
     YUV2RGB_LOOP(3)
 
-        RENAME(ff_yuv_420_rgb24)(index, image, pu - index, pv - index, &(c->redDither), py - 2 * index);
+        YUV2RGB_CALL(ff_yuv_420_rgb24, 3)
     }
     return srcSliceH;
 }
@@ -189,7 +229,7 @@ static inline int RENAME(yuv420_bgr24)(SwsContext *c, const uint8_t *src[],
 
     YUV2RGB_LOOP(3)
 
-        RENAME(ff_yuv_420_bgr24)(index, image, pu - index, pv - index, &(c->redDither), py - 2 * index);
+        YUV2RGB_CALL(ff_yuv_420_bgr24, 3)
     }
     return srcSliceH;
 }
@@ -23,20 +23,21 @@
 
 %include "libavutil/x86/x86util.asm"
 
-SECTION_RODATA
+SECTION_RODATA 32
 
 ; below variables are named like mask_dwXY, which means to preserve dword No.X & No.Y
-mask_dw036 : db -1, -1,  0,  0,  0,  0, -1, -1,  0,  0,  0,  0, -1, -1,  0,  0
-mask_dw147 : db  0,  0, -1, -1,  0,  0,  0,  0, -1, -1,  0,  0,  0,  0, -1, -1
-mask_dw25  : db  0,  0,  0,  0, -1, -1,  0,  0,  0,  0, -1, -1,  0,  0,  0,  0
-rgb24_shuf1: db  0,  1,  6,  7, 12, 13,  2,  3,  8,  9, 14, 15,  4,  5, 10, 11
-rgb24_shuf2: db 10, 11,  0,  1,  6,  7, 12, 13,  2,  3,  8,  9, 14, 15,  4,  5
-rgb24_shuf3: db  4,  5, 10, 11,  0,  1,  6,  7, 12, 13,  2,  3,  8,  9, 14, 15
-pw_00ff: times 8 dw 255
-pb_f8:   times 16 db 248
-pb_e0:   times 16 db 224
-pb_03:   times 16 db 3
-pb_07:   times 16 db 7
+; the 16-byte patterns are repeated for both lanes of the AVX2 versions
+mask_dw036 : times 2 db -1, -1,  0,  0,  0,  0, -1, -1,  0,  0,  0,  0, -1, -1,  0,  0
+mask_dw147 : times 2 db  0,  0, -1, -1,  0,  0,  0,  0, -1, -1,  0,  0,  0,  0, -1, -1
+mask_dw25  : times 2 db  0,  0,  0,  0, -1, -1,  0,  0,  0,  0, -1, -1,  0,  0,  0,  0
+rgb24_shuf1: times 2 db  0,  1,  6,  7, 12, 13,  2,  3,  8,  9, 14, 15,  4,  5, 10, 11
+rgb24_shuf2: times 2 db 10, 11,  0,  1,  6,  7, 12, 13,  2,  3,  8,  9, 14, 15,  4,  5
+rgb24_shuf3: times 2 db  4,  5, 10, 11,  0,  1,  6,  7, 12, 13,  2,  3,  8,  9, 14, 15
+pw_00ff: times 16 dw 255
+pb_f8:   times 32 db 248
+pb_e0:   times 32 db 224
+pb_03:   times 32 db 3
+pb_07:   times 32 db 7
 
 mask_1101: dw -1, -1,  0, -1
 mask_0010: dw  0,  0, -1,  0
@@ -58,7 +59,7 @@ SECTION .text
 %macro MOV_H2L 1
 %if mmsize == 8
     psrlq %1, 32
-%else ; mmsize == 16
+%else ; mmsize == 16/32
     psrldq %1, 8
 %endif
 %endmacro
@@ -102,8 +103,8 @@ SECTION .text
 %define y_coff   [pointer_c_ditherq + 3  * 8]
 %define ub_coff  [pointer_c_ditherq + 5  * 8]
 %define vr_coff  [pointer_c_ditherq + 4  * 8]
-%elif mmsize == 16
-%define time_num 2
+%else ; mmsize == 16/32
+%define time_num (mmsize / 8)
 %if ARCH_X86_32
 %define reg_num 8
 %define my_offset [pointer_c_ditherq + 8  * 8]
@@ -125,13 +126,13 @@ SECTION .text
 %define ub_coff  m14
 %define vr_coff  m15
 %endif ; ARCH_X86_32/64
-%endif ; coeff define mmsize == 8/16
+%endif ; coeff define mmsize == 8/16/32
 
 cglobal %1_420_%2%3, GPR_num, GPR_num, reg_num, parameters
 
 %if ARCH_X86_64
     movsxd indexq, indexd
-%if mmsize == 16
+%if mmsize >= 16
     VBROADCASTSD y_offset, [pointer_c_ditherq + 8  * 8]
     VBROADCASTSD u_offset, [pointer_c_ditherq + 9  * 8]
     VBROADCASTSD v_offset, [pointer_c_ditherq + 10 * 8]
@@ -144,8 +145,16 @@ cglobal %1_420_%2%3, GPR_num, GPR_num, reg_num, parameters
 %endif
 .loop0:
     movu m_y, [py_2indexq + 2 * indexq]
+%if mmsize == 32
+    ; the unpacks below work within lanes, so move chroma 8-15 to the upper lane
+    movu      xm0, [pu_indexq + indexq]
+    movu      xm1, [pv_indexq + indexq]
+    vpermq     m0, m0, q3120
+    vpermq     m1, m1, q3120
+%else
     movh m_u, [pu_indexq  +     indexq]
     movh m_v, [pv_indexq  +     indexq]
+%endif
     pxor m4, m4
     mova m7, m6
     punpcklbw m0, m4
@@ -271,10 +280,20 @@ cglobal %1_420_%2%3, GPR_num, GPR_num, reg_num, parameters
     por    m2, m7
     por    m1, m6          ; g5  b5  r6  g6  b6  r7  g7  b7  r8  g8  b8  r9  g9  b9  r10 g10
     por    m2, m3          ; b10 r11 g11 b11 r12 g12 b12 r13 g13 b13 r14 g14 b14 r15 g15 b15
+%if mmsize == 32
+    ; the upper lanes hold pixels 16-31
+    vperm2i128 m3, m0, m1, 0x20
+    vperm2i128 m4, m2, m0, 0x30
+    vperm2i128 m5, m1, m2, 0x31
+    movu [imageq], m3
+    movu [imageq + 32], m4
+    movu [imageq + 64], m5
+%else
     movu [imageq], m0
     movu [imageq + 16], m1
     movu [imageq + 32], m2
-%endif ; mmsize = 16
+%endif
+%endif ; mmsize = 16/32
 %else ; PACK RGB15/16/32
     packuswb m0, m1
     packuswb m3, m5
@@ -303,10 +322,22 @@ cglobal %1_420_%2%3, GPR_num, GPR_num, reg_num, parameters
     punpckhwd m_green, m_red
     punpcklwd m5, m6
     punpckhwd m_alpha, m6
+%if mmsize == 32
+    ; the upper lanes hold pixels 16-31
+    vperm2i128 m4, m_blue, m_green, 0x20
+    vperm2i128 m6, m5, m_alpha, 0x20
+    vperm2i128 m7, m_blue, m_green, 0x31
+    vperm2i128 m5, m5, m_alpha, 0x31
+    movu [imageq +  0], m4
+    movu [imageq + 32], m6
+    movu [imageq + 64], m7
+    movu [imageq + 96], m5
+%else
     movu [imageq + 0], m_blue
     movu [imageq + 8  * time_num], m_green
     movu [imageq + 16 * time_num], m5
     movu [imageq + 24 * time_num], m_alpha
+%endif
 %else ; PACK RGB15/16
 %define depth 2
 %if cpuflag(ssse3)
@@ -345,8 +376,16 @@ cglobal %1_420_%2%3, GPR_num, GPR_num, reg_num, parameters
     mova m2, m0
     punpcklbw m0, m1
     punpckhbw m2, m1
+%if mmsize == 32
+    ; the upper lanes hold pixels 16-31
+    vperm2i128 m1, m0, m2, 0x20
+    vperm2i128 m2, m0, m2, 0x31
+    movu [imageq], m1
+    movu [imageq + 32], m2
+%else
     movu [imageq], m0
     movu [imageq + 8 * time_num], m2
+%endif
 %endif ; PACK RGB15/16
 %endif ; PACK RGB15/16/32
 
@@ -379,3 +418,15 @@ yuv2rgb_fn yuva, rgb, 32
 yuv2rgb_fn yuva, bgr, 32
 yuv2rgb_fn yuv,  rgb, 15
 yuv2rgb_fn yuv,  rgb, 16
+
+%if ARCH_X86_64 && HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+yuv2rgb_fn yuv,  rgb, 24
+yuv2rgb_fn yuv,  bgr, 24
+yuv2rgb_fn yuv,  rgb, 32
+yuv2rgb_fn yuv,  bgr, 32
+yuv2rgb_fn yuva, rgb, 32
+yuv2rgb_fn yuva, bgr, 32
+yuv2rgb_fn yuv,  rgb, 15
+yuv2rgb_fn yuv,  rgb, 16
+%endif
@@ -198,7 +198,11 @@ static const struct {
         { "vorbisdsp", checkasm_check_vorbisdsp },
     #endif
     #if CONFIG_VVC_DECODER
+        { "vvc_alf", checkasm_check_vvc_alf },
+        { "vvc_itx", checkasm_check_vvc_itx },
+        { "vvc_lmcs", checkasm_check_vvc_lmcs },
         { "vvc_mc", checkasm_check_vvc_mc },
+        { "vvc_sao", checkasm_check_vvc_sao },
     #endif
 #endif
 #if CONFIG_AVFILTER
@@ -237,6 +241,8 @@ static const struct {
     { "sw_gbrp", checkasm_check_sw_gbrp },
     { "sw_rgb", checkasm_check_sw_rgb },
     { "sw_scale", checkasm_check_sw_scale },
+    { "sw_unscaled", checkasm_check_sw_unscaled },
+    { "sw_yuv2rgb", checkasm_check_sw_yuv2rgb },
 #endif
 #if CONFIG_AVUTIL
         { "fixed_dsp", checkasm_check_fixed_dsp },
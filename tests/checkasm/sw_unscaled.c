@@ -0,0 +1,149 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem_internal.h"
+#include "libavutil/pixdesc.h"
+
+#include "libswscale/swscale.h"
+#include "libswscale/swscale_internal.h"
+
+#include "checkasm.h"
+
+#define randomize_buffers(buf, size)      \
+    do {                                  \
+        int j;                            \
+        for (j = 0; j < size; j+=4)       \
+            AV_WN32(buf + j, rnd());      \
+    } while (0)
+
+#define MAX_WIDTH  1920
+#define HEIGHT     4
+#define STRIDE     (MAX_WIDTH * 4)
+#define PLANE_SIZE (STRIDE * HEIGHT)
+
+static const struct {
+    enum AVPixelFormat src, dst;
+} conversions[] = {
+    { AV_PIX_FMT_YUV420P10, AV_PIX_FMT_P010      },
+    { AV_PIX_FMT_YUV420P16, AV_PIX_FMT_P016      },
+    { AV_PIX_FMT_P010,      AV_PIX_FMT_YUV420P10 },
+    { AV_PIX_FMT_P012,      AV_PIX_FMT_YUV420P12 },
+    { AV_PIX_FMT_P016,      AV_PIX_FMT_YUV420P16 },
+    { AV_PIX_FMT_GBRP,      AV_PIX_FMT_RGBA      },
+    { AV_PIX_FMT_GBRP,      AV_PIX_FMT_BGRA      },
+    { AV_PIX_FMT_GBRP,      AV_PIX_FMT_ARGB      },
+    { AV_PIX_FMT_GBRP,      AV_PIX_FMT_ABGR      },
+    { AV_PIX_FMT_GBRAP,     AV_PIX_FMT_RGBA      },
+    { AV_PIX_FMT_GBRAP,     AV_PIX_FMT_ARGB      },
+    { AV_PIX_FMT_GRAY8,     AV_PIX_FMT_BGRA      },
+    { AV_PIX_FMT_GRAY8,     AV_PIX_FMT_ABGR      },
+    { AV_PIX_FMT_RGBA,      AV_PIX_FMT_GBRP      },
+    { AV_PIX_FMT_BGRA,      AV_PIX_FMT_GBRP      },
+    { AV_PIX_FMT_ARGB,      AV_PIX_FMT_GBRP      },
+    { AV_PIX_FMT_ABGR,      AV_PIX_FMT_GBRP      },
+};
+
+static void check_unscaled(void)
+{
+    static const int widths[] = { 8, 67, 256, MAX_WIDTH };
+    uint8_t *src_buf, *dst0_buf, *dst1_buf;
+
+    declare_func(int, SwsContext *c, const uint8_t *src[], int srcStride[],
+                 int srcSliceY, int srcSliceH, uint8_t *dst[], int dstStride[]);
+
+    src_buf  = av_malloc(4 * PLANE_SIZE);
+    dst0_buf = av_malloc(4 * PLANE_SIZE);
+    dst1_buf = av_malloc(4 * PLANE_SIZE);
+    if (!src_buf || !dst0_buf || !dst1_buf)
+        goto end;
+    randomize_buffers(src_buf, 4 * PLANE_SIZE);
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(conversions); i++) {
+        const char *src_name = av_get_pix_fmt_name(conversions[i].src);
+        const char *dst_name = av_get_pix_fmt_name(conversions[i].dst);
+
+        for (int wi = 0; wi < FF_ARRAY_ELEMS(widths); wi++) {
+            const int width = widths[wi];
+            int stride[4] = { STRIDE, STRIDE, STRIDE, STRIDE };
+            SwsContext *ctx = sws_alloc_context();
+
+            if (!ctx)
+                fail();
+            ctx->srcW      = ctx->dstW = width;
+            ctx->srcH      = ctx->dstH = HEIGHT;
+            ctx->srcFormat = conversions[i].src;
+            ctx->dstFormat = conversions[i].dst;
+            ctx->flags     = SWS_POINT;
+            if (sws_init_context(ctx, NULL, NULL) < 0 || !ctx->convert_unscaled) {
+                fail();
+                sws_freeContext(ctx);
+                continue;
+            }
+
+            if (check_func(ctx->convert_unscaled, "%s_to_%s_%d",
+                           src_name, dst_name, width)) {
+                const uint8_t *src[4];
+                uint8_t *dst0[4], *dst1[4];
+
+                for (int p = 0; p < 4; p++) {
+                    src[p]  = src_buf  + p * PLANE_SIZE;
+                    dst0[p] = dst0_buf + p * PLANE_SIZE;
+                    dst1[p] = dst1_buf + p * PLANE_SIZE;
+                }
+                /* the C gray converter reads the palette set up by sws_scale() */
+                if (usePal(ctx->srcFormat))
+                    sws_scale(ctx, src, stride, 0, HEIGHT, dst0, stride);
+                memset(dst0_buf, 0xAA, 4 * PLANE_SIZE);
+                memset(dst1_buf, 0xAA, 4 * PLANE_SIZE);
+
+                /* the converters may advance the plane pointers */
+                {
+                    const uint8_t *src_ref[4] = { src[0], src[1], src[2], src[3] };
+                    call_ref(ctx, src_ref, stride, 0, HEIGHT, dst0, stride);
+                }
+                {
+                    const uint8_t *src_new[4] = { src[0], src[1], src[2], src[3] };
+                    call_new(ctx, src_new, stride, 0, HEIGHT, dst1, stride);
+                }
+                if (memcmp(dst0_buf, dst1_buf, 4 * PLANE_SIZE))
+                    fail();
+
+                if (width == MAX_WIDTH) {
+                    const uint8_t *src_bench[4] = { src[0], src[1], src[2], src[3] };
+                    bench_new(ctx, src_bench, stride, 0, HEIGHT, dst1, stride);
+                }
+            }
+            sws_freeContext(ctx);
+        }
+    }
+
+end:
+    av_free(src_buf);
+    av_free(dst0_buf);
+    av_free(dst1_buf);
+}
+
+void checkasm_check_sw_unscaled(void)
+{
+    check_unscaled();
+    report("unscaled");
+}
@@ -0,0 +1,187 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/log.h"
+#include "libavutil/mem_internal.h"
+#include "libavutil/pixdesc.h"
+
+#include "libswscale/swscale.h"
+#include "libswscale/swscale_internal.h"
+
+#include "checkasm.h"
+
+#define randomize_buffers(buf, size)      \
+    do {                                  \
+        int j;                            \
+        for (j = 0; j < size; j += 4)     \
+            AV_WN32(buf + j, rnd());      \
+    } while (0)
+
+#define MAX_LINE_SIZE 1920
+#define NUM_LINES     4
+#define DST_STRIDE    (MAX_LINE_SIZE * 4 + 64)
+
+static const int src_fmts[] = {
+    AV_PIX_FMT_YUV420P,
+    AV_PIX_FMT_YUV422P,
+    AV_PIX_FMT_YUVA420P,
+};
+
+static const int dst_fmts[] = {
+    AV_PIX_FMT_RGB32,
+    AV_PIX_FMT_BGR32,
+    AV_PIX_FMT_RGB24,
+    AV_PIX_FMT_BGR24,
+    AV_PIX_FMT_RGB565,
+    AV_PIX_FMT_RGB555,
+};
+
+/* The SIMD versions round differently from the C tables, so allow the
+ * components to be a little off. */
+static int cmp_off_by_n(const uint8_t *ref, const uint8_t *test, int n, int accuracy)
+{
+    for (int i = 0; i < n; i++) {
+        if (abs(ref[i] - test[i]) > accuracy)
+            return 1;
+    }
+    return 0;
+}
+
+static int cmp_16bpp_by_n(const uint8_t *ref, const uint8_t *test, int n,
+                          int rshift, int gbits, int accuracy)
+{
+    for (int i = 0; i < n; i++) {
+        const int r = AV_RN16(ref + 2 * i), t = AV_RN16(test + 2 * i);
+        const int gmask = (1 << gbits) - 1;
+
+        if (abs((r & 0x1f) - (t & 0x1f)) > accuracy ||
+            abs(((r >> 5) & gmask) - ((t >> 5) & gmask)) > accuracy ||
+            abs(((r >> rshift) & 0x1f) - ((t >> rshift) & 0x1f)) > accuracy)
+            return 1;
+    }
+    return 0;
+}
+
+static void check_yuv2rgb(int src_pix_fmt)
+{
+    const AVPixFmtDescriptor *src_desc = av_pix_fmt_desc_get(src_pix_fmt);
+    /* Not all multiples of 32, so that the AVX2 converters hand the end
+     * of the lines to the SSSE3 ones. */
+    static const int input_sizes[] = { 8, 24, 40, 72, 128, 136, 1080, MAX_LINE_SIZE };
+
+    declare_func_emms(AV_CPU_FLAG_MMX | AV_CPU_FLAG_MMXEXT,
+                      int, SwsContext *c, const uint8_t *src[], int srcStride[],
+                      int srcSliceY, int srcSliceH, uint8_t *dst[], int dstStride[]);
+
+    LOCAL_ALIGNED_32(uint8_t, src_y, [MAX_LINE_SIZE * NUM_LINES]);
+    LOCAL_ALIGNED_32(uint8_t, src_u, [MAX_LINE_SIZE * NUM_LINES / 2]);
+    LOCAL_ALIGNED_32(uint8_t, src_v, [MAX_LINE_SIZE * NUM_LINES / 2]);
+    LOCAL_ALIGNED_32(uint8_t, src_a, [MAX_LINE_SIZE * NUM_LINES]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [DST_STRIDE * NUM_LINES]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [DST_STRIDE * NUM_LINES]);
+
+    const uint8_t *src[4] = { src_y, src_u, src_v, src_a };
+    const int src_stride[4] = { MAX_LINE_SIZE, MAX_LINE_SIZE / 2, MAX_LINE_SIZE / 2, MAX_LINE_SIZE };
+    /* the C converters double the chroma strides of yuv422p in place */
+    int src_stride0[4], src_stride1[4];
+    int dst_stride[4] = { DST_STRIDE };
+    uint8_t *dst0_planes[4] = { dst0 };
+    uint8_t *dst1_planes[4] = { dst1 };
+
+    randomize_buffers(src_y, MAX_LINE_SIZE * NUM_LINES);
+    randomize_buffers(src_u, MAX_LINE_SIZE * NUM_LINES / 2);
+    randomize_buffers(src_v, MAX_LINE_SIZE * NUM_LINES / 2);
+    randomize_buffers(src_a, MAX_LINE_SIZE * NUM_LINES);
+    /* The C converters reuse the chroma of the even lines for the odd ones
+     * with yuv422p, so only feed them vertically subsampled chroma. */
+    if (src_pix_fmt == AV_PIX_FMT_YUV422P) {
+        for (int y = 1; y < NUM_LINES; y += 2) {
+            memcpy(src_u + y * src_stride[1], src_u + (y - 1) * src_stride[1], src_stride[1]);
+            memcpy(src_v + y * src_stride[2], src_v + (y - 1) * src_stride[2], src_stride[2]);
+        }
+    }
+
+    for (int dfi = 0; dfi < FF_ARRAY_ELEMS(dst_fmts); dfi++) {
+        const int dst_pix_fmt = dst_fmts[dfi];
+        const AVPixFmtDescriptor *dst_desc = av_pix_fmt_desc_get(dst_pix_fmt);
+        const int sample_size = av_get_padded_bits_per_pixel(dst_desc) >> 3;
+
+        for (int isi = 0; isi < FF_ARRAY_ELEMS(input_sizes); isi++) {
+            const int width = input_sizes[isi];
+            SwsContext *c;
+            int log_level;
+
+            /* silence "No accelerated colorspace conversion found" */
+            log_level = av_log_get_level();
+            av_log_set_level(AV_LOG_ERROR);
+            c = sws_getContext(width, NUM_LINES, src_pix_fmt,
+                               width, NUM_LINES, dst_pix_fmt,
+                               SWS_BILINEAR, NULL, NULL, NULL);
+            av_log_set_level(log_level);
+            if (!c) {
+                fail();
+                continue;
+            }
+
+            if (check_func(c->convert_unscaled, "%s_%s_%d", src_desc->name,
+                           dst_desc->name, width)) {
+                memset(dst0, 0xFF, DST_STRIDE * NUM_LINES);
+                memset(dst1, 0xFF, DST_STRIDE * NUM_LINES);
+
+                memcpy(src_stride0, src_stride, sizeof(src_stride));
+                memcpy(src_stride1, src_stride, sizeof(src_stride));
+                call_ref(c, src, src_stride0, 0, NUM_LINES, dst0_planes, dst_stride);
+                call_new(c, src, src_stride1, 0, NUM_LINES, dst1_planes, dst_stride);
+
+                for (int y = 0; y < NUM_LINES; y++) {
+                    const uint8_t *ref  = dst0 + y * DST_STRIDE;
+                    const uint8_t *test = dst1 + y * DST_STRIDE;
+                    int ret;
+
+                    if (dst_pix_fmt == AV_PIX_FMT_RGB565)
+                        ret = cmp_16bpp_by_n(ref, test, width, 11, 6, 2);
+                    else if (dst_pix_fmt == AV_PIX_FMT_RGB555)
+                        ret = cmp_16bpp_by_n(ref, test, width, 10, 5, 2);
+                    else
+                        ret = cmp_off_by_n(ref, test, width * sample_size, 3);
+                    if (ret) {
+                        fail();
+                        break;
+                    }
+                }
+
+                memcpy(src_stride1, src_stride, sizeof(src_stride));
+                bench_new(c, src, src_stride1, 0, NUM_LINES, dst1_planes, dst_stride);
+            }
+            sws_freeContext(c);
+        }
+    }
+}
+
+void checkasm_check_sw_yuv2rgb(void)
+{
+    for (int i = 0; i < FF_ARRAY_ELEMS(src_fmts); i++) {
+        check_yuv2rgb(src_fmts[i]);
+        report("yuv2rgb_%s", av_get_pix_fmt_name(src_fmts[i]));
+    }
+}
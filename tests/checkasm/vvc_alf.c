@@ -0,0 +1,121 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavcodec/vvc/vvc_ctu.h"
+#include "libavcodec/vvc/vvcdsp.h"
+
+#include "libavutil/common.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem_internal.h"
+
+static const uint32_t pixel_mask[3] = { 0xffffffff, 0x03ff03ff, 0x0fff0fff };
+
+#define SIZEOF_PIXEL ((bit_depth + 7) / 8)
+#define SRC_PIXEL_STRIDE (MAX_CTU_SIZE + 2 * ALF_PADDING_SIZE + 16) //+16 for the 16 pixel wide reads of the last column
+#define DST_PIXEL_STRIDE (MAX_CTU_SIZE + 4)
+#define SRC_BUF_SIZE (SRC_PIXEL_STRIDE * (MAX_CTU_SIZE + 2 * ALF_PADDING_SIZE) * 2) //*2 for high bit depth
+#define DST_BUF_SIZE (DST_PIXEL_STRIDE * MAX_CTU_SIZE * 2)
+#define LUMA_PARAMS_SIZE (MAX_CTU_SIZE * MAX_CTU_SIZE / ALF_BLOCK_SIZE / ALF_BLOCK_SIZE * ALF_NUM_COEFF_LUMA)
+
+#define randomize_buffers(buf0, buf1, size)                 \
+    do {                                                    \
+        uint32_t mask = pixel_mask[(bit_depth - 8) >> 1];   \
+        int k;                                              \
+        for (k = 0; k < size; k += 4) {                     \
+            uint32_t r = rnd() & mask;                      \
+            AV_WN32A(buf0 + k, r);                          \
+            AV_WN32A(buf1 + k, r);                          \
+        }                                                   \
+    } while (0)
+
+static void check_alf_filter(VVCDSPContext *c, const int bit_depth)
+{
+    LOCAL_ALIGNED_32(uint8_t, dst0, [DST_BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [DST_BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, src0, [SRC_BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, src1, [SRC_BUF_SIZE]);
+    int16_t filter[LUMA_PARAMS_SIZE];
+    int16_t clip[LUMA_PARAMS_SIZE];
+
+    const int16_t clip_set[] = {
+        1 << bit_depth, 1 << (bit_depth - 3), 1 << (bit_depth - 5), 1 << (bit_depth - 7)
+    };
+
+    const ptrdiff_t src_stride = SRC_PIXEL_STRIDE * SIZEOF_PIXEL;
+    const ptrdiff_t dst_stride = DST_PIXEL_STRIDE * SIZEOF_PIXEL;
+    const int offset = (ALF_PADDING_SIZE * SRC_PIXEL_STRIDE + ALF_PADDING_SIZE) * SIZEOF_PIXEL;
+
+    declare_func(void, uint8_t *dst, ptrdiff_t dst_stride, const uint8_t *src, ptrdiff_t src_stride,
+        int width, int height, const int16_t *filter, const int16_t *clip, int vb_pos);
+
+    randomize_buffers(src0, src1, SRC_BUF_SIZE);
+    for (int i = 0; i < LUMA_PARAMS_SIZE; i++) {
+        filter[i] = -(1 << 7) + (rnd() & ((1 << 8) - 1));
+        clip[i]   = clip_set[rnd() & 3];
+    }
+
+    for (int h = 4; h <= MAX_CTU_SIZE; h += 4) {
+        // the virtual boundary of the smallest CTU that fits the block
+        const int ctu_size = h <= 32 ? 32 : h <= 64 ? 64 : MAX_CTU_SIZE;
+
+        for (int w = 4; w <= MAX_CTU_SIZE; w += 4) {
+            if (check_func(c->alf.filter[LUMA], "vvc_alf_filter_luma_%dx%d_%d", w, h, bit_depth)) {
+                const int vb_pos = ctu_size - ALF_VB_POS_ABOVE_LUMA;
+
+                memset(dst0, 0, DST_BUF_SIZE);
+                memset(dst1, 0, DST_BUF_SIZE);
+                call_ref(dst0, dst_stride, src0 + offset, src_stride, w, h, filter, clip, vb_pos);
+                call_new(dst1, dst_stride, src1 + offset, src_stride, w, h, filter, clip, vb_pos);
+                for (int i = 0; i < h; i++) {
+                    if (memcmp(dst0 + i * dst_stride, dst1 + i * dst_stride, w * SIZEOF_PIXEL))
+                        fail();
+                }
+                if (w == h && !(w & (w - 1)))
+                    bench_new(dst1, dst_stride, src1 + offset, src_stride, w, h, filter, clip, vb_pos);
+            }
+            if (check_func(c->alf.filter[CHROMA], "vvc_alf_filter_chroma_%dx%d_%d", w, h, bit_depth)) {
+                const int vb_pos = ctu_size - ALF_VB_POS_ABOVE_CHROMA;
+
+                memset(dst0, 0, DST_BUF_SIZE);
+                memset(dst1, 0, DST_BUF_SIZE);
+                call_ref(dst0, dst_stride, src0 + offset, src_stride, w, h, filter, clip, vb_pos);
+                call_new(dst1, dst_stride, src1 + offset, src_stride, w, h, filter, clip, vb_pos);
+                for (int i = 0; i < h; i++) {
+                    if (memcmp(dst0 + i * dst_stride, dst1 + i * dst_stride, w * SIZEOF_PIXEL))
+                        fail();
+                }
+                if (w == h && !(w & (w - 1)))
+                    bench_new(dst1, dst_stride, src1 + offset, src_stride, w, h, filter, clip, vb_pos);
+            }
+        }
+    }
+}
+
+void checkasm_check_vvc_alf(void)
+{
+    for (int bit_depth = 8; bit_depth <= 12; bit_depth += 2) {
+        VVCDSPContext c;
+
+        ff_vvc_dsp_init(&c, bit_depth);
+        check_alf_filter(&c, bit_depth);
+    }
+    report("alf_filter");
+}
@@ -0,0 +1,70 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavcodec/vvc/vvcdsp.h"
+
+#include "libavutil/common.h"
+#include "libavutil/mem_internal.h"
+
+#define MAX_TX_SIZE 32
+#define BUF_SIZE (MAX_TX_SIZE * MAX_TX_SIZE)
+
+static const char *const tx_type_names[N_TX_TYPE] = { "dct2", "dst7", "dct8" };
+
+static void check_itx(VVCDSPContext *c)
+{
+    LOCAL_ALIGNED_32(int, coeffs0, [BUF_SIZE]);
+    LOCAL_ALIGNED_32(int, coeffs1, [BUF_SIZE]);
+
+    declare_func(void, int *coeffs, ptrdiff_t step, size_t nz);
+
+    for (int type = DST7; type < N_TX_TYPE; type++) {
+        for (int log2_size = 2; log2_size <= 5; log2_size++) {
+            const int size   = 1 << log2_size;
+            // the coefficients above 16 are zeroed out for DST-7 and DCT-8
+            const int max_nz = FFMIN(size, 16);
+
+            for (int step = 1; step <= MAX_TX_SIZE; step += MAX_TX_SIZE - 1) {
+                if (check_func(c->itx.itx[type][log2_size - 1], "vvc_inv_%s_%d_step%d",
+                               tx_type_names[type], size, step)) {
+                    for (int nz = 1; nz <= max_nz; nz++) {
+                        for (int i = 0; i < BUF_SIZE; i++)
+                            coeffs0[i] = coeffs1[i] = (int16_t)rnd();
+                        call_ref(coeffs0, step, nz);
+                        call_new(coeffs1, step, nz);
+                        if (memcmp(coeffs0, coeffs1, BUF_SIZE * sizeof(*coeffs0)))
+                            fail();
+                    }
+                    bench_new(coeffs1, step, max_nz);
+                }
+            }
+        }
+    }
+}
+
+void checkasm_check_vvc_itx(void)
+{
+    VVCDSPContext c;
+
+    ff_vvc_dsp_init(&c, 8);
+    check_itx(&c);
+    report("itx");
+}
@@ -306,6 +306,53 @@ stream_remux(){
         run ffprobe${PROGSUF}${EXECSUF} -bitexact $ffprobe_opts $tencfile || return
 }
 
+# Probe $1 with the stream info cache in ${outdir}/${test}.cache. With $2 set
+# to warm, the cache is filled by a first probe, and the second one must use
+# it. The cache entries are looked up by the file name, so -print_filename
+# cannot be used to strip the path from the output.
+stream_info_cache(){
+    filename=$1
+    cachedir="${outdir}/${test}.cache"
+    probefile="${outdir}/${test}.probe"
+    logfile="${outdir}/${test}.log"
+    cleanfiles="$cleanfiles $probefile $logfile"
+    rm -rf "$cachedir" && mkdir "$cachedir" || return
+    probe="ffprobe${PROGSUF}${EXECSUF} -bitexact -show_streams -show_format -stream_info_cache $(target_path $cachedir)"
+    if [ "$2" = warm ]; then
+        run $probe -v error $filename > /dev/null || return
+    fi
+    run $probe -v verbose $filename > "$probefile" 2> "$logfile" || return
+    sed 's#^filename=.*/#filename=#' "$probefile"
+    if [ "$2" = warm ]; then
+        grep -q "Stream information loaded" "$logfile"
+    fi
+}
+
+# Probe $1 decoding the streams with $2 threads, and check that the threads
+# were used.
+probe_threads(){
+    filename=$1
+    nb_threads=$2
+    logfile="${outdir}/${test}.log"
+    cleanfiles="$cleanfiles $logfile"
+    run ffprobe${PROGSUF}${EXECSUF} -v debug -bitexact -show_streams -show_format \
+        -print_filename $(basename $filename) -probe_threads $nb_threads $filename 2> "$logfile" || return
+    test $nb_threads -le 1 || grep -q "Decoding probe packets with $nb_threads threads" "$logfile"
+}
+
+# Mux to the file $1 in the directory ${outdir}/${test}.dir, with the other
+# arguments as ffmpeg options, and print the MD5 of each file written there.
+muxdir(){
+    outname=$1
+    shift
+    dir="${outdir}/${test}.dir"
+    rm -rf "$dir" && mkdir "$dir" || return
+    run ffmpeg${PROGSUF}${EXECSUF} -nostdin -nostats "$@" -y $(target_path $dir)/$outname || return
+    for file in $(ls "$dir" | LC_ALL=C sort); do
+        echo "$(do_md5sum "$dir/$file" | cut -d' ' -f1) $file"
+    done
+}
+
 # this function is for testing external encoders,
 # where the precise output is not controlled by us
 # we can still test e.g. that the output can be decoded correctly
@@ -257,7 +257,19 @@ FATE_AAC_ENCODE-$(call ENCMUX, AAC, ADTS, ARESAMPLE_FILTER) += $(FATE_AAC_ENCODE
 
 FATE_AAC_BSF-$(call ALLYES, AAC_DEMUXER AAC_ADTSTOASC_BSF MATROSKA_MUXER) += fate-aac-autobsf-adtstoasc
 
+# Encode 5.1 on one and on 4 threads, the quantizers of the channel elements
+# are searched in parallel and the output must not depend on the number of
+# threads.
+FATE_AAC_THREADS = fate-aac-51-encode fate-aac-51-encode-threads
+$(FATE_AAC_THREADS): tests/data/asynth-44100-6.wav
+fate-aac-51-encode:         CMD = framecrc -i $(TARGET_PATH)/tests/data/asynth-44100-6.wav -auto_conversion_filters -c:a aac -b:a 384k -threads 1
+fate-aac-51-encode-threads: CMD = framecrc -i $(TARGET_PATH)/tests/data/asynth-44100-6.wav -auto_conversion_filters -c:a aac -b:a 384k -threads 4
+fate-aac-51-encode-threads: REF = $(SRC_PATH)/tests/ref/fate/aac-51-encode
+
+FATE_AAC_THREADS-$(call ALLYES, WAV_DEMUXER PCM_S16LE_DECODER ARESAMPLE_FILTER AAC_ENCODER FRAMECRC_MUXER) += $(FATE_AAC_THREADS)
+
 FATE_SAMPLES_FFMPEG += $(FATE_AAC_ALL) $(FATE_AAC_ENCODE-yes) $(FATE_AAC_BSF-yes)
+FATE_FFMPEG += $(FATE_AAC_THREADS-yes)
 
-fate-aac: $(FATE_AAC_ALL) $(FATE_AAC_ENCODE) $(FATE_AAC_BSF-yes)
+fate-aac: $(FATE_AAC_ALL) $(FATE_AAC_ENCODE) $(FATE_AAC_BSF-yes) $(FATE_AAC_THREADS-yes)
 fate-aac-latm: $(FATE_AAC_LATM-yes)
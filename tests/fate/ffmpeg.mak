@@ -161,6 +161,19 @@ fate-copy-apng: fate-lavf-apng
 fate-lavf-apng: KEEP_FILES ?= 1
 fate-copy-apng: CMD = transcode apng tests/data/lavf/lavf.apng apng "-c:v copy"
 
+# Demux an MPEG-TS file read with read(2), and read from a memory mapping,
+# where the demuxer takes the packets straight from the mapping. The packets
+# must be the same.
+FATE_FILE_MMAP = fate-file-read-ts fate-file-mmap-ts
+ifneq (,$(filter fate-lavf-ts,$(FATE_LAVF_CONTAINER)))
+FATE_FFMPEG-$(call DEMMUX, MPEGTS, FRAMECRC) += $(FATE_FILE_MMAP)
+endif
+$(FATE_FILE_MMAP): fate-lavf-ts
+fate-lavf-ts: KEEP_FILES ?= 1
+fate-file-read-ts: CMD = framecrc -i $(TARGET_PATH)/tests/data/lavf/lavf.ts -c copy
+fate-file-mmap-ts: CMD = framecrc -mmap 1 -i $(TARGET_PATH)/tests/data/lavf/lavf.ts -c copy
+fate-file-mmap-ts: REF = $(SRC_PATH)/tests/ref/fate/file-read-ts
+
 FATE_STREAMCOPY-$(call DEMMUX, OGG, OGG) += fate-limited_input_seek fate-limited_input_seek-copyts
 fate-limited_input_seek: CMD = md5 -ss 1.5 -t 1.3 -i $(TARGET_SAMPLES)/vorbis/moog_small.ogg -c:a copy -fflags +bitexact -f ogg
 fate-limited_input_seek-copyts: CMD = md5 -ss 1.5 -t 1.3 -i $(TARGET_SAMPLES)/vorbis/moog_small.ogg -c:a copy -copyts -fflags +bitexact -f ogg
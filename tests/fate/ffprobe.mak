@@ -43,6 +43,41 @@ fate-ffprobe_xsd: $(FFPROBE_TEST_FILE)
 fate-ffprobe_xsd: CMD = run $(FFPROBE_COMMAND) -noprivate -of xml=q=1:x=1 | \
 	xmllint --schema $(SRC_PATH)/doc/ffprobe.xsd -
 
+# Probe an input with an empty stream info cache, then again from the entry
+# written by a first probe. The output must be the same, including the CPB
+# properties found by the video decoder.
+tests/data/stream_info_cache.mov: TAG = GEN
+tests/data/stream_info_cache.mov: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
+	-f lavfi -i "testsrc2=d=1:s=176x144" -f lavfi -i "sine=d=1" \
+	-c:v mpeg2video -maxrate 2M -bufsize 1M -c:a pcm_s16le -threads 1 -dct fastint -idct simple \
+	-flags +bitexact -fflags +bitexact -y $(TARGET_PATH)/$@ 2>/dev/null
+
+FATE_STREAM_INFO_CACHE = fate-ffprobe-stream-info-cache fate-ffprobe-stream-info-cache-warm
+FATE_FFPROBE-$(call ALLYES, MOV_MUXER MOV_DEMUXER MPEG2VIDEO_ENCODER MPEG2VIDEO_DECODER PCM_S16LE_ENCODER TESTSRC2_FILTER SINE_FILTER LAVFI_INDEV) += $(FATE_STREAM_INFO_CACHE)
+$(FATE_STREAM_INFO_CACHE): tests/data/stream_info_cache.mov
+fate-ffprobe-stream-info-cache: CMD = stream_info_cache $(TARGET_PATH)/tests/data/stream_info_cache.mov
+fate-ffprobe-stream-info-cache-warm: CMD = stream_info_cache $(TARGET_PATH)/tests/data/stream_info_cache.mov warm
+fate-ffprobe-stream-info-cache-warm: REF = $(SRC_PATH)/tests/ref/fate/ffprobe-stream-info-cache
+
+# Probe an input with four streams decoding them serially and with a thread
+# each. The threaded probe must find the same stream parameters.
+tests/data/probe_threads.nut: TAG = GEN
+tests/data/probe_threads.nut: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
+	-f lavfi -i "testsrc2=d=1:s=176x144" -f lavfi -i "testsrc2=d=1:s=160x120" \
+	-f lavfi -i "sine=d=1" -f lavfi -i "sine=d=1:f=880" -map 0 -map 1 -map 2 -map 3 \
+	-c:v mpeg2video -c:a mp2 -threads 1 -dct fastint -idct simple \
+	-flags +bitexact -fflags +bitexact -y $(TARGET_PATH)/$@ 2>/dev/null
+
+FATE_FFPROBE_THREADS-yes += fate-ffprobe-probe-threads-serial
+FATE_FFPROBE_THREADS-$(HAVE_THREADS) += fate-ffprobe-probe-threads
+FATE_FFPROBE-$(call ALLYES, NUT_MUXER NUT_DEMUXER MPEG2VIDEO_ENCODER MPEG2VIDEO_DECODER MP2_ENCODER MP2_DECODER TESTSRC2_FILTER SINE_FILTER LAVFI_INDEV) += $(FATE_FFPROBE_THREADS-yes)
+$(FATE_FFPROBE_THREADS-yes): tests/data/probe_threads.nut
+fate-ffprobe-probe-threads-serial: CMD = probe_threads $(TARGET_PATH)/tests/data/probe_threads.nut 1
+fate-ffprobe-probe-threads: CMD = probe_threads $(TARGET_PATH)/tests/data/probe_threads.nut 4
+fate-ffprobe-probe-threads: REF = $(SRC_PATH)/tests/ref/fate/ffprobe-probe-threads-serial
+
 FATE_FFPROBE-$(HAVE_XMLLINT) += $(FATE_FFPROBE_SCHEMA-yes)
 FATE_FFPROBE += $(FATE_FFPROBE-yes)
 
@@ -112,6 +112,36 @@ fate-filter-yuvtestsrc-yuv444p: CMD = framecrc -lavfi yuvtestsrc=rate=5:duration
 FATE_FILTER-$(call FILTERFRAMECRC, YUVTESTSRC SCALE) += fate-filter-yuvtestsrc-yuv444p12
 fate-filter-yuvtestsrc-yuv444p12: CMD = framecrc -lavfi yuvtestsrc=rate=5:duration=1,format=yuv444p12,scale -pix_fmt yuv444p12le
 
+FATE_FILTER_SCALE_AREA = $(foreach S, 2x 4x, $(addprefix fate-filter-scale-area-$(S), -tv -pc -tv-threads -pc-threads))
+FATE_FILTER-$(call FILTERFRAMECRC, TESTSRC2 FORMAT SCALE) += $(FATE_FILTER_SCALE_AREA)
+fate-filter-scale-area-2x%: SIZE = 176:144
+fate-filter-scale-area-4x%: SIZE = 88:72
+fate-filter-scale-area-%-tv fate-filter-scale-area-%-tv-threads: RANGE = :in_range=tv:out_range=tv
+fate-filter-scale-area-%-pc fate-filter-scale-area-%-pc-threads: RANGE = :in_range=tv:out_range=pc
+fate-filter-scale-area-%-threads: SCALE_THREADS = :threads=4
+$(FATE_FILTER_SCALE_AREA): CMD = framecrc -lavfi testsrc2=s=352x288:rate=5:duration=1,format=yuv420p,scale=$(SIZE):flags=area:box_downscale=1$(RANGE)$(SCALE_THREADS)
+
+FATE_FILTER_GRAPH_THREADS = fate-filter-graph-threads fate-filter-graph-threads-graph
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER FORMAT_FILTER SPLIT_FILTER HFLIP_FILTER \
+                           VFLIP_FILTER AVGBLUR_FILTER NEGATE_FILTER SINE_FILTER   \
+                           VOLUME_FILTER) += $(FATE_FILTER_GRAPH_THREADS)
+$(FATE_FILTER_GRAPH_THREADS): libavfilter/tests/graphthreads$(EXESUF)
+fate-filter-graph-threads: THREAD_TYPE = slice 1
+fate-filter-graph-threads-graph: THREAD_TYPE = graph 4
+fate-filter-graph-threads-graph: REF = $(SRC_PATH)/tests/ref/fate/filter-graph-threads
+$(FATE_FILTER_GRAPH_THREADS): CMD = run libavfilter/tests/graphthreads$(EXESUF) $(THREAD_TYPE) \
+    "testsrc2=s=160x120:r=10:d=2,format=yuv420p,split=3[a][b][c];[a]hflip;[b]vflip,avgblur=2;[c]negate;sine=d=2,volume=0.5"
+
+FATE_FILTER_GRAPH_THREADS_SENDCMD = fate-filter-graph-threads-sendcmd fate-filter-graph-threads-sendcmd-graph
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER FORMAT_FILTER SPLIT_FILTER HFLIP_FILTER \
+                           NEGATE_FILTER SENDCMD_FILTER SINE_FILTER VOLUME_FILTER) += $(FATE_FILTER_GRAPH_THREADS_SENDCMD)
+$(FATE_FILTER_GRAPH_THREADS_SENDCMD): libavfilter/tests/graphthreads$(EXESUF)
+fate-filter-graph-threads-sendcmd: THREAD_TYPE = slice 1
+fate-filter-graph-threads-sendcmd-graph: THREAD_TYPE = graph 4
+fate-filter-graph-threads-sendcmd-graph: REF = $(SRC_PATH)/tests/ref/fate/filter-graph-threads-sendcmd
+$(FATE_FILTER_GRAPH_THREADS_SENDCMD): CMD = run libavfilter/tests/graphthreads$(EXESUF) $(THREAD_TYPE) \
+    "testsrc2=s=160x120:r=10:d=2,format=yuv420p,split=2[a][b];[a]sendcmd=c=0.5 negate@n components y\;1.0 volume@v volume 0.25,hflip;[b]negate@n;sine=d=2,volume@v=0.5"
+
 FATE_FILTER-$(call FILTERFRAMECRC, TESTSRC FORMAT CONCAT SCALE, LAVFI_INDEV FILE_PROTOCOL) += fate-filter-lavd-scalenorm
 fate-filter-lavd-scalenorm: tests/data/filtergraphs/scalenorm
 fate-filter-lavd-scalenorm: CMD = framecrc -f lavfi -graph_file $(TARGET_PATH)/tests/data/filtergraphs/scalenorm -i dummy
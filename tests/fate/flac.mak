@@ -32,5 +32,16 @@ fate-flac-%: FUZZ = 0
 
 FATE_FLAC-$(call ENCMUX, FLAC, FLAC) += $(FATE_FLAC)
 
+# Encode 8 channels on one and on 4 threads, the subframes are searched per
+# channel and the output must not depend on the number of threads.
+FATE_FLAC_THREADS = fate-flac-8ch-encode fate-flac-8ch-encode-threads
+$(FATE_FLAC_THREADS): tests/data/asynth-44100-8.wav
+fate-flac-8ch-encode:         CMD = framecrc -i $(TARGET_PATH)/tests/data/asynth-44100-8.wav -c:a flac -compression_level 8 -threads 1
+fate-flac-8ch-encode-threads: CMD = framecrc -i $(TARGET_PATH)/tests/data/asynth-44100-8.wav -c:a flac -compression_level 8 -threads 4
+fate-flac-8ch-encode-threads: REF = $(SRC_PATH)/tests/ref/fate/flac-8ch-encode
+
+FATE_FLAC_THREADS-$(call ALLYES, WAV_DEMUXER PCM_S16LE_DECODER FLAC_ENCODER FRAMECRC_MUXER) += $(FATE_FLAC_THREADS)
+
 FATE_SAMPLES_AVCONV += $(FATE_FLAC-yes)
-fate-flac: $(FATE_FLAC)
+FATE_FFMPEG += $(FATE_FLAC_THREADS-yes)
+fate-flac: $(FATE_FLAC) $(FATE_FLAC_THREADS-yes)
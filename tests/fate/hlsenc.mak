@@ -109,6 +109,33 @@ FATE_HLSENC_PROBE-$(call ALLYES, HLS_DEMUXER EAC3_DEMUXER) += fate-hls-fmp4_ac3
 fate-hls-fmp4_ac3: tests/data/hls_fmp4_ac3.m3u8
 fate-hls-fmp4_ac3: CMD = probeaudiostream $(TARGET_PATH)/tests/data/now_ac3.mp4
 
+# Mux two variants with a master playlist without and with async_io, the
+# playlists and segments must be identical
+HLS_ASYNC_IO = muxdir out_%v.m3u8 \
+    -f lavfi -i "aevalsrc=cos(2*PI*t)*sin(2*PI*(440+4*t)*t):d=20" -map 0 -map 0 -codec:a mp2fixed \
+    -flags +bitexact -fflags +bitexact -f hls -hls_time 3 -hls_list_size 0 -async_io $(1) \
+    -master_pl_name master.m3u8 -var_stream_map "a:0 a:1"
+
+FATE_HLSENC_ASYNC_IO-$(call ALLYES, HLS_MUXER MPEGTS_MUXER AEVALSRC_FILTER LAVFI_INDEV MP2FIXED_ENCODER) += fate-hls-sync-io fate-hls-async-io
+fate-hls-sync-io: CMD = $(call HLS_ASYNC_IO,0)
+fate-hls-async-io: CMD = $(call HLS_ASYNC_IO,1)
+fate-hls-async-io: REF = $(SRC_PATH)/tests/ref/fate/hls-sync-io
+
+# Same for dash, with old segments deleted. The HLS playlists of dash contain
+# the wall clock time, so they are not written.
+DASH_ASYNC_IO = muxdir out.mpd \
+    -f lavfi -i "aevalsrc=cos(2*PI*t)*sin(2*PI*(440+4*t)*t):d=20" -map 0 -codec:a pcm_s16le \
+    -flags +bitexact -fflags +bitexact -f dash -seg_duration 3 -window_size 3 -extra_window_size 1 \
+    -async_io $(1)
+
+FATE_HLSENC_ASYNC_IO-$(call ALLYES, DASH_MUXER MP4_MUXER AEVALSRC_FILTER LAVFI_INDEV PCM_S16LE_ENCODER) += fate-dash-sync-io fate-dash-async-io
+fate-dash-sync-io: CMD = $(call DASH_ASYNC_IO,0)
+fate-dash-async-io: CMD = $(call DASH_ASYNC_IO,1)
+fate-dash-async-io: REF = $(SRC_PATH)/tests/ref/fate/dash-sync-io
+
+FATE_FFMPEG += $(FATE_HLSENC_ASYNC_IO-yes)
+fate-hlsenc: $(FATE_HLSENC_ASYNC_IO-yes)
+
 FATE_SAMPLES_FFMPEG += $(FATE_HLSENC-yes)
 FATE_SAMPLES_FFMPEG_FFPROBE += $(FATE_HLSENC_PROBE-yes)
 fate-hlsenc: $(FATE_HLSENC-yes) $(FATE_HLSENC_PROBE-yes)
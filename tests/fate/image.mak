@@ -334,6 +334,10 @@ fate-exr: $(FATE_EXR-yes)
 FATE_JPG-$(call DEMDEC, IMAGE2, MJPEG, SCALE_FILTER) += fate-jpg-12bpp
 fate-jpg-12bpp: CMD = framecrc -idct simple -i $(TARGET_SAMPLES)/jpg/12bpp.jpg -f rawvideo -pix_fmt gray16le -vf setsar=sar=sar,scale
 
+# without probing, the bit depth is only known to the thread decoding the first frame
+FATE_JPG-$(call DEMDEC, IMAGE2, MJPEG, SCALE_FILTER) += fate-jpg-12bpp-frame-threads
+fate-jpg-12bpp-frame-threads: CMD = framecrc -threads 2 -thread_type frame -idct simple -nofind_stream_info -loop 1 -i $(TARGET_SAMPLES)/jpg/12bpp.jpg -map 0:v -frames:v 4 -f rawvideo -pix_fmt gray16le -vf setsar=sar=sar,scale
+
 FATE_JPG += fate-jpg-jfif
 fate-jpg-jfif: CMD = framecrc -idct simple -i $(TARGET_SAMPLES)/jpg/20242.jpg
 
@@ -343,6 +347,9 @@ fate-jpg-rgb-baseline: CMD = framecrc -idct simple -i $(TARGET_SAMPLES)/jpg/geor
 FATE_JPG += fate-jpg-rgb-progressive
 fate-jpg-rgb-progressive: CMD = framecrc -idct simple -i $(TARGET_SAMPLES)/jpg/george-insect-rgb-progressive.jpg
 
+FATE_JPG += fate-jpg-rgb-progressive-frame-threads
+fate-jpg-rgb-progressive-frame-threads: CMD = framecrc -threads 2 -thread_type frame -idct simple -loop 1 -i $(TARGET_SAMPLES)/jpg/george-insect-rgb-progressive.jpg -frames:v 4
+
 FATE_JPG += fate-jpg-rgb-221
 fate-jpg-rgb-221: CMD = framecrc -idct simple -i $(TARGET_SAMPLES)/jpg/george-insect-rgb-xyb.jpg
 
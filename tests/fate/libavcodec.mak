@@ -108,5 +108,10 @@ FATE_LIBAVCODEC-yes += fate-libavcodec-htmlsubtitles
 fate-libavcodec-htmlsubtitles: libavcodec/tests/htmlsubtitles$(EXESUF)
 fate-libavcodec-htmlsubtitles: CMD = run libavcodec/tests/htmlsubtitles$(EXESUF)
 
+FATE_LIBAVCODEC-$(CONFIG_HUFFYUV_ENCODER) += fate-libavcodec-thread-pool
+fate-libavcodec-thread-pool: libavcodec/tests/thread_pool$(EXESUF)
+fate-libavcodec-thread-pool: CMD = run libavcodec/tests/thread_pool$(EXESUF)
+fate-libavcodec-thread-pool: CMP = null
+
 FATE-$(CONFIG_AVCODEC) += $(FATE_LIBAVCODEC-yes)
 fate-libavcodec: $(FATE_LIBAVCODEC-yes)
@@ -6,6 +6,11 @@ FATE_LIBAVFORMAT-$(CONFIG_NETWORK) += fate-noproxy
 fate-noproxy: libavformat/tests/noproxy$(EXESUF)
 fate-noproxy: CMD = run libavformat/tests/noproxy$(EXESUF)
 
+FATE_HLS_PREFETCH-$(HAVE_THREADS) += fate-hls-prefetch
+FATE_LIBAVFORMAT-$(call ALLYES, HLS_DEMUXER HTTP_PROTOCOL WAV_DEMUXER) += $(FATE_HLS_PREFETCH-yes)
+fate-hls-prefetch: libavformat/tests/hls_prefetch$(EXESUF)
+fate-hls-prefetch: CMD = run libavformat/tests/hls_prefetch$(EXESUF)
+
 FATE_LIBAVFORMAT-$(CONFIG_FFRTMPCRYPT_PROTOCOL) += fate-rtmpdh
 fate-rtmpdh: libavformat/tests/rtmpdh$(EXESUF)
 fate-rtmpdh: CMD = run libavformat/tests/rtmpdh$(EXESUF)
@@ -18,6 +23,10 @@ FATE_LIBAVFORMAT-yes += fate-url
 fate-url: libavformat/tests/url$(EXESUF)
 fate-url: CMD = run libavformat/tests/url$(EXESUF)
 
+FATE_LIBAVFORMAT-$(CONFIG_LIBURING_PROTOCOL) += fate-liburing
+fate-liburing: libavformat/tests/liburing$(EXESUF)
+fate-liburing: CMD = run libavformat/tests/liburing$(EXESUF) $(TARGET_PATH)/tests/data/fate/liburing.tmp
+
 FATE_LIBAVFORMAT-$(CONFIG_MOV_MUXER) += fate-movenc
 fate-movenc: libavformat/tests/movenc$(EXESUF)
 fate-movenc: CMD = run libavformat/tests/movenc$(EXESUF)
@@ -1085,6 +1085,16 @@ $(call CROSS_TEST,$(SAMPLERATES_LITE),ARESAMPLE_EXACT_LIN_ASYNC,dblp,f64le,s16)
 FATE_SWR_RESAMPLE-$(call FILTERDEMDEC, ARESAMPLE ASETPTS ATRIM SINE, , PCM_S16LE, LAVFI_INDEV) += fate-swr-async-firstpts
 fate-swr-async-firstpts: CMD = framecrc -auto_conversion_filters -copyts -f lavfi -i "sine=r=1000:samples_per_frame=100,asetpts=PTS+S+S*floor(ld(1)/4)+st(1\,ld(1)+1)*0,atrim=end=2" -filter:a aresample=async=300:first_pts=0
 
+# Resample 16 channels in the calling thread and on 4 threads, the output
+# must not depend on the number of threads.
+FATE_SWR_THREADS = fate-swr-resample-16ch fate-swr-resample-16ch-threads
+$(FATE_SWR_THREADS): tests/data/asynth-44100-12.wav tests/data/asynth-44100-4.wav
+fate-swr-resample-16ch: CMD = framecrc -i $(TARGET_PATH)/tests/data/asynth-44100-12.wav -i $(TARGET_PATH)/tests/data/asynth-44100-4.wav -filter_complex "amerge=inputs=2,atrim=end_sample=44100,aresample=48000:internal_sample_fmt=fltp"
+fate-swr-resample-16ch-threads: CMD = framecrc -i $(TARGET_PATH)/tests/data/asynth-44100-12.wav -i $(TARGET_PATH)/tests/data/asynth-44100-4.wav -filter_complex "amerge=inputs=2,atrim=end_sample=44100,aresample=48000:internal_sample_fmt=fltp:threads=4"
+fate-swr-resample-16ch-threads: REF = $(SRC_PATH)/tests/ref/fate/swr-resample-16ch
+
+FATE_SWR_RESAMPLE-$(call FILTERDEMDECENCMUX, AMERGE ATRIM ARESAMPLE, WAV, PCM_S16LE, PCM_S16LE, FRAMECRC) += $(FATE_SWR_THREADS)
+
 FATE_SWR_RESAMPLE-$(call FILTERDEMDECENCMUX, ARESAMPLE, WAV, PCM_S16LE, PCM_S16LE, WAV) += $(FATE_SWR_RESAMPLE)
 fate-swr-resample: $(FATE_SWR_RESAMPLE-yes)
 FATE_SWR += $(FATE_SWR_RESAMPLE-yes)
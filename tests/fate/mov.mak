@@ -201,6 +201,16 @@ FATE_MOV_FFMPEG-$(call TRANSCODE, PCM_S16LE, MOV, WAV_DEMUXER PAN_FILTER) \
 fate-mov-channel-description: tests/data/asynth-44100-1.wav tests/data/filtergraphs/mov-channel-description
 fate-mov-channel-description: CMD = transcode wav $(TARGET_PATH)/tests/data/asynth-44100-1.wav mov "-/filter_complex $(TARGET_PATH)/tests/data/filtergraphs/mov-channel-description -map [outFL] -map [outFR] -map [outFC] -map [outLFE] -map [outBL] -map [outBR] -map [outDL] -map [outDR] -c:a pcm_s16le" "-map 0 -c copy -frames:a 0"
 
+# Test writing the moov atom into the space reserved by faststart_reserve,
+# once with the estimated size and once with a too small moov_size, which
+# moves the mdat by 1 MiB
+FATE_MOV_FFMPEG-$(call TRANSCODE, PCM_S16LE, MOV, WAV_DEMUXER) \
+                          += fate-mov-faststart-reserve \
+                             fate-mov-faststart-reserve-small
+fate-mov-faststart-reserve fate-mov-faststart-reserve-small: tests/data/asynth-44100-1.wav
+fate-mov-faststart-reserve: CMD = transcode wav $(TARGET_PATH)/tests/data/asynth-44100-1.wav mp4 "-c:a pcm_s16le -movflags +faststart -faststart_reserve 1" "-c copy"
+fate-mov-faststart-reserve-small: CMD = transcode wav $(TARGET_PATH)/tests/data/asynth-44100-1.wav mp4 "-c:a pcm_s16le -movflags +faststart -faststart_reserve 1 -moov_size 64" "-c copy"
+
 # Test PCM in mp4 and channel layout
 FATE_MOV_FFMPEG-$(call TRANSCODE, PCM_S16LE, MOV, WAV_DEMUXER PAN_FILTER) \
                           += fate-mov-mp4-pcm
@@ -257,6 +267,94 @@ fate-mov-mp4-iamf-ambisonic_1: CMD = transcode wav $(SRC) mp4 "-auto_conversion_
   -streamid 0:0 -streamid 1:1 -streamid 2:2 -streamid 3:3 -map [MONO0] -map [MONO1] -map [MONO2] -map [MONO3] -c:a flac -t 1" "-c:a copy -map 0" \
   "-show_entries stream_group=index,id,nb_streams,type:stream_group_components:stream_group_disposition:stream_group_tags:stream_group_stream=index,id:stream_group_stream_disposition"
 
+# Probe a file with B-frames without and with an edit list, with and without
+# lazy_index. Both the stream properties set while reading the header and the
+# packets must not depend on when the index is built.
+tests/data/mov_lazy_index_%.mp4: TAG = GEN
+tests/data/mov_lazy_index_%.mp4: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
+	-f lavfi -i "testsrc2=d=2:s=176x144:r=25" -f lavfi -i "sine=d=2" \
+	-c:v mpeg4 -bf 2 -c:a mp2 -threads 1 -dct fastint -idct simple -use_editlist $* \
+	-flags +bitexact -fflags +bitexact -y $(TARGET_PATH)/$@ 2>/dev/null
+
+MOV_INDEX_PROBE = run ffprobe$(PROGSSUF)$(EXESUF) -v error -bitexact -of compact
+MOV_INDEX_PACKETS = packet=stream_index,pts,dts,duration,size,pos,flags
+MOV_LAZY_INDEX = $(MOV_INDEX_PROBE) -lazy_index $(1) -nofind_stream_info -show_streams -show_format \
+                 -print_filename $(notdir $(2)) $(2) && \
+                 $(MOV_INDEX_PROBE) -lazy_index $(1) -show_streams -show_format -show_entries $(MOV_INDEX_PACKETS) \
+                 -print_filename $(notdir $(2)) $(2)
+
+FATE_MOV_LAZY_INDEX = fate-mov-index-bframes fate-mov-lazy-index-bframes \
+                      fate-mov-index-editlist fate-mov-lazy-index-editlist
+fate-mov-index-bframes fate-mov-lazy-index-bframes: tests/data/mov_lazy_index_0.mp4
+fate-mov-index-editlist fate-mov-lazy-index-editlist: tests/data/mov_lazy_index_1.mp4
+fate-mov-index-bframes: CMD = $(call MOV_LAZY_INDEX, 0, $(TARGET_PATH)/tests/data/mov_lazy_index_0.mp4)
+fate-mov-lazy-index-bframes: CMD = $(call MOV_LAZY_INDEX, 1, $(TARGET_PATH)/tests/data/mov_lazy_index_0.mp4)
+fate-mov-lazy-index-bframes: REF = $(SRC_PATH)/tests/ref/fate/mov-index-bframes
+fate-mov-index-editlist: CMD = $(call MOV_LAZY_INDEX, 0, $(TARGET_PATH)/tests/data/mov_lazy_index_1.mp4)
+fate-mov-lazy-index-editlist: CMD = $(call MOV_LAZY_INDEX, 1, $(TARGET_PATH)/tests/data/mov_lazy_index_1.mp4)
+fate-mov-lazy-index-editlist: REF = $(SRC_PATH)/tests/ref/fate/mov-index-editlist
+
+# Seeking must find the same packets when the index is only built up to the
+# seek target, and for the edit list with and without advanced_editlist.
+FATE_MOV_LAZY_INDEX += fate-mov-index-seek-bframes fate-mov-lazy-index-seek-bframes \
+                       fate-mov-index-seek-editlist fate-mov-lazy-index-seek-editlist \
+                       fate-mov-index-seek-editlist-basic fate-mov-lazy-index-seek-editlist-basic
+fate-mov-index-seek-bframes fate-mov-lazy-index-seek-bframes: tests/data/mov_lazy_index_0.mp4 libavformat/tests/seek$(EXESUF)
+fate-mov-index-seek-editlist fate-mov-lazy-index-seek-editlist: tests/data/mov_lazy_index_1.mp4 libavformat/tests/seek$(EXESUF)
+fate-mov-index-seek-editlist-basic fate-mov-lazy-index-seek-editlist-basic: tests/data/mov_lazy_index_1.mp4 libavformat/tests/seek$(EXESUF)
+fate-mov-index-seek-bframes: CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_PATH)/tests/data/mov_lazy_index_0.mp4 -lazy_index 0
+fate-mov-lazy-index-seek-bframes: CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_PATH)/tests/data/mov_lazy_index_0.mp4 -lazy_index 1
+fate-mov-lazy-index-seek-bframes: REF = $(SRC_PATH)/tests/ref/fate/mov-index-seek-bframes
+fate-mov-index-seek-editlist: CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_PATH)/tests/data/mov_lazy_index_1.mp4 -lazy_index 0
+fate-mov-lazy-index-seek-editlist: CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_PATH)/tests/data/mov_lazy_index_1.mp4 -lazy_index 1
+fate-mov-lazy-index-seek-editlist: REF = $(SRC_PATH)/tests/ref/fate/mov-index-seek-editlist
+fate-mov-index-seek-editlist-basic: CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_PATH)/tests/data/mov_lazy_index_1.mp4 -lazy_index 0 -advanced_editlist 0
+fate-mov-lazy-index-seek-editlist-basic: CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_PATH)/tests/data/mov_lazy_index_1.mp4 -lazy_index 1 -advanced_editlist 0
+fate-mov-lazy-index-seek-editlist-basic: REF = $(SRC_PATH)/tests/ref/fate/mov-index-seek-editlist-basic
+
+FATE_MOV_FFMPEG_FFPROBE-$(call ALLYES, MOV_MUXER MOV_DEMUXER MPEG4_ENCODER MPEG4_DECODER MP2_ENCODER MP2_DECODER TESTSRC2_FILTER SINE_FILTER LAVFI_INDEV) += $(FATE_MOV_LAZY_INDEX)
+
+# Read fragmented files indexed by a mfra and by a global sidx with and
+# without lazy_frag_index. The packets, and for the mfra the results of
+# seeking, must be those of reading every fragment while opening.
+tests/data/mov_lazy_frag_mfra.mp4: MOV_LAZY_FRAG_FLAGS = +frag_keyframe
+tests/data/mov_lazy_frag_sidx.mp4: MOV_LAZY_FRAG_FLAGS = +frag_keyframe+global_sidx
+tests/data/mov_lazy_frag_%.mp4: TAG = GEN
+tests/data/mov_lazy_frag_%.mp4: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
+	-f lavfi -i "testsrc2=d=4:s=176x144:r=25" -f lavfi -i "sine=d=4" \
+	-c:v mpeg4 -g 12 -bf 2 -c:a mp2 -threads 1 -dct fastint -idct simple -movflags $(MOV_LAZY_FRAG_FLAGS) \
+	-flags +bitexact -fflags +bitexact -y $(TARGET_PATH)/$@ 2>/dev/null
+
+MOV_FRAG_INDEX = $(MOV_INDEX_PROBE) $(1) \
+                 -show_entries $(MOV_INDEX_PACKETS):stream=index,start_time,duration,duration_ts,nb_frames:format=start_time,duration $(2)
+
+FATE_MOV_LAZY_FRAG_INDEX = fate-mov-frag-index-mfra fate-mov-lazy-frag-index-mfra \
+                           fate-mov-frag-index-sidx fate-mov-lazy-frag-index-sidx \
+                           fate-mov-frag-seek-mfra fate-mov-lazy-frag-seek-mfra
+fate-mov-frag-index-mfra fate-mov-lazy-frag-index-mfra: tests/data/mov_lazy_frag_mfra.mp4
+fate-mov-frag-seek-mfra fate-mov-lazy-frag-seek-mfra: tests/data/mov_lazy_frag_mfra.mp4 libavformat/tests/seek$(EXESUF)
+fate-mov-frag-index-sidx fate-mov-lazy-frag-index-sidx: tests/data/mov_lazy_frag_sidx.mp4
+fate-mov-frag-index-mfra: CMD = $(call MOV_FRAG_INDEX, -lazy_frag_index 0, $(TARGET_PATH)/tests/data/mov_lazy_frag_mfra.mp4)
+fate-mov-lazy-frag-index-mfra: CMD = $(call MOV_FRAG_INDEX, -lazy_frag_index 1, $(TARGET_PATH)/tests/data/mov_lazy_frag_mfra.mp4)
+fate-mov-lazy-frag-index-mfra: REF = $(SRC_PATH)/tests/ref/fate/mov-frag-index-mfra
+fate-mov-frag-index-sidx: CMD = $(call MOV_FRAG_INDEX, -lazy_frag_index 0, $(TARGET_PATH)/tests/data/mov_lazy_frag_sidx.mp4)
+fate-mov-lazy-frag-index-sidx: CMD = $(call MOV_FRAG_INDEX, -lazy_frag_index 1, $(TARGET_PATH)/tests/data/mov_lazy_frag_sidx.mp4)
+fate-mov-lazy-frag-index-sidx: REF = $(SRC_PATH)/tests/ref/fate/mov-frag-index-sidx
+fate-mov-frag-seek-mfra: CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_PATH)/tests/data/mov_lazy_frag_mfra.mp4 -lazy_frag_index 0
+fate-mov-lazy-frag-seek-mfra: CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_PATH)/tests/data/mov_lazy_frag_mfra.mp4 -lazy_frag_index 1
+fate-mov-lazy-frag-seek-mfra: REF = $(SRC_PATH)/tests/ref/fate/mov-frag-seek-mfra
+
+FATE_MOV_FFMPEG_FFPROBE-$(call ALLYES, MOV_MUXER MOV_DEMUXER MPEG4_ENCODER MPEG4_DECODER MP2_ENCODER MP2_DECODER TESTSRC2_FILTER SINE_FILTER LAVFI_INDEV) += $(FATE_MOV_LAZY_FRAG_INDEX)
+
+# Timestamps from the mfra must not lose the samples of the first fragment,
+# where the mfra is read: the packets are those of fate-mov-frag-index-mfra.
+FATE_MOV_FFMPEG_FFPROBE-$(call ALLYES, MOV_MUXER MOV_DEMUXER MPEG4_ENCODER MPEG4_DECODER MP2_ENCODER MP2_DECODER TESTSRC2_FILTER SINE_FILTER LAVFI_INDEV) += fate-mov-frag-index-use-mfra-for
+fate-mov-frag-index-use-mfra-for: tests/data/mov_lazy_frag_mfra.mp4
+fate-mov-frag-index-use-mfra-for: CMD = $(MOV_INDEX_PROBE) -use_mfra_for pts -show_entries $(MOV_INDEX_PACKETS) \
+                                        $(TARGET_PATH)/tests/data/mov_lazy_frag_mfra.mp4
+
 FATE_FFMPEG += $(FATE_MOV_FFMPEG-yes)
 FATE_FFMPEG_FFPROBE += $(FATE_MOV_FFMPEG_FFPROBE-yes)
 